@@ -27,8 +27,28 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 #define AIO_PERIOD                                -HRTIME_MSECONDS(4)
+
+RecInt aio_config_queue_depth = 32;
+RecInt aio_config_write_queue_depth = 4;
+static int aio_read_queue_depth = 28;
+
+/* disks registered with ink_aio_register_disk() */
+static ink_mutex aio_disks_mutex;
+static AIODisk aio_disks[MAX_AIO_DISKS];
+static volatile int aio_n_disks = 0;
+#if AIO_MODE == AIO_MODE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "I_Tasks.h"
+
+/* buffers registered for fixed buffer I/O, see ink_aio_register_buffer() */
+static ink_mutex aio_fixed_buffers_mutex;
+static struct iovec aio_fixed_buffers[MAX_AIO_FIXED_BUFFERS];
+static int aio_n_fixed_buffers = 0;
+static volatile int aio_fixed_buffers_gen = 0;
+#endif
 #else
 
 #define MAX_DISKS_POSSIBLE 100
@@ -48,7 +68,7 @@ static ink_mutex insert_mutex;
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk = 12;
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 
 RecRawStatBlock *aio_rsb = NULL;
 Continuation *aio_err_callbck = 0;
@@ -159,7 +179,17 @@ ink_aio_init(ModuleVersion v)
   RecRegisterRawStat(aio_rsb, RECT_PROCESS,
                      "proxy.process.cache.KB_write_per_sec",
                      RECD_FLOAT, RECP_NULL, (int) AIO_STAT_KB_WRITE_PER_SEC, aio_stats_cb);
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+  ink_mutex_init(&aio_disks_mutex, NULL);
+  REC_ReadConfigInteger(aio_config_queue_depth, "proxy.config.cache.aio_queue_depth");
+  REC_ReadConfigInteger(aio_config_write_queue_depth, "proxy.config.cache.aio_write_queue_depth");
+  aio_read_queue_depth = (int) (aio_config_queue_depth - aio_config_write_queue_depth);
+  if (aio_read_queue_depth < 1)
+    aio_read_queue_depth = 1;
+#if AIO_MODE == AIO_MODE_IO_URING
+  ink_mutex_init(&aio_fixed_buffers_mutex, NULL);
+#endif
+#else
   memset(&aio_reqs, 0, MAX_DISKS_POSSIBLE * sizeof(AIO_Reqs *));
   ink_mutex_init(&insert_mutex, NULL);
 
@@ -177,7 +207,152 @@ ink_aio_start()
   return 0;
 }
 
-#if  AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+
+/*
+ * Per disk queue depth and latency, shared by native AIO and io_uring
+ */
+
+// Upper bounds of the latency histogram buckets, the last bucket is open.
+static const int aio_latency_msec[] = { 5, 10, 20, 50, 100, 200, 500, 1000 };
+#define AIO_LATENCY_BUCKETS ((int) countof(aio_latency_msec) + 1)
+
+void
+ink_aio_register_disk(int fd, const char *path)
+{
+  char name[128];
+
+  ink_mutex_acquire(&aio_disks_mutex);
+  int n = aio_n_disks;
+  if (n < MAX_AIO_DISKS) {
+    AIODisk *d = &aio_disks[n];
+    d->fd = fd;
+    d->reads_in_flight = d->writes_in_flight = 0;
+    d->rsb = RecAllocateRawStatBlock(2 * AIO_LATENCY_BUCKETS);
+    for (int i = 0; i < 2 * AIO_LATENCY_BUCKETS; i++) {
+      const char *op = i < AIO_LATENCY_BUCKETS ? "read" : "write";
+      int b = i % AIO_LATENCY_BUCKETS;
+      if (b < AIO_LATENCY_BUCKETS - 1)
+        snprintf(name, sizeof(name), "proxy.process.cache.disk.%d.%s_latency.le_%dms", n, op, aio_latency_msec[b]);
+      else
+        snprintf(name, sizeof(name), "proxy.process.cache.disk.%d.%s_latency.gt_%dms", n, op, aio_latency_msec[b - 1]);
+      RecRegisterRawStat(d->rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i, RecRawStatSyncCount);
+    }
+    Debug("aio", "disk %d is %s (fd %d)", n, path, fd);
+    // lookups do not take the mutex, publish the entry last
+    INK_WRITE_MEMORY_BARRIER;
+    aio_n_disks = n + 1;
+  } else {
+    Debug("aio", "disk table full, %s will not be tracked", path);
+  }
+  ink_mutex_release(&aio_disks_mutex);
+}
+
+static AIODisk *
+aio_disk_find(int fd)
+{
+  for (int i = 0; i < aio_n_disks; i++) {
+    if (aio_disks[i].fd == fd)
+      return &aio_disks[i];
+  }
+  return NULL;
+}
+
+static inline bool
+aio_is_read(AIOCallback *op)
+{
+#if AIO_MODE == AIO_MODE_NATIVE
+  return op->aiocb.aio_lio_opcode == IO_CMD_PREAD;
+#else
+  return op->aiocb.aio_lio_opcode == LIO_READ;
+#endif
+}
+
+/* Account for a completed operation, called on the thread which submitted it. */
+static void
+aio_op_done(AIOCallback *op, ink_hrtime now)
+{
+  AIOCallbackInternal *io = (AIOCallbackInternal *) op;
+  bool read = aio_is_read(op);
+
+  if (read) {
+    aio_num_read++;
+    aio_bytes_read += op->aiocb.aio_nbytes;
+  } else {
+    aio_num_write++;
+    aio_bytes_written += op->aiocb.aio_nbytes;
+  }
+  if (io->disk) {
+    ink_atomic_increment(read ? &io->disk->reads_in_flight : &io->disk->writes_in_flight, -1);
+    int msec = (int) ink_hrtime_to_msec(now - io->submit_time);
+    int b = 0;
+    while (b < AIO_LATENCY_BUCKETS - 1 && msec > aio_latency_msec[b])
+      b++;
+    RecIncrRawStat(io->disk->rsb, this_ethread(), (read ? 0 : AIO_LATENCY_BUCKETS) + b, 1);
+  }
+}
+
+void
+AIOQueue::enqueue(AIOCallback *op)
+{
+  ((AIOCallbackInternal *) op)->disk = aio_disk_find(op->aiocb.aio_fildes);
+  if (aio_is_read(op))
+    read_list.enqueue(op);
+  else
+    write_list.enqueue(op);
+}
+
+int
+AIOQueue::dequeue(AIOCallback **ops, int max)
+{
+  Que(AIOCallback, link) *lists[2] = { &read_list, &write_list };
+  ink_hrtime now = ink_get_hrtime_internal();
+  int n = 0;
+
+  for (int i = 0; i < 2; i++) {
+    bool read = (i == 0);
+    AIOCallback *op, *next;
+    for (op = lists[i]->head; op && n < max; op = next) {
+      next = op->link.next;
+      AIOCallbackInternal *io = (AIOCallbackInternal *) op;
+      if (io->disk) {
+        // the counts are shared with other threads, so the depth may be
+        // overshot by a few operations
+        int *in_flight = (int *) (read ? &io->disk->reads_in_flight : &io->disk->writes_in_flight);
+        int depth = (int) aio_config_write_queue_depth;
+        if (read) {
+          // the write share of the depth is only held back while writes are waiting
+          depth = write_list.head ? aio_read_queue_depth : (int) aio_config_queue_depth - io->disk->writes_in_flight;
+        }
+        if (*in_flight >= depth)
+          continue;
+        ink_atomic_increment(in_flight, 1);
+      }
+      lists[i]->remove(op);
+      io->submit_time = now;
+      ops[n++] = op;
+    }
+  }
+  return n;
+}
+
+void
+AIOQueue::requeue(AIOCallback *op)
+{
+  AIOCallbackInternal *io = (AIOCallbackInternal *) op;
+  bool read = aio_is_read(op);
+
+  if (io->disk)
+    ink_atomic_increment(read ? &io->disk->reads_in_flight : &io->disk->writes_in_flight, -1);
+  if (read)
+    read_list.push(op);
+  else
+    write_list.push(op);
+}
+
+#endif // AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+
+#if AIO_MODE != AIO_MODE_NATIVE && AIO_MODE != AIO_MODE_IO_URING
 
 static void *aio_thread_main(void *arg);
 
@@ -543,7 +718,7 @@ aio_thread_main(void *arg)
   }
   return 0;
 }
-#else
+#elif AIO_MODE == AIO_MODE_NATIVE
 int
 DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e) {
   SET_HANDLER(&DiskHandler::mainAIOEvent);
@@ -555,6 +730,7 @@ DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e) {
 int
 DiskHandler::mainAIOEvent(int event, Event *e) {
   AIOCallback *op = NULL;
+  ink_hrtime now = ink_get_hrtime_internal();
 Lagain:
   int ret = io_getevents(ctx, 0, MAX_AIO_EVENTS, events, NULL);
   //printf("%d\n", ret);
@@ -562,34 +738,37 @@ Lagain:
     op = (AIOCallback *) events[i].data;
     op->aio_result = events[i].res;
     ink_assert(op->action.continuation);
+    aio_op_done(op, now);
     complete_list.enqueue(op);
     //op->handleEvent(event, e);
   }
   if (ret == MAX_AIO_EVENTS)
     goto Lagain;
   if (ret < 0)
-    perror("io_getevents");
+    Warning("io_getevents error: %s", strerror(-ret));
 
+  // Submit everything the disks have room for in one call, what the
+  // context cannot take now stays queued for the next period.
   ink_aiocb_t *cbs[MAX_AIO_EVENTS];
-  int num = 0;
-  for (; num < MAX_AIO_EVENTS && ((op = ready_list.dequeue()) != NULL); ++num) {
-    cbs[num] = &op->aiocb;
-    ink_assert(op->action.continuation);
+  AIOCallback *ops[MAX_AIO_EVENTS];
+  int num = ready_list.dequeue(ops, MAX_AIO_EVENTS);
+  for (int i = 0; i < num; i++) {
+    cbs[i] = &ops[i]->aiocb;
+    ink_assert(ops[i]->action.continuation);
   }
   if (num > 0) {
-    int ret;
-    do {
-      ret = io_submit(ctx, num, cbs);
-    } while (ret < 0 && errno == EAGAIN);
-
-    if (ret != num) {
-      if (ret < 0)
-        perror("io_submit error");
-      else {
-        fprintf(stderr, "could not sumbit IOs");
-        ink_assert(0);
-      }
-    }
+    int ret = io_submit(ctx, num, cbs);
+    if (ret < 0 && ret != -EAGAIN) {
+      // the first operation was rejected, fail it and go on with the rest
+      Warning("io_submit error: %s", strerror(-ret));
+      ops[0]->aio_result = ret;
+      aio_op_done(ops[0], now);
+      complete_list.enqueue(ops[0]);
+      ret = 1;
+    } else if (ret < 0)
+      ret = 0;
+    while (num > ret)
+      ready_list.requeue(ops[--num]);
   }
 
   while ((op = complete_list.dequeue()) != NULL) {
@@ -671,4 +850,424 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
   }
   return 1;
 }
-#endif // AIO_MODE != AIO_MODE_NATIVE
+#else // AIO_MODE == AIO_MODE_IO_URING
+
+/*
+ * io_uring
+ *
+ * Every event thread which owns a DiskHandler has its own ring. Operations
+ * are queued on the DiskHandler's ready_list by ink_aio_read() etc. and
+ * submitted to the kernel in one io_uring_enter() call per AIO_PERIOD.
+ * Completions are reaped and called back on the same thread, so there is
+ * no hop through an AIO thread.
+ */
+
+static inline unsigned
+ring_load_acquire(unsigned *p)
+{
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+ring_store_release(unsigned *p, unsigned v)
+{
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+  return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+  return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline int
+sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+  return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+int
+AIORing::init(unsigned nentries)
+{
+  struct io_uring_params p;
+
+  memset(&p, 0, sizeof(p));
+  fd = sys_io_uring_setup(nentries, &p);
+  if (fd < 0)
+    return -1;
+
+  entries = p.sq_entries;
+  cq_entries = p.cq_entries;
+  sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (cq_ring_sz > sq_ring_sz)
+      sq_ring_sz = cq_ring_sz;
+    cq_ring_sz = sq_ring_sz;
+  }
+
+  sq_ring_ptr = mmap(NULL, sq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ptr == MAP_FAILED)
+    goto Lfail;
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ptr = sq_ring_ptr;
+  } else {
+    cq_ring_ptr = mmap(NULL, cq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring_ptr == MAP_FAILED)
+      goto Lfail;
+  }
+  sqes = (struct io_uring_sqe *) mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    sqes = NULL;
+    goto Lfail;
+  }
+
+  sq_head = (unsigned *) ((char *) sq_ring_ptr + p.sq_off.head);
+  sq_tail = (unsigned *) ((char *) sq_ring_ptr + p.sq_off.tail);
+  sq_mask = (unsigned *) ((char *) sq_ring_ptr + p.sq_off.ring_mask);
+  sq_array = (unsigned *) ((char *) sq_ring_ptr + p.sq_off.array);
+  sq_local_tail = *sq_tail;
+
+  cq_head = (unsigned *) ((char *) cq_ring_ptr + p.cq_off.head);
+  cq_tail = (unsigned *) ((char *) cq_ring_ptr + p.cq_off.tail);
+  cq_mask = (unsigned *) ((char *) cq_ring_ptr + p.cq_off.ring_mask);
+  cqes = (struct io_uring_cqe *) ((char *) cq_ring_ptr + p.cq_off.cqes);
+  return 0;
+
+Lfail:
+  int err = errno;
+  destroy();
+  errno = err;
+  return -1;
+}
+
+void
+AIORing::destroy()
+{
+  if (sqes)
+    munmap(sqes, entries * sizeof(struct io_uring_sqe));
+  if (cq_ring_ptr && cq_ring_ptr != MAP_FAILED && cq_ring_ptr != sq_ring_ptr)
+    munmap(cq_ring_ptr, cq_ring_sz);
+  if (sq_ring_ptr && sq_ring_ptr != MAP_FAILED)
+    munmap(sq_ring_ptr, sq_ring_sz);
+  if (fd >= 0)
+    close(fd);
+  fd = -1;
+  sqes = NULL;
+  sq_ring_ptr = cq_ring_ptr = NULL;
+}
+
+struct io_uring_sqe *
+AIORing::get_sqe()
+{
+  if (sq_local_tail - ring_load_acquire(sq_head) >= entries)
+    return NULL;
+  unsigned idx = sq_local_tail & *sq_mask;
+  sq_array[idx] = idx;
+  ++sq_local_tail;
+  struct io_uring_sqe *sqe = &sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+/* Returns the number of entries the kernel took, which may be fewer than
+   were filled in. Without SQPOLL the kernel only consumes entries inside
+   io_uring_enter(), so the ones it left are taken back off the ring and the
+   caller has to requeue the matching operations. */
+int
+AIORing::submit()
+{
+  unsigned old_tail = *sq_tail;
+  unsigned to_submit = sq_local_tail - old_tail;
+  if (!to_submit)
+    return 0;
+  ring_store_release(sq_tail, sq_local_tail);
+  int ret;
+  do {
+    ret = sys_io_uring_enter(fd, to_submit, 0, 0);
+  } while (ret < 0 && errno == EINTR);
+  int err = errno;
+  unsigned taken = ring_load_acquire(sq_head) - old_tail;
+  if (taken < to_submit) {
+    sq_local_tail = old_tail + taken;
+    ring_store_release(sq_tail, sq_local_tail);
+  }
+  if (!taken && ret < 0) {
+    errno = err;
+    return -1;
+  }
+  return (int) taken;
+}
+
+struct io_uring_cqe *
+AIORing::peek_cqe()
+{
+  unsigned head = *cq_head;
+  if (head == ring_load_acquire(cq_tail))
+    return NULL;
+  return &cqes[head & *cq_mask];
+}
+
+void
+AIORing::cqe_seen()
+{
+  ring_store_release(cq_head, *cq_head + 1);
+}
+
+void
+ink_aio_register_buffer(void *buf, size_t len)
+{
+  ink_mutex_acquire(&aio_fixed_buffers_mutex);
+  if (aio_n_fixed_buffers < MAX_AIO_FIXED_BUFFERS) {
+    aio_fixed_buffers[aio_n_fixed_buffers].iov_base = buf;
+    aio_fixed_buffers[aio_n_fixed_buffers].iov_len = len;
+    aio_n_fixed_buffers++;
+    ink_atomic_increment((int *) &aio_fixed_buffers_gen, 1);
+  } else {
+    Debug("aio", "fixed buffer table full, %p will use regular I/O", buf);
+  }
+  ink_mutex_release(&aio_fixed_buffers_mutex);
+}
+
+void
+ink_aio_unregister_buffer(void *buf)
+{
+  ink_mutex_acquire(&aio_fixed_buffers_mutex);
+  for (int i = 0; i < aio_n_fixed_buffers; i++) {
+    if (aio_fixed_buffers[i].iov_base == buf) {
+      aio_fixed_buffers[i] = aio_fixed_buffers[--aio_n_fixed_buffers];
+      ink_atomic_increment((int *) &aio_fixed_buffers_gen, 1);
+      break;
+    }
+  }
+  ink_mutex_release(&aio_fixed_buffers_mutex);
+}
+
+/* Bring the buffers registered with this ring up to date with the global
+   table. The kernel table can only be replaced as a whole, so this is done
+   while nothing is in flight on the ring. */
+void
+DiskHandler::register_buffers()
+{
+  int gen;
+
+  if (n_fixed_buffers) {
+    sys_io_uring_register(ring.fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+    n_fixed_buffers = 0;
+  }
+  ink_mutex_acquire(&aio_fixed_buffers_mutex);
+  gen = aio_fixed_buffers_gen;
+  memcpy(fixed_buffers, aio_fixed_buffers, aio_n_fixed_buffers * sizeof(struct iovec));
+  n_fixed_buffers = aio_n_fixed_buffers;
+  ink_mutex_release(&aio_fixed_buffers_mutex);
+
+  if (n_fixed_buffers && sys_io_uring_register(ring.fd, IORING_REGISTER_BUFFERS, fixed_buffers, n_fixed_buffers) < 0) {
+    // Most likely RLIMIT_MEMLOCK, carry on without fixed buffers.
+    Warning("unable to register %d cache buffers with io_uring: %s", n_fixed_buffers, strerror(errno));
+    n_fixed_buffers = 0;
+  }
+  fixed_buffers_gen = gen;
+}
+
+int
+DiskHandler::fixed_buffer_index(void *buf, size_t len)
+{
+  for (int i = 0; i < n_fixed_buffers; i++) {
+    char *b = (char *) fixed_buffers[i].iov_base;
+    if ((char *) buf >= b && (char *) buf + len <= b + fixed_buffers[i].iov_len)
+      return i;
+  }
+  return -1;
+}
+
+/* Used when the ring could not be set up: the operation is done with a
+   blocking pread()/pwrite() on a task thread, then accounted for and
+   called back on the thread which submitted it, as the ring completions
+   are. */
+struct AIOBlockingIO: public Continuation
+{
+  AIOCallback *op;
+  EThread *thread;
+  ink_hrtime done_time;
+
+  int mainEvent(int event, Event *e);
+  int doneEvent(int event, Event *e);
+  AIOBlockingIO(AIOCallback *aop, EThread *t): Continuation(NULL), op(aop), thread(t), done_time(0)
+  {
+    SET_HANDLER(&AIOBlockingIO::mainEvent);
+  }
+};
+
+int
+AIOBlockingIO::mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */) {
+  ink_aiocb_t *a = &op->aiocb;
+  ssize_t res;
+
+  do {
+    if (a->aio_lio_opcode == LIO_READ)
+      res = pread(a->aio_fildes, (void *) a->aio_buf, a->aio_nbytes, a->aio_offset);
+    else
+      res = pwrite(a->aio_fildes, (void *) a->aio_buf, a->aio_nbytes, a->aio_offset);
+  } while (res < 0 && errno == EINTR);
+  op->aio_result = res < 0 ? -errno : res;
+  done_time = ink_get_hrtime_internal();
+  // scheduling on the task thread gave us its mutex, take the submitter's
+  mutex = thread->mutex;
+  SET_HANDLER(&AIOBlockingIO::doneEvent);
+  thread->schedule_imm_signal(this);
+  return EVENT_DONE;
+}
+
+int
+AIOBlockingIO::doneEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */) {
+  aio_op_done(op, done_time);
+  op->mutex = op->action.mutex;
+  thread->schedule_imm_local(op);
+  delete this;
+  return EVENT_DONE;
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e) {
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int event, Event *e) {
+  AIOCallback *op = NULL;
+  struct io_uring_cqe *cqe;
+  ink_hrtime now = ink_get_hrtime_internal();
+
+  if (ring.fd < 0) {
+    AIOCallback *ops[MAX_AIO_EVENTS];
+    int num = ready_list.dequeue(ops, MAX_AIO_EVENTS);
+    for (int i = 0; i < num; i++)
+      eventProcessor.schedule_imm(new AIOBlockingIO(ops[i], this_ethread()), ET_TASK);
+    return EVENT_CONT;
+  }
+
+  while ((cqe = ring.peek_cqe()) != NULL) {
+    op = (AIOCallback *) (uintptr_t) cqe->user_data;
+    op->aio_result = cqe->res;
+    ring.cqe_seen();
+    --in_flight;
+    ink_assert(op->action.continuation);
+    aio_op_done(op, now);
+    complete_list.enqueue(op);
+  }
+
+  if (in_flight == 0 && fixed_buffers_gen != aio_fixed_buffers_gen)
+    register_buffers();
+
+  // Never have more ops in flight than the completion queue can hold.
+  AIOCallback *ops[MAX_AIO_EVENTS];
+  int max = (int) ring.cq_entries - in_flight;
+  if (max > MAX_AIO_EVENTS)
+    max = MAX_AIO_EVENTS;
+  int num = ready_list.dequeue(ops, max);
+  for (int i = 0; i < num; i++) {
+    struct io_uring_sqe *sqe = ring.get_sqe();
+    if (!sqe) {
+      while (num > i)
+        ready_list.requeue(ops[--num]);
+      break;
+    }
+    op = ops[i];
+    ink_aiocb_t *a = &op->aiocb;
+    bool read = (a->aio_lio_opcode == LIO_READ);
+    int idx = fixed_buffer_index((void *) a->aio_buf, a->aio_nbytes);
+    if (idx >= 0) {
+      sqe->opcode = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+      sqe->buf_index = idx;
+    } else {
+      sqe->opcode = read ? IORING_OP_READ : IORING_OP_WRITE;
+    }
+    sqe->fd = a->aio_fildes;
+    sqe->off = a->aio_offset;
+    sqe->addr = (uintptr_t) a->aio_buf;
+    sqe->len = a->aio_nbytes;
+    sqe->user_data = (uintptr_t) op;
+  }
+  if (num > 0) {
+    int ret = ring.submit();
+    if (ret < 0) {
+      Warning("io_uring_enter error: %s", strerror(errno));
+      ret = 0;
+    } else if (ret != num)
+      Debug("aio", "io_uring took %d of %d IOs, requeueing the rest", ret, num);
+    in_flight += ret;
+    while (num > ret)
+      ready_list.requeue(ops[--num]);
+  }
+
+  while ((op = complete_list.dequeue()) != NULL) {
+    op->handleEvent(event, e);
+  }
+  return EVENT_CONT;
+}
+
+static int
+aio_uring_queue(AIOCallback *op, int opcode)
+{
+  DiskHandler *dh = this_ethread()->diskHandler;
+  AIOCallback *io = op;
+  int sz = 0;
+
+  while (io) {
+    io->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+    io->aiocb.aio_lio_opcode = opcode;
+    dh->ready_list.enqueue(io);
+    ++sz;
+    io = io->then;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op->action.continuation);
+    vec->action = op->action.continuation;
+    while (--sz >= 0) {
+      op->action = vec;
+      op = op->then;
+    }
+  }
+  return 1;
+}
+
+int
+ink_aio_read(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  op->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+  op->aiocb.aio_lio_opcode = LIO_READ;
+  this_ethread()->diskHandler->ready_list.enqueue(op);
+
+  return 1;
+}
+
+int
+ink_aio_write(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  op->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+  op->aiocb.aio_lio_opcode = LIO_WRITE;
+  this_ethread()->diskHandler->ready_list.enqueue(op);
+
+  return 1;
+}
+
+int
+ink_aio_readv(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  return aio_uring_queue(op, LIO_READ);
+}
+
+int
+ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  return aio_uring_queue(op, LIO_WRITE);
+}
+#endif // AIO_MODE == AIO_MODE_IO_URING
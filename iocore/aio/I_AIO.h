@@ -47,8 +47,11 @@
 #define AIO_MODE_SYNC            1
 #define AIO_MODE_THREAD          2
 #define AIO_MODE_NATIVE          3
+#define AIO_MODE_IO_URING        4
 
-#if TS_USE_LINUX_NATIVE_AIO
+#if TS_USE_LINUX_IO_URING
+#define AIO_MODE                 AIO_MODE_IO_URING
+#elif TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE                 AIO_MODE_NATIVE
 #else
 #define AIO_MODE                 AIO_MODE_THREAD
@@ -86,6 +89,42 @@ struct AIOVec: public Continuation
   int mainEvent(int event, Event *e);
 };
 
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+#include <linux/io_uring.h>
+
+#define MAX_AIO_EVENTS 1024
+// Upper bound on the buffers registered with each ring (see ink_aio_register_buffer).
+#define MAX_AIO_FIXED_BUFFERS 256
+
+typedef struct ink_aiocb
+{
+  int aio_fildes;
+  volatile void *aio_buf;       /* buffer location */
+  size_t aio_nbytes;            /* length of transfer */
+  off_t aio_offset;             /* file offset */
+
+  int aio_reqprio;              /* request priority offset */
+  int aio_lio_opcode;           /* listio operation */
+  int aio_state;                /* state flag for List I/O */
+  int aio__pad[1];              /* extension padding */
+} ink_aiocb_t;
+
+struct AIOVec: public Continuation
+{
+  Action action;
+  int size;
+  int completed;
+
+  AIOVec(int sz, Continuation *c): Continuation(new_ProxyMutex()), size(sz), completed(0)
+  {
+    action = c;
+    SET_HANDLER(&AIOVec::mainEvent);
+  }
+
+  int mainEvent(int event, Event *e);
+};
+
 #else
 
 typedef struct ink_aiocb
@@ -128,13 +167,53 @@ struct AIOCallback: public Continuation
   }
 };
 
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+// Upper bound on the disks registered with ink_aio_register_disk().
+#define MAX_AIO_DISKS 256
+
+/**
+  A cache disk registered with ink_aio_register_disk(). The in flight
+  counts are shared by the DiskHandlers of all threads.
+*/
+struct AIODisk
+{
+  int fd;
+  volatile int reads_in_flight;
+  volatile int writes_in_flight;
+  RecRawStatBlock *rsb;         // read and write latency histograms
+};
+
+/**
+  Operations queued by one event thread and not yet submitted.
+
+  Reads are submitted ahead of writes. An operation on a registered disk
+  stays queued while that disk has its share of
+  proxy.config.cache.aio_queue_depth in flight: writes may only use
+  proxy.config.cache.aio_write_queue_depth of it and the rest is kept for
+  reads, so a hit does not queue up in the device behind a run of
+  aggregation writes.
+*/
+struct AIOQueue
+{
+  Que(AIOCallback, link) read_list;
+  Que(AIOCallback, link) write_list;
+
+  void enqueue(AIOCallback *op);
+  /// Take up to @a max operations whose disk has room, reads first.
+  int dequeue(AIOCallback **ops, int max);
+  /// Put back an operation from dequeue() which could not be submitted.
+  /// Requeue the last one first to keep the order.
+  void requeue(AIOCallback *op);
+};
+#endif
+
 #if AIO_MODE == AIO_MODE_NATIVE
 struct DiskHandler: public Continuation
 {
   Event *trigger_event;
   io_context_t ctx;
   ink_io_event_t events[MAX_AIO_EVENTS];
-  Que(AIOCallback, link) ready_list;
+  AIOQueue ready_list;
   Que(AIOCallback, link) complete_list;
   int startAIOEvent(int event, Event *e);
   int mainAIOEvent(int event, Event *e);
@@ -147,6 +226,78 @@ struct DiskHandler: public Continuation
     }
   }
 };
+#elif AIO_MODE == AIO_MODE_IO_URING
+/**
+  A submission/completion ring pair for one event thread.
+
+  The rings are set up with the raw io_uring system calls and shared with the
+  kernel through mmap(), so no locking is needed as long as only the owning
+  thread touches them.
+*/
+struct AIORing
+{
+  int fd;
+  unsigned entries;             // number of SQ entries
+  unsigned cq_entries;          // number of CQ entries
+
+  // submission queue
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  unsigned sq_local_tail;       // SQEs filled in but not yet published
+
+  // completion queue
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+
+  void *sq_ring_ptr;
+  size_t sq_ring_sz;
+  void *cq_ring_ptr;
+  size_t cq_ring_sz;
+
+  int init(unsigned nentries);
+  void destroy();
+
+  /// Get a free submission entry, or NULL if the submission queue is full.
+  struct io_uring_sqe *get_sqe();
+  /// Publish the filled in submission entries and hand them to the kernel.
+  int submit();
+  /// Next completion entry, or NULL if there is none.
+  struct io_uring_cqe *peek_cqe();
+  /// Release the completion entry returned by peek_cqe().
+  void cqe_seen();
+
+  AIORing(): fd(-1), entries(0), cq_entries(0), sq_head(0), sq_tail(0), sq_mask(0), sq_array(0), sqes(0),
+             sq_local_tail(0), cq_head(0), cq_tail(0), cq_mask(0), cqes(0), sq_ring_ptr(0), sq_ring_sz(0),
+             cq_ring_ptr(0), cq_ring_sz(0)
+  { }
+};
+
+struct DiskHandler: public Continuation
+{
+  Event *trigger_event;
+  AIORing ring;
+  int in_flight;                // submitted but not yet completed ops
+  int fixed_buffers_gen;        // generation of the buffer table registered with the ring
+  int n_fixed_buffers;
+  struct iovec fixed_buffers[MAX_AIO_FIXED_BUFFERS];
+  AIOQueue ready_list;
+  Que(AIOCallback, link) complete_list;
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+  void register_buffers();
+  int fixed_buffer_index(void *buf, size_t len);
+  DiskHandler(): trigger_event(0), in_flight(0), fixed_buffers_gen(0), n_fixed_buffers(0) {
+    SET_HANDLER(&DiskHandler::startAIOEvent);
+    // Without a ring, mainAIOEvent() hands the I/O to the task threads.
+    if (ring.init(MAX_AIO_EVENTS) < 0)
+      Warning("unable to set up io_uring for cache disk I/O, falling back to task threads: %s", strerror(errno));
+  }
+};
 #endif
 
 void ink_aio_init(ModuleVersion version);
@@ -158,4 +309,24 @@ int ink_aio_write(AIOCallback *op, int fromAPI = 0);
 int ink_aio_readv(AIOCallback *op, int fromAPI = 0);   // fromAPI is a boolean to indicate if this is from a API call such as upload proxy feature
 int ink_aio_writev(AIOCallback *op, int fromAPI = 0);
 AIOCallback *new_AIOCallback(void);
+
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+/**
+  Register a cache disk so that its queue depth is limited and its I/O
+  latency is recorded in the proxy.process.cache.disk.N statistics, N
+  counting up in the order of registration.
+*/
+void ink_aio_register_disk(int fd, const char *path);
+#endif
+
+#if AIO_MODE == AIO_MODE_IO_URING
+/**
+  Register a long lived, page aligned buffer (e.g. Vol::agg_buffer) for
+  fixed buffer I/O. Each event thread picks up the table the next time its
+  ring is idle, and operations entirely inside a registered buffer are then
+  submitted as READ_FIXED/WRITE_FIXED which skips the per I/O page pinning.
+*/
+void ink_aio_register_buffer(void *buf, size_t len);
+void ink_aio_unregister_buffer(void *buf);
+#endif
 #endif
@@ -48,14 +48,16 @@ AIOCallback::ok()
   return (off_t) aiocb.aio_nbytes == (off_t) aio_result;
 }
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 
 extern Continuation *aio_err_callbck;
 
 struct AIOCallbackInternal: public AIOCallback
 {
+  AIODisk *disk;                // NULL if the fd was not registered
+  ink_hrtime submit_time;
   int io_complete(int event, void *data);
-  AIOCallbackInternal()
+  AIOCallbackInternal(): disk(NULL), submit_time(0)
   {
     memset ((char *) &(this->aiocb), 0, sizeof(this->aiocb));
     SET_HANDLER(&AIOCallbackInternal::io_complete);
@@ -93,7 +95,7 @@ AIOVec::mainEvent(int /* event */, Event *) {
   return EVENT_ERROR;
 }
 
-#else /* AIO_MODE != AIO_MODE_NATIVE */
+#else /* AIO_MODE != AIO_MODE_NATIVE && AIO_MODE != AIO_MODE_IO_URING */
 
 struct AIO_Reqs;
 
@@ -140,7 +142,7 @@ struct AIO_Reqs
   volatile int requests_queued;
 };
 
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 #ifdef AIO_STATS
 class AIOTestData:public Continuation
 {
@@ -79,6 +79,7 @@ int cache_config_agg_write_backlog = AGG_SIZE * 2;
 int cache_config_enable_checksum = 0;
 int cache_config_alt_rewrite_max_size = 4096;
 int cache_config_read_while_writer = 0;
+int cache_config_key_hash = 0;
 char cache_system_config_directory[PATH_NAME_MAX + 1];
 int cache_config_mutex_retry_delay = 2;
 #ifdef HTTP_CACHE
@@ -163,7 +164,7 @@ struct VolInitInfo
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 struct VolInit : public Continuation
 {
   Vol *vol;
@@ -479,6 +480,13 @@ CacheVC::set_http_info(CacheHTTPInfo *ainfo)
     f.allow_empty_doc = 0;
   alternate.copy_shallow(ainfo);
   ainfo->clear();
+  // readers collapsed on this write wait for its header to choose it,
+  // if the lock is busy they are woken by the first fragment instead
+  if (od) {
+    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (lock && od->readers.head)
+      vol->open_dir.wake_readers(od);
+  }
 }
 #endif
 
@@ -598,7 +606,7 @@ CacheProcessor::start_internal(int flags)
   verify_cache_api();
 #endif
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   int etype = ET_NET;
   int n_netthreads = eventProcessor.n_threads_for_type[etype];
   EThread **netthreads = eventProcessor.eventthread[etype];
@@ -750,7 +758,8 @@ CacheProcessor::start_internal(int flags)
         }
         off_t skip = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
         blocks = blocks - (skip >> STORE_BLOCK_SHIFT);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+        ink_aio_register_disk(fd, path);
         eventProcessor.schedule_imm(NEW(new DiskInit(gdisks[gndisks], path, blocks, skip, sector_size, fd, clear)));
 #else
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
@@ -952,6 +961,12 @@ CacheProcessor::cacheInitialized()
           case RAM_CACHE_ALGORITHM_LRU:
             gvol[i]->ram_cache = new_RamCacheLRU();
             break;
+          case RAM_CACHE_ALGORITHM_NUMA:
+            gvol[i]->ram_cache = new_RamCacheNUMA();
+            break;
+          case RAM_CACHE_ALGORITHM_CLOCK:
+            gvol[i]->ram_cache = new_RamCacheCLOCK();
+            break;
         }
       }
       // let us calculate the Size
@@ -1177,6 +1192,7 @@ vol_clear_init(Vol *d)
   d->header->cycle = 0;
   d->header->create_time = time(NULL);
   d->header->dirty = 0;
+  d->header->key_hash = cache_config_key_hash;
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
   *d->footer = *d->header;
 }
@@ -1249,6 +1265,8 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   dir = (Dir *) (raw_dir + vol_headerlen(this));
   header = (VolHeaderFooter *) raw_dir;
   footer = (VolHeaderFooter *) (raw_dir + vol_dirlen(this) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  dir_seq = (volatile uint32_t *)ats_malloc(segments * sizeof(uint32_t));
+  memset((void *)dir_seq, 0, segments * sizeof(uint32_t));
 
   if (clear) {
     Note("clearing cache directory '%s'", hash_id);
@@ -1291,7 +1309,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
     aio->thread = AIO_CALLBACK_THREAD_ANY;
     aio->then = (i < 3) ? &(init_info->vol_aio[i + 1]) : 0;
   }
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   ink_assert(ink_aio_readv(init_info->vol_aio));
 #else
   ink_assert(ink_aio_read(init_info->vol_aio));
@@ -1347,6 +1365,13 @@ Vol::handle_dir_read(int event, void *data)
     clear_dir();
     return EVENT_DONE;
   }
+  if (header->key_hash != (uint32_t) cache_config_key_hash) {
+    Warning("cache directory for '%s' was built with key hash %u, not %d, clearing", hash_id, header->key_hash,
+            cache_config_key_hash);
+    Note("clearing cache directory '%s'", hash_id);
+    clear_dir();
+    return EVENT_DONE;
+  }
   CHECK_DIR(this);
 #if TS_USE_INTERIM_CACHE == 1
   if (gn_interim_disks > 0)
@@ -1628,7 +1653,7 @@ Ldone:{
     init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
 
     SET_HANDLER(&Vol::handle_recover_write_dir);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
     ink_assert(ink_aio_writev(init_info->vol_aio));
 #else
     ink_assert(ink_aio_write(init_info->vol_aio));
@@ -2020,7 +2045,7 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */) {
             blocks = q->b->len;
 
             bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
             eventProcessor.schedule_imm(NEW(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear)));
 #else
             cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
@@ -3157,6 +3182,14 @@ ink_cache_init(ModuleVersion v)
   REC_RegisterConfigUpdateFunc("proxy.config.cache.enable_read_while_writer", update_cache_config, NULL);
   Debug("cache_init", "proxy.config.cache.enable_read_while_writer = %d", cache_config_read_while_writer);
 
+  REC_EstablishStaticConfigInt32(cache_config_key_hash, "proxy.config.cache.key_hash");
+  if (cache_config_key_hash != URL_KEY_HASH_MD5 && cache_config_key_hash != URL_KEY_HASH_MURMUR3) {
+    Warning("unknown proxy.config.cache.key_hash %d, using MD5", cache_config_key_hash);
+    cache_config_key_hash = URL_KEY_HASH_MD5;
+  }
+  url_key_hash = cache_config_key_hash;
+  Debug("cache_init", "proxy.config.cache.key_hash = %d", cache_config_key_hash);
+
   register_cache_stats(cache_rsb, "proxy.process.cache");
 
   const char *err = NULL;
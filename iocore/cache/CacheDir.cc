@@ -45,6 +45,27 @@ ProxyMutex *mutex = _m; \
 CACHE_INCREMENT_DYN_STAT(cache_directory_collision_count_stat); \
 } while (0);
 
+#define DIR_PROBE_NOLOCK_TRIES        4
+
+// Marks segment s of d as being modified for dir_probe_nolock(). Writers
+// hold the vol lock so nesting only has to be detected, not counted.
+struct DirSegmentWrite
+{
+  volatile uint32_t *seq;
+  bool outer;
+
+  DirSegmentWrite(int s, Vol *d) : seq(d->dir_seq + s), outer(!(*seq & 1))
+  {
+    if (outer)
+      ink_atomic_increment(seq, 1);
+  }
+  ~DirSegmentWrite()
+  {
+    if (outer)
+      ink_atomic_increment(seq, 1);
+  }
+};
+
 
 // Globals
 
@@ -110,8 +131,11 @@ OpenDir::signal_readers(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   while ((c = delayed_readers.dequeue())) {
     CACHE_TRY_LOCK(lock, c->mutex, t);
     if (lock) {
+      // resume the reader on its own thread, in place of its timeout
+      EThread *ct = c->trigger ? c->trigger->ethread : t;
       c->f.open_read_timeout = 0;
-      c->handleEvent(EVENT_IMMEDIATE, 0);
+      c->cancel_trigger();
+      c->trigger = ct->schedule_imm(c, EVENT_INTERVAL);
       continue;
     }
     newly_delayed_readers.push(c);
@@ -126,6 +150,38 @@ OpenDir::signal_readers(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   return 0;
 }
 
+// Called by a writer of od when it made progress.
+void
+OpenDir::wake_readers(OpenDirEntry *od)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  delayed_readers.append(od->readers);
+  od->readers.head = NULL;
+  signal_readers(0, 0);
+}
+
+// Called by a reader which timed out or is closed while waiting, before
+// the writer woke it.
+void
+OpenDir::cancel_wait(CacheVC *c)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  OpenDirEntry *od = open_read(&c->first_key);
+  CacheVC *r;
+
+  c->f.open_read_timeout = 0;
+  for (r = od ? od->readers.head : NULL; r; r = r->opendir_link.next)
+    if (r == c) {
+      od->readers.remove(c);
+      return;
+    }
+  for (r = delayed_readers.head; r; r = r->opendir_link.next)
+    if (r == c) {
+      delayed_readers.remove(c);
+      return;
+    }
+}
+
 int
 OpenDir::close_write(CacheVC *cont)
 {
@@ -203,6 +259,7 @@ dir_bucket_loop_check(Dir *start_dir, Dir *seg)
 void
 dir_init_segment(int s, Vol *d)
 {
+  DirSegmentWrite w(s, d);
   d->header->freelist[s] = 0;
   Dir *seg = dir_segment(s, d);
   int l, b;
@@ -356,6 +413,7 @@ dir_clean_bucket(Dir *b, int s, Vol *vol)
 void
 dir_clean_segment(int s, Vol *d)
 {
+  DirSegmentWrite w(s, d);
   Dir *seg = dir_segment(s, d);
   for (int64_t i = 0; i < d->buckets; i++) {
     dir_clean_bucket(dir_bucket(i, seg), s, d);
@@ -391,6 +449,7 @@ void
 clear_interim_dir(Vol *v)
 {
   for (int i = 0; i < v->segments; i++) {
+    DirSegmentWrite w(i, v);
     Dir *seg = dir_segment(i, v);
     for (int j = 0; j < v->buckets; j++) {
       interim_dir_clean_bucket(dir_bucket(j, seg), i, v);
@@ -430,6 +489,7 @@ dir_clean_bucket(Dir *b, int s, InterimCacheVol *d)
 void
 dir_clean_segment(int s, InterimCacheVol *d)
 {
+  DirSegmentWrite w(s, d->vol);
   Dir *seg = dir_segment(s, d->vol);
   for (int i = 0; i < d->vol->buckets; i++) {
     dir_clean_bucket(dir_bucket(i, seg), s, d);
@@ -449,6 +509,8 @@ clean_interimvol(InterimCacheVol *d)
 void
 dir_clear_range(off_t start, off_t end, Vol *vol)
 {
+  for (int s = 0; s < vol->segments; s++)
+    ink_atomic_increment(&vol->dir_seq[s], 1);
   for (int i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
     Dir *e = dir_index(vol, i);
     if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
@@ -457,6 +519,8 @@ dir_clear_range(off_t start, off_t end, Vol *vol)
     }
   }
   dir_clean_vol(vol);
+  for (int s = 0; s < vol->segments; s++)
+    ink_atomic_increment(&vol->dir_seq[s], 1);
 }
 
 void
@@ -474,6 +538,7 @@ check_bucket_not_contains(Dir *b, Dir *e, Dir *seg)
 void
 freelist_clean(int s, Vol *vol)
 {
+  DirSegmentWrite w(s, vol);
   dir_clean_segment(s, vol);
   if (vol->header->freelist[s])
     return;
@@ -615,6 +680,7 @@ Lagain:
 #endif
           return 1;
         } else {                // delete the invalid entry
+          DirSegmentWrite w(s, d);
           CACHE_DEC_DIR_USED(d->mutex);
           e = dir_delete_entry(e, p, s, d);
           continue;
@@ -636,12 +702,72 @@ Lagain:
   return 0;
 }
 
+/*
+  Lookup without the vol lock. Returns 0 only if no entry in the bucket
+  for key has its tag, 1 if there may be one. The entry is not validated,
+  the caller has to take the lock and use dir_probe() for that. The
+  segment is read optimistically and the read is retried if a writer
+  changed it meanwhile, see DirSegmentWrite. If result is given it gets
+  a copy of the first entry with the tag from a consistent read, or is
+  cleared if there was none.
+*/
+int
+dir_probe_nolock(CacheKey *key, Vol *d, Dir *result)
+{
+  int s = key->word(0) % d->segments;
+  int b = key->word(1) % d->buckets;
+  Dir *seg = dir_segment(s, d);
+  volatile uint32_t *seq = d->dir_seq + s;
+  unsigned int t = DIR_MASK_TAG(key->word(2));
+  int64_t entries = d->buckets * DIR_DEPTH;
+
+  if (result)
+    dir_clear(result);
+  for (int tries = 0; tries < DIR_PROBE_NOLOCK_TRIES; tries++) {
+    uint32_t v = *seq;
+    if (v & 1)
+      continue;
+    __sync_synchronize();
+    int found = 0;
+    int64_t n = 0;
+    Dir *e = dir_bucket(b, seg);
+    Dir copy;
+    dir_clear(&copy);
+    if (dir_offset(e)) {
+      for (;;) {
+        if (dir_tag(e) == t) {
+          found = 1;
+          dir_assign(&copy, e);
+          break;
+        }
+        int64_t i = dir_next(e);
+        if (!i)
+          break;
+        // a torn read can leave the chain anywhere, stay in the segment
+        if (i >= entries || ++n > entries) {
+          found = 1;
+          break;
+        }
+        e = dir_from_offset(i, seg);
+      }
+    }
+    __sync_synchronize();
+    if (*seq == v) {
+      if (result)
+        dir_assign(result, &copy);
+      return found;
+    }
+  }
+  return 1;
+}
+
 int
 dir_insert(CacheKey *key, Vol *d, Dir *to_part)
 {
   ink_assert(d->mutex->thread_holding == this_ethread());
   int s = key->word(0) % d->segments, l;
   int bi = key->word(1) % d->buckets;
+  DirSegmentWrite w(s, d);
   ink_assert(dir_approx_size(to_part) <= MAX_FRAG_SIZE + sizeofDoc);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL;
@@ -704,6 +830,7 @@ dir_overwrite(CacheKey *key, Vol *d, Dir *dir, Dir *overwrite, bool must_overwri
   ink_assert(d->mutex->thread_holding == this_ethread());
   int s = key->word(0) % d->segments, l;
   int bi = key->word(1) % d->buckets;
+  DirSegmentWrite w(s, d);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL;
   Dir *b = dir_bucket(bi, seg);
@@ -781,6 +908,7 @@ dir_delete(CacheKey *key, Vol *d, Dir *del)
   ink_assert(d->mutex->thread_holding == this_ethread());
   int s = key->word(0) % d->segments;
   int b = key->word(1) % d->buckets;
+  DirSegmentWrite w(s, d);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL, *p = NULL;
 #ifdef LOOP_CHECK_MODE
@@ -1477,6 +1605,17 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir) (RegressionTest *t, int /* atype ATS_UNUSED
   if (us)
     rprintf(t, "probe rate = %d / second\n", (int) ((newfree * (uint64_t) 1000000) / us));
 
+  // every inserted key must be visible without the lock
+  regress_rand_init(13);
+  ttime = ink_get_hrtime_internal();
+  for (i = 0; i < newfree; i++) {
+    regress_rand_CacheKey(&key);
+    if (!dir_probe_nolock(&key, d))
+      ret = REGRESSION_TEST_FAILED;
+  }
+  us = (ink_get_hrtime_internal() - ttime) / HRTIME_USECOND;
+  if (us)
+    rprintf(t, "lock free probe rate = %d / second\n", (int) ((newfree * (uint64_t) 1000000) / us));
 
   for (int c = 0; c < vol_direntries(d) * 0.75; c++) {
     regress_rand_CacheKey(&key);
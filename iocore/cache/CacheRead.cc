@@ -24,7 +24,6 @@
 #include "P_Cache.h"
 
 #ifdef HTTP_CACHE
-#include "HttpCacheSM.h"      //Added to get the scope of HttpCacheSM object.
 #endif
 
 #define READ_WHILE_WRITER 1
@@ -45,6 +44,9 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheFragType type, char *
   CacheVC *c = NULL;
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    // a certain miss does not have to wait for the lock
+    if (!lock && !dir_probe_nolock(key, vol) && !vol->open_dir.maybe_open(key))
+      goto Lmiss;
     if (!lock || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -59,6 +61,11 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheFragType type, char *
     if (!c)
       goto Lmiss;
     if (!lock) {
+#ifndef CACHE_STAT_PAGES
+      // nor does a hit in a concurrent RAM cache
+      if (vol->ram_cache->concurrent())
+        goto Lstart;
+#endif
       CONT_SCHED_LOCK_RETRY(c);
       return &c->_action;
     }
@@ -85,6 +92,12 @@ Lcallreturn:
   if (c->handleEvent(AIO_EVENT_DONE, 0) == EVENT_DONE)
     return ACTION_RESULT_DONE;
   return &c->_action;
+#ifndef CACHE_STAT_PAGES
+Lstart:
+  if (c->handleEvent(EVENT_IMMEDIATE, 0) == EVENT_DONE)
+    return ACTION_RESULT_DONE;
+  return &c->_action;
+#endif
 }
 
 #ifdef HTTP_CACHE
@@ -107,6 +120,9 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheHTTPHdr * request,
 
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    // a certain miss does not have to wait for the lock
+    if (!lock && !dir_probe_nolock(key, vol) && !vol->open_dir.maybe_open(key))
+      goto Lmiss;
     if (!lock || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
@@ -121,6 +137,11 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheHTTPHdr * request,
     }
     if (!lock) {
       SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
+#ifndef CACHE_STAT_PAGES
+      // nor does a hit in a concurrent RAM cache
+      if (vol->ram_cache->concurrent())
+        goto Lstart;
+#endif
       CONT_SCHED_LOCK_RETRY(c);
       return &c->_action;
     }
@@ -143,8 +164,6 @@ Lmiss:
   cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *) -ECACHE_NO_DOC);
   return ACTION_RESULT_DONE;
 Lwriter:
-  // this is a horrible violation of the interface and should be fixed (FIXME)
-  ((HttpCacheSM *)cont)->set_readwhilewrite_inprogress(true);
   SET_CONTINUATION_HANDLER(c, &CacheVC::openReadFromWriter);
   if (c->handleEvent(EVENT_IMMEDIATE, 0) == EVENT_DONE)
     return ACTION_RESULT_DONE;
@@ -153,6 +172,12 @@ Lcallreturn:
   if (c->handleEvent(AIO_EVENT_DONE, 0) == EVENT_DONE)
     return ACTION_RESULT_DONE;
   return &c->_action;
+#ifndef CACHE_STAT_PAGES
+Lstart:
+  if (c->handleEvent(EVENT_IMMEDIATE, 0) == EVENT_DONE)
+    return ACTION_RESULT_DONE;
+  return &c->_action;
+#endif
 }
 #endif
 
@@ -293,13 +318,15 @@ CacheVC::openReadFromWriter(int event, Event * e)
 #ifndef READ_WHILE_WRITER
   return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *) -err);
 #else
+  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  if (!lock)
+    VC_SCHED_LOCK_RETRY();
+  if (f.open_read_timeout)
+    vol->open_dir.cancel_wait(this);
   if (_action.cancelled) {
     od = NULL; // only open for read so no need to close
     return free_CacheVC(this);
   }
-  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-  if (!lock)
-    VC_SCHED_LOCK_RETRY();
   od = vol->open_read(&first_key); // recheck in case the lock failed
   if (!od) {
     MUTEX_RELEASE(lock);
@@ -320,7 +347,7 @@ CacheVC::openReadFromWriter(int event, Event * e)
       return openReadStartHead(event, e);
     } else if (ret == EVENT_CONT) {
       ink_assert(!write_vc);
-      VC_SCHED_WRITER_RETRY();
+      VC_WAIT_WRITER();
     } else
       ink_assert(write_vc);
   } else {
@@ -356,7 +383,7 @@ CacheVC::openReadFromWriter(int event, Event * e)
     DDebug("cache_read_agg",
           "%p: key: %X writer: closed:%d, fragment:%d, retry: %d",
           this, first_key.word(1), write_vc->closed, write_vc->fragment, writer_lock_retry);
-    VC_SCHED_WRITER_RETRY();
+    VC_WAIT_WRITER();
   }
 
   CACHE_TRY_LOCK(writer_lock, write_vc->mutex, mutex->thread_holding);
@@ -508,8 +535,21 @@ CacheVC::openReadClose(int event, Event * /* e ATS_UNUSED */)
     set_io_not_in_progress();
   }
   CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-  if (!lock)
+  if (!lock) {
+#ifndef CACHE_STAT_PAGES
+    // a single fragment reader left nothing in the evacuation tables,
+    // see Vol::begin_read(), so there is nothing to undo
+    if (f.single_fragment && !od && !f.open_read_timeout
+#ifdef HIT_EVACUATE
+        && !f.hit_evacuate
+#endif
+      )
+      return free_CacheVC(this);
+#endif
     VC_SCHED_LOCK_RETRY();
+  }
+  if (f.open_read_timeout)
+    vol->open_dir.cancel_wait(this);
 #ifdef HIT_EVACUATE
   if (f.hit_evacuate && dir_valid(vol, &first_dir) && closed > 0) {
     if (f.single_fragment)
@@ -537,6 +577,8 @@ CacheVC::openReadReadDone(int event, Event * e)
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
     if (!lock)
       VC_SCHED_LOCK_RETRY();
+    if (f.open_read_timeout)
+      vol->open_dir.cancel_wait(this);
     if (event == AIO_EVENT_DONE && !io.ok()) {
       dir_delete(&earliest_key, vol, &earliest_dir);
       goto Lerror;
@@ -601,7 +643,7 @@ Lread:
         goto Lerror;
       }
       DDebug("cache_read_agg", "%p: key: %X ReadRead retrying: %d", this, first_key.word(1), (int)vio.ndone);
-      VC_SCHED_WRITER_RETRY(); // wait for writer
+      VC_WAIT_WRITER();
     }
     // fall through for truncated documents
   }
@@ -742,6 +784,8 @@ Lread: {
       SET_HANDLER(&CacheVC::openReadMain);
       VC_SCHED_LOCK_RETRY();
     }
+    if (f.open_read_timeout)
+      vol->open_dir.cancel_wait(this);
     if (dir_probe(&key, vol, &dir, &last_collision)) {
       SET_HANDLER(&CacheVC::openReadReadDone);
       int ret = do_read_call(&key);
@@ -765,7 +809,7 @@ Lread: {
       }
       DDebug("cache_read_agg", "%p: key: %X ReadMain retrying: %d", this, first_key.word(1), (int)vio.ndone);
       SET_HANDLER(&CacheVC::openReadMain);
-      VC_SCHED_WRITER_RETRY();
+      VC_WAIT_WRITER();
     }
     if (is_action_tag_set("cache"))
       ink_release_assert(false);
@@ -1001,6 +1045,35 @@ Lrestart:
   This code follows CacheVC::openReadStartEarliest closely,
   if you change this you might have to change that.
 */
+// Look the head up in the RAM cache without the vol lock. Only RAM caches
+// which are safe for concurrent use qualify, and objects which may be being
+// written have to go through Vol::open_read() with the lock. With the stat
+// pages Vol::begin_read() has work to do, so every read takes the lock.
+bool
+CacheVC::openReadHeadFromRam()
+{
+#if TS_USE_INTERIM_CACHE == 1 || defined(CACHE_STAT_PAGES)
+  return false;
+#else
+  Dir result;
+
+  if (!vol->ram_cache || !vol->ram_cache->concurrent() || vol->open_dir.maybe_open(&key))
+    return false;
+  if (!dir_probe_nolock(&key, vol, &result) || dir_is_empty(&result))
+    return false;
+  int64_t o = dir_offset(&result);
+  if (!vol->ram_cache->get(&key, &buf, (uint32_t)(o >> 32), (uint32_t)o))
+    return false;
+  dir = first_dir = result;
+  doc_pos = 0;
+  read_key = &key;
+  io.aiocb.aio_nbytes = dir_approx_size(&dir);
+  io.aio_result = io.aiocb.aio_nbytes;
+  f.doc_from_ram_cache = true;
+  return true;
+#endif
+}
+
 int
 CacheVC::openReadStartHead(int event, Event * e)
 {
@@ -1012,7 +1085,9 @@ CacheVC::openReadStartHead(int event, Event * e)
     return free_CacheVC(this);
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-    if (!lock)
+    // a RAM hit can be checked without the lock, anything which needs
+    // to touch the directory or the volume retries with the lock
+    if (!lock && (buf || !openReadHeadFromRam()))
       VC_SCHED_LOCK_RETRY();
     if (!buf)
       goto Lread;
@@ -1038,6 +1113,8 @@ CacheVC::openReadStartHead(int event, Event * e)
       if (is_action_tag_set("cache")) {
         ink_release_assert(false);
       }
+      if (!lock)
+        goto Lretry;
       if (doc->magic == DOC_CORRUPT)
         Warning("Head: Doc checksum does not match for %s", key.string(tmpstring));
       else
@@ -1073,6 +1150,8 @@ CacheVC::openReadStartHead(int event, Event * e)
       if (!doc->hlen)
         goto Ldone;
       if (vector.get_handles(doc->hdr(), doc->hlen) != doc->hlen) {
+        if (!lock)
+          goto Lretry;
         if (buf) {
           Note("OpenReadHead failed for cachekey %X : vector inconsistency with %d", key.word(0), doc->hlen);
           dir_delete(&key, vol, &dir);
@@ -1094,6 +1173,8 @@ CacheVC::openReadStartHead(int event, Event * e)
         alternate_index = 0;
       alternate_tmp = vector.get(alternate_index);
       if (!alternate_tmp->valid()) {
+        if (!lock)
+          goto Lretry;
         if (buf) {
           Note("OpenReadHead failed for cachekey %X : alternate inconsistency", key.word(0));
           dir_delete(&key, vol, &dir);
@@ -1148,11 +1229,16 @@ CacheVC::openReadStartHead(int event, Event * e)
 #endif
 
     first_buf = buf;
-    vol->begin_read(this);
+#ifndef CACHE_STAT_PAGES
+    if (lock) // a no-op for single fragments without the stat pages
+#endif
+      vol->begin_read(this);
 
     goto Lsuccess;
 
   Lread:
+    if (!lock)
+      goto Lretry;
     // check for collision
     // INKqa07684 - Cache::lookup returns CACHE_EVENT_OPEN_READ_FAILED.
     // don't want to go through this BS of reading from a writer if
@@ -1188,6 +1274,10 @@ Ldone:
   return free_CacheVC(this);
 Lcallreturn:
   return handleEvent(AIO_EVENT_DONE, 0); // hopefully a tail call
+Lretry:
+  buf = NULL;
+  f.doc_from_ram_cache = false;
+  VC_SCHED_LOCK_RETRY();
 Lsuccess:
   SET_HANDLER(&CacheVC::openReadMain);
   return callcont(CACHE_EVENT_OPEN_READ);
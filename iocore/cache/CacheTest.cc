@@ -222,7 +222,6 @@ void CacheTestSM::fill_buffer() {
     k.b[0] = pos / sk;
     char *x = ((char*)&k) + o;
     buffer->write(x, l);
-    buffer->fill(l);
     avail -= l;
   }
 }
@@ -246,7 +245,6 @@ int CacheTestSM::check_buffer() {
     buffer_reader->read(&b[0], l);
     if (::memcmp(b, x, l))
       return 0;
-    buffer_reader->consume(l);
     pos += l;
     avail -= l;
   }
@@ -413,5 +411,204 @@ EXCLUSIVE_REGRESSION_TEST(cache)(RegressionTest *t, int /* atype ATS_UNUSED */,
   return;
 }
 
+#ifdef HTTP_CACHE
+// set once the writer holds the write lock, the readers poll for it
+static volatile int collapse_writer_open;
+static int collapse_read_while_writer;
+static HTTPHdr collapse_request;
+
+// One writer and several readers of an uncached object. The readers
+// collapse onto the write, and have to be woken by the writer as it sets
+// its header and writes, not by their WRITER_WAIT_TIMEOUT.
+EXCLUSIVE_REGRESSION_TEST(cache_collapsed_read)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus) {
+  if (cacheProcessor.IsCacheEnabled() != CACHE_INITIALIZED) {
+    rprintf(t, "cache not initialized");
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  EThread *thread = this_ethread();
+
+  collapse_writer_open = 0;
+  if (!collapse_request.valid())
+    collapse_request.create(HTTP_TYPE_REQUEST);
+  collapse_read_while_writer = cache_config_read_while_writer;
+  cache_config_read_while_writer = 1;
+
+  CACHE_SM(t, collapse_write_test, {
+      caches[CACHE_FRAG_TYPE_HTTP]->open_write(this, &key, (CacheHTTPInfo *) 0, 0, NULL, CACHE_FRAG_TYPE_HTTP);
+    }
+    int open_write_callout() {
+      // give the readers time to find the write before it has a header
+      collapse_writer_open = 1;
+      SET_HANDLER(&CacheTestSM__collapse_write_test::write_header);
+      timeout = eventProcessor.schedule_in(this, HRTIME_MSECONDS(100));
+      return 1;
+    }
+    int write_header(int /* event ATS_UNUSED */, void * /* e ATS_UNUSED */) {
+      HTTPHdr response;
+
+      timeout = 0;
+      SET_HANDLER(&CacheTestSM::event_handler);
+      response.create(HTTP_TYPE_RESPONSE);
+      response.status_set(HTTP_STATUS_OK);
+      info.create();
+      info.request_set(&collapse_request);
+      info.response_set(&response);
+      cache_vc->set_http_info(&info);
+      response.destroy();
+      cvio = cache_vc->do_io_write(this, nbytes, buffer_reader);
+      return EVENT_DONE;
+    });
+  collapse_write_test.expect_initial_event = CACHE_EVENT_OPEN_WRITE;
+  collapse_write_test.expect_event = VC_EVENT_WRITE_COMPLETE;
+  collapse_write_test.nbytes = 3000000;
+  rand_CacheKey(&collapse_write_test.key, thread->mutex);
+
+  CACHE_SM(t, collapse_read_test, {
+      if (!collapse_writer_open) {
+        timeout = eventProcessor.schedule_in(this, HRTIME_MSECONDS(10));
+        return;
+      }
+      caches[CACHE_FRAG_TYPE_HTTP]->open_read(this, &key, &collapse_request, &global_cache_lookup_config,
+                                              CACHE_FRAG_TYPE_HTTP, NULL, 0);
+    }
+    int open_read_callout() {
+      if (ink_get_hrtime() - start_time >= HRTIME_MSECONDS(WRITER_WAIT_TIMEOUT))
+        return -1;
+      cvio = cache_vc->do_io_read(this, nbytes, buffer);
+      return 1;
+    });
+  collapse_read_test.expect_initial_event = CACHE_EVENT_OPEN_READ;
+  collapse_read_test.expect_event = VC_EVENT_READ_COMPLETE;
+  collapse_read_test.nbytes = collapse_write_test.nbytes;
+  collapse_read_test.key = collapse_write_test.key;
+
+  CACHE_SM(t, collapse_remove_test, {
+      cache_config_read_while_writer = collapse_read_while_writer;
+      cacheProcessor.remove(this, &key, false, CACHE_FRAG_TYPE_HTTP);
+    });
+  collapse_remove_test.expect_event = CACHE_EVENT_REMOVE;
+  collapse_remove_test.key = collapse_write_test.key;
+
+  r_sequential(
+    t,
+    r_parallel(t, collapse_write_test.clone(), collapse_read_test.clone(), collapse_read_test.clone(),
+               collapse_read_test.clone(), collapse_read_test.clone(), NULL_PTR),
+    collapse_remove_test.clone(),
+    NULL_PTR
+    )->run(pstatus);
+}
+#endif
+
+// Hammers a RAM cache from a dedicated thread, optionally serialized by a
+// lock the way the Vol mutex serializes the RAM caches which are not
+// concurrent.
+struct RamCacheBench: public Continuation {
+  RamCache *cache;
+  ink_mutex *lock;
+  CacheKey *keys;
+  int nkeys;
+  int ops;
+  volatile int *done;
+
+  int run(int /* event ATS_UNUSED */, void * /* e ATS_UNUSED */) {
+    Ptr<IOBufferData> data;
+    EThread *thread = this_ethread();
+    for (int i = 0; i < ops; i++) {
+      int k = thread->generator.random() % nkeys;
+      if (lock)
+        ink_mutex_acquire(lock);
+      if (!(i % 16)) {
+        data = new_IOBufferData(BUFFER_SIZE_INDEX_4K);
+        memset(data->data(), k, 4096);
+        cache->put(&keys[k], data, 4096, false, k, 0);
+      } else if (cache->get(&keys[k], &data, k, 0) && data->data()[4095] != (char)k)
+        ink_release_assert(!"ram cache returned the wrong data");
+      if (lock)
+        ink_mutex_release(lock);
+    }
+    ink_atomic_increment(done, 1);
+    delete this;
+    return EVENT_DONE;
+  }
+
+  RamCacheBench(RamCache *acache, ink_mutex *alock, CacheKey *akeys, int ankeys, int aops, volatile int *adone)
+    : Continuation(new_ProxyMutex()), cache(acache), lock(alock), keys(akeys), nkeys(ankeys), ops(aops), done(adone) {
+    SET_HANDLER(&RamCacheBench::run);
+  }
+};
+
+static int64_t
+ram_cache_bench(RamCache *cache, bool serialize, CacheKey *keys, int nkeys)
+{
+  const int nthreads = 4;
+  const int ops = 100000;
+  volatile int done = 0;
+  ink_mutex lock;
+
+  ink_mutex_init(&lock, "RamCacheBench");
+  ink_hrtime start = ink_get_hrtime_internal();
+  for (int i = 0; i < nthreads; i++)
+    eventProcessor.spawn_thread(new RamCacheBench(cache, serialize ? &lock : NULL, keys, nkeys, ops, &done), "[RAM_CACHE_BENCH]", 0);
+  while (done < nthreads)
+    ink_thr_yield();
+  ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+  ink_mutex_destroy(&lock);
+  return (int64_t)nthreads * ops * HRTIME_SECOND / (elapsed ? elapsed : 1);
+}
+
+REGRESSION_TEST(ram_cache)(RegressionTest *t, int atype, int *pstatus) {
+  if (cacheProcessor.IsCacheEnabled() != CACHE_INITIALIZED || gnvol < 1) {
+    rprintf(t, "cache not initialized");
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  // CLFUS keeps a compressor running for each instance, it is covered by
+  // the cache test through the volume ram caches.
+  static const char *names[] = { "LRU", "NUMA", "CLOCK" };
+  RamCache *(*factory[])() = { new_RamCacheLRU, new_RamCacheNUMA, new_RamCacheCLOCK };
+  const int nkeys = 64;
+  const int64_t max_bytes = 1 << 20;
+  EThread *thread = this_ethread();
+  Vol *vol = gvol[0];
+  CacheKey keys[nkeys];
+
+  *pstatus = REGRESSION_TEST_PASSED;
+  for (int i = 0; i < nkeys; i++)
+    rand_CacheKey(&keys[i], thread->mutex);
+  for (unsigned a = 0; a < countof(names); a++) {
+    RamCache *cache = factory[a]();
+    Ptr<IOBufferData> data;
+    int hits = 0;
+
+    cache->init(max_bytes, vol);
+    for (int i = 0; i < nkeys; i++) {
+      data = new_IOBufferData(BUFFER_SIZE_INDEX_4K);
+      memset(data->data(), i, 4096);
+      cache->put(&keys[i], data, 4096, false, i, 0);
+    }
+    for (int i = 0; i < nkeys; i++) {
+      if (cache->get(&keys[i], &data, i, 0) && data->data()[4095] == (char)i)
+        hits++;
+    }
+    rprintf(t, "%s: %d of %d hits, %d bytes\n", names[a], hits, nkeys, (int)cache->size());
+    if (hits != nkeys || cache->size() <= 0 || cache->size() > max_bytes)
+      *pstatus = REGRESSION_TEST_FAILED;
+    if (!cache->fixup(&keys[0], 0, 0, nkeys, 0) || !cache->get(&keys[0], &data, nkeys, 0) ||
+        cache->get(&keys[0], &data, 0, 0)) {
+      rprintf(t, "%s: fixup failed\n", names[a]);
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+    if (cache->concurrent() && atype >= REGRESSION_TEST_NIGHTLY) { // the benchmark is too slow for every run
+      rprintf(t, "%s: %d concurrent ops/sec\n", names[a], (int)ram_cache_bench(cache, false, keys, nkeys));
+      rprintf(t, "%s: %d serialized ops/sec\n", names[a], (int)ram_cache_bench(cache, true, keys, nkeys));
+      if (cache->size() > max_bytes)
+        *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+}
+
 void force_link_CacheTest() {
 }
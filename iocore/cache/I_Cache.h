@@ -45,6 +45,8 @@
 
 #define RAM_CACHE_ALGORITHM_CLFUS        0
 #define RAM_CACHE_ALGORITHM_LRU          1
+#define RAM_CACHE_ALGORITHM_NUMA         2
+#define RAM_CACHE_ALGORITHM_CLOCK        3
 
 #define CACHE_COMPRESSION_NONE           0
 #define CACHE_COMPRESSION_FASTLZ         1
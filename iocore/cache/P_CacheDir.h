@@ -254,7 +254,7 @@ LINK_FORWARD_DECLARATION(CacheVC, opendir_link) // forward declaration
 struct OpenDirEntry
 {
   DLL<CacheVC, Link_CacheVC_opendir_link> writers;       // list of all the current writers
-  DLL<CacheVC, Link_CacheVC_opendir_link> readers;         // list of all the current readers - not used
+  DLL<CacheVC, Link_CacheVC_opendir_link> readers;         // readers waiting for the writers, see wait()
   CacheHTTPInfoVector vector;   // Vector for the http document. Each writer
                                 // maintains a pointer to this vector and
                                 // writes it down to disk.
@@ -287,7 +287,14 @@ struct OpenDir: public Continuation
   int open_write(CacheVC *c, int allow_if_writers, int max_writers);
   int close_write(CacheVC *c);
   OpenDirEntry *open_read(INK_MD5 *key);
+  // Safe without the vol lock, false if no writer can have key open.
+  bool maybe_open(INK_MD5 *key)
+  {
+    return bucket[key->word(0) % OPEN_DIR_BUCKETS].head != NULL;
+  }
   int signal_readers(int event, Event *e);
+  void wake_readers(OpenDirEntry *od);
+  void cancel_wait(CacheVC *c);
 
   OpenDir();
 };
@@ -314,6 +321,7 @@ struct CacheSync: public Continuation
 void vol_init_dir(Vol *d);
 int dir_token_probe(CacheKey *, Vol *, Dir *);
 int dir_probe(CacheKey *, Vol *, Dir *, Dir **);
+int dir_probe_nolock(CacheKey *, Vol *, Dir *result = NULL);
 int dir_insert(CacheKey *key, Vol *d, Dir *to_part);
 int dir_overwrite(CacheKey *key, Vol *d, Dir *to_part, Dir *overwrite, bool must_overwrite = true);
 int dir_delete(CacheKey *key, Vol *d, Dir *del);
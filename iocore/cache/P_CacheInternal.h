@@ -60,6 +60,8 @@ struct EvacuationBlock;
 #define AIO_SOFT_FAILURE                -100000
 // retry read from writer delay
 #define WRITER_RETRY_DELAY  HRTIME_MSECONDS(50)
+// longest wait for a writer to wake a reader, in msec
+#define WRITER_WAIT_TIMEOUT 1000
 
 #define CACHE_READY(_x) (CacheProcessor::cache_ready & (1 << (_x)))
 
@@ -110,6 +112,17 @@ struct EvacuationBlock;
     return EVENT_CONT; \
   } while (0)
 
+// Wait for a writer of first_key to write a fragment or close instead of
+// polling it. Needs the vol lock.
+#define VC_WAIT_WRITER() \
+  do { \
+    OpenDirEntry *_od = vol->open_read(&first_key); \
+    if (!_od) \
+      VC_SCHED_WRITER_RETRY(); \
+    writer_lock_retry++; \
+    return _od->wait(this, WRITER_WAIT_TIMEOUT); \
+  } while (0)
+
 
   // cache stats definitions
 enum
@@ -222,6 +235,7 @@ extern int cache_config_agg_write_backlog;
 extern int cache_config_enable_checksum;
 extern int cache_config_alt_rewrite_max_size;
 extern int cache_config_read_while_writer;
+extern int cache_config_key_hash;
 extern char cache_system_config_directory[PATH_NAME_MAX + 1];
 extern int cache_clustering_enabled;
 extern int cache_config_agg_write_backlog;
@@ -310,6 +324,7 @@ struct CacheVC: public CacheVConnection
   int openReadVecWrite(int event, Event *e);
 #endif
   int openReadStartHead(int event, Event *e);
+  bool openReadHeadFromRam();
   int openReadFromWriter(int event, Event *e);
   int openReadFromWriterMain(int event, Event *e);
   int openReadFromWriterFailure(int event, Event *);
@@ -488,7 +503,7 @@ struct CacheVC: public CacheVConnection
       unsigned int update:1;
       unsigned int remove:1;
       unsigned int remove_aborted_writers:1;
-      unsigned int open_read_timeout:1; // UNUSED
+      unsigned int open_read_timeout:1; // waiting on OpenDirEntry::readers
       unsigned int data_done:1;
       unsigned int read_from_writer_called:1;
       unsigned int not_from_ram_cache:1;        // entire object was from ram cache
@@ -93,7 +93,7 @@ struct VolHeaderFooter
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused;                // pad out to 8 byte boundary
+  uint32_t key_hash;              // URL_KEY_HASH_* the keys were made with, 0 (MD5) in older caches
   uint16_t freelist[1];
 };
 
@@ -132,6 +132,7 @@ struct EvacuationBlock
 #define MIGRATE_BUCKETS                 1021
 extern int migrate_threshold;
 extern int good_interim_disks;
+extern int cache_config_key_hash;
 
 union AccessEntry {
   uintptr_t v[2];
@@ -365,6 +366,7 @@ struct InterimCacheVol: public Continuation
     header->cycle = 0;
     header->create_time = time(NULL);
     header->dirty = 0;
+    header->key_hash = cache_config_key_hash;
     sector_size = header->sector_size = disk->hw_sector_size;
 
     agg_todo_size = 0;
@@ -392,6 +394,9 @@ struct Vol: public Continuation
 
   char *raw_dir;
   Dir *dir;
+  // Per segment change counters, odd while the segment is being modified.
+  // See dir_probe_nolock().
+  volatile uint32_t *dir_seq;
   VolHeaderFooter *header;
   VolHeaderFooter *footer;
   int segments;
@@ -542,17 +547,23 @@ struct Vol: public Continuation
 
   Vol()
     : Continuation(new_ProxyMutex()), path(NULL), fd(-1),
-      dir(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0),
+      dir(0), dir_seq(NULL), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0),
       len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), trigger(0),
       evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false),
       dir_sync_waiting(0), dir_sync_in_progress(0), writing_end_marker(0) {
     open_dir.mutex = mutex;
     agg_buffer = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
     memset(agg_buffer, 0, AGG_SIZE);
+#if AIO_MODE == AIO_MODE_IO_URING
+    ink_aio_register_buffer(agg_buffer, AGG_SIZE);
+#endif
     SET_HANDLER(&Vol::aggWrite);
   }
 
   ~Vol() {
+#if AIO_MODE == AIO_MODE_IO_URING
+    ink_aio_unregister_buffer(agg_buffer);
+#endif
     ats_memalign_free(agg_buffer);
   }
 };
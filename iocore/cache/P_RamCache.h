@@ -33,6 +33,9 @@ struct RamCache {
   virtual int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
   virtual int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
   virtual int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) = 0;
+  virtual int64_t size() const = 0;
+  // true if get() may be called without holding the Vol mutex
+  virtual bool concurrent() const { return false; }
 
   virtual void init(int64_t max_bytes, Vol *vol) = 0;
   virtual ~RamCache() {};
@@ -40,5 +43,7 @@ struct RamCache {
 
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+RamCache *new_RamCacheNUMA();
+RamCache *new_RamCacheCLOCK();
 
 #endif /* _P_RAM_CACHE_H__ */
@@ -0,0 +1,285 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+
+// Concurrent RAM cache: the keys are spread over independently locked
+// shards, each replaced by CLOCK (second chance). A hit only sets the
+// reference bit of the entry, so get() holds its shard lock for a hash
+// lookup and is safe to call without the Vol mutex. The byte budget is
+// shared, keys don't spread evenly enough over the shards to split it.
+
+#include "P_Cache.h"
+
+#define RAM_CACHE_CLOCK_SHARDS 64
+
+struct RamCacheCLOCKEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  uint32_t referenced;
+  LINK(RamCacheCLOCKEntry, clock_link);
+  LINK(RamCacheCLOCKEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+struct RamCacheCLOCKShard {
+  ink_mutex lock;
+  int64_t objects;
+  uint16_t *seen;
+  Que(RamCacheCLOCKEntry, clock_link) clock; // the hand is at the head
+  DList(RamCacheCLOCKEntry, hash_link) *bucket;
+  int nbuckets;
+  int ibuckets;
+};
+
+struct RamCacheCLOCK: public RamCache {
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+  int64_t size() const;
+  bool concurrent() const { return true; }
+
+  void init(int64_t max_bytes, Vol *vol);
+
+  // private
+  int64_t max_bytes;
+  volatile int64_t bytes;
+  RamCacheCLOCKShard shard[RAM_CACHE_CLOCK_SHARDS];
+  Vol *vol; // for stats
+
+  RamCacheCLOCKShard *get_shard(INK_MD5 *key) { return &shard[key->word(2) % RAM_CACHE_CLOCK_SHARDS]; }
+  void resize_hashtable(RamCacheCLOCKShard *s);
+  RamCacheCLOCKEntry *remove(RamCacheCLOCKShard *s, RamCacheCLOCKEntry *e);
+  void sweep(RamCacheCLOCKShard *s, RamCacheCLOCKEntry *keep);
+
+  RamCacheCLOCK(): max_bytes(0), bytes(0), vol(NULL) {
+    memset(shard, 0, sizeof(shard));
+    for (int i = 0; i < RAM_CACHE_CLOCK_SHARDS; i++)
+      ink_mutex_init(&shard[i].lock, "RamCacheCLOCK");
+  }
+};
+
+ClassAllocator<RamCacheCLOCKEntry> ramCacheCLOCKEntryAllocator("RamCacheCLOCKEntry");
+
+static const int bucket_sizes[] = {
+  127, 251, 509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139,
+  524287, 1048573, 2097143, 4194301, 8388593, 16777213, 33554393, 67108859,
+  134217689, 268435399, 536870909
+};
+
+void
+RamCacheCLOCK::resize_hashtable(RamCacheCLOCKShard *s)
+{
+  int anbuckets = bucket_sizes[s->ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t size = anbuckets * sizeof(DList(RamCacheCLOCKEntry, hash_link));
+  DList(RamCacheCLOCKEntry, hash_link) *new_bucket = (DList(RamCacheCLOCKEntry, hash_link) *)ats_malloc(size);
+  memset(new_bucket, 0, size);
+  if (s->bucket) {
+    for (int64_t i = 0; i < s->nbuckets; i++) {
+      RamCacheCLOCKEntry *e = 0;
+      while ((e = s->bucket[i].pop()))
+        new_bucket[e->key.word(3) % anbuckets].push(e);
+    }
+    ats_free(s->bucket);
+  }
+  s->bucket = new_bucket;
+  s->nbuckets = anbuckets;
+  ats_free(s->seen);
+  s->seen = NULL;
+  if (cache_config_ram_cache_use_seen_filter) {
+    size = anbuckets * sizeof(uint16_t);
+    s->seen = (uint16_t *)ats_malloc(size);
+    memset(s->seen, 0, size);
+  }
+}
+
+void
+RamCacheCLOCK::init(int64_t abytes, Vol *avol)
+{
+  vol = avol;
+  max_bytes = abytes;
+  DDebug("ram_cache", "initializing clock ram_cache %" PRId64 " bytes over %d shards", abytes, RAM_CACHE_CLOCK_SHARDS);
+  if (!max_bytes)
+    return;
+  for (int i = 0; i < RAM_CACHE_CLOCK_SHARDS; i++)
+    resize_hashtable(&shard[i]);
+}
+
+int
+RamCacheCLOCK::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  RamCacheCLOCKShard *s = get_shard(key);
+  ink_mutex_acquire(&s->lock);
+  RamCacheCLOCKEntry *e = s->bucket[key->word(3) % s->nbuckets].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+      e->referenced = 1;
+      (*ret_data) = e->data;
+      ink_mutex_release(&s->lock);
+      DDebug("ram_cache", "get %X %d %d HIT", key->word(3), auxkey1, auxkey2);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  ink_mutex_release(&s->lock);
+  DDebug("ram_cache", "get %X %d %d MISS", key->word(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+// must be called with the shard lock held
+RamCacheCLOCKEntry *
+RamCacheCLOCK::remove(RamCacheCLOCKShard *s, RamCacheCLOCKEntry *e)
+{
+  RamCacheCLOCKEntry *ret = e->hash_link.next;
+  s->bucket[e->key.word(3) % s->nbuckets].remove(e);
+  s->clock.remove(e);
+  ink_atomic_increment(&bytes, -(int64_t)e->data->block_size());
+  s->objects--;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -e->data->block_size());
+  DDebug("ram_cache", "put %X %d %d FREED", e->key.word(3), e->auxkey1, e->auxkey2);
+  e->data = NULL;
+  THREAD_FREE(e, ramCacheCLOCKEntryAllocator, this_ethread());
+  return ret;
+}
+
+// Sweep the hand of the shard until the whole cache fits, referenced
+// entries get a second chance at the tail. Must be called with the shard
+// lock held, 'keep' is never evicted.
+void
+RamCacheCLOCK::sweep(RamCacheCLOCKShard *s, RamCacheCLOCKEntry *keep)
+{
+  while (bytes > max_bytes) {
+    RamCacheCLOCKEntry *e = s->clock.head;
+    if (!e || (e == keep && !e->clock_link.next))
+      break;
+    if (e->referenced || e == keep) {
+      e->referenced = 0;
+      s->clock.remove(e);
+      s->clock.enqueue(e);
+    } else
+      remove(s, e);
+  }
+}
+
+// ignore 'copy' since we don't touch the data
+int
+RamCacheCLOCK::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes || data->block_size() > max_bytes)
+    return 0;
+  RamCacheCLOCKShard *s = get_shard(key);
+  ink_mutex_acquire(&s->lock);
+  uint32_t i = key->word(3) % s->nbuckets;
+  // the seen filter is the admission doorkeeper, one hit wonders never displace anything
+  if (s->seen) {
+    uint16_t k = key->word(3) >> 16;
+    uint16_t kk = s->seen[i];
+    s->seen[i] = k;
+    if (kk != k) {
+      ink_mutex_release(&s->lock);
+      DDebug("ram_cache", "put %X %d %d len %d UNSEEN", key->word(3), auxkey1, auxkey2, len);
+      return 0;
+    }
+  }
+  RamCacheCLOCKEntry *e = s->bucket[i].head;
+  while (e) {
+    if (e->key == *key) {
+      if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        e->referenced = 1;
+        ink_mutex_release(&s->lock);
+        return 1;
+      } else { // discard when aux keys conflict
+        e = remove(s, e);
+        continue;
+      }
+    }
+    e = e->hash_link.next;
+  }
+  e = THREAD_ALLOC(ramCacheCLOCKEntryAllocator, this_ethread());
+  e->key = *key;
+  e->auxkey1 = auxkey1;
+  e->auxkey2 = auxkey2;
+  e->referenced = 0;
+  e->data = data;
+  s->bucket[i].push(e);
+  s->clock.enqueue(e);
+  ink_atomic_increment(&bytes, (int64_t)data->block_size());
+  s->objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, data->block_size());
+  sweep(s, e);
+  DDebug("ram_cache", "put %X %d %d INSERTED", key->word(3), auxkey1, auxkey2);
+  if (s->objects > s->nbuckets) {
+    ++s->ibuckets;
+    resize_hashtable(s);
+  }
+  ink_mutex_release(&s->lock);
+  // this shard had too little to give back, take the rest from the others
+  // without ever waiting on a second shard lock
+  for (int n = 1; bytes > max_bytes && n < RAM_CACHE_CLOCK_SHARDS; n++) {
+    RamCacheCLOCKShard *o = &shard[(s - shard + n) % RAM_CACHE_CLOCK_SHARDS];
+    if (ink_mutex_try_acquire(&o->lock)) {
+      sweep(o, NULL);
+      ink_mutex_release(&o->lock);
+    }
+  }
+  return 1;
+}
+
+int
+RamCacheCLOCK::fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  RamCacheCLOCKShard *s = get_shard(key);
+  ink_mutex_acquire(&s->lock);
+  RamCacheCLOCKEntry *e = s->bucket[key->word(3) % s->nbuckets].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2) {
+      e->auxkey1 = new_auxkey1;
+      e->auxkey2 = new_auxkey2;
+      ink_mutex_release(&s->lock);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  ink_mutex_release(&s->lock);
+  return 0;
+}
+
+int64_t
+RamCacheCLOCK::size() const
+{
+  return bytes;
+}
+
+RamCache *
+new_RamCacheCLOCK()
+{
+  return new RamCacheCLOCK;
+}
@@ -0,0 +1,383 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// NUMA aware RAM cache: one LRU list per memory node sharing a single
+// hash table, so each object has exactly one owner node. Objects are
+// copied into memory bound to the node of the thread which inserts them
+// and moved to the reader's node when hit from a remote one.
+
+#include "P_Cache.h"
+
+enum RamCacheNUMA_Stats
+{
+  numa_local_hits_stat,
+  numa_remote_hits_stat,
+  numa_misses_stat,
+  numa_bytes_used_stat,
+  numa_stat_count
+};
+
+#define NUMA_STAT(_n, _s) ((_n) * numa_stat_count + (_s))
+
+// An object moves to another node after this many hits in a row from it.
+#define NUMA_MIGRATE_HITS 4
+
+static RecRawStatBlock *ram_cache_numa_rsb = NULL;
+
+static void
+register_numa_stats(int nnodes)
+{
+  static const char *names[numa_stat_count] = { "local_hits", "remote_hits", "misses", "bytes_used" };
+  char name[128];
+
+  ram_cache_numa_rsb = RecAllocateRawStatBlock(nnodes * numa_stat_count);
+  for (int n = 0; n < nnodes; n++) {
+    for (int s = 0; s < numa_stat_count; s++) {
+      snprintf(name, sizeof(name), "proxy.process.cache.ram_cache.numa.%d.%s", n, names[s]);
+      RecRegisterRawStat(ram_cache_numa_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, NUMA_STAT(n, s),
+                         RecRawStatSyncSum);
+    }
+  }
+}
+
+struct RamCacheNUMAEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  int node;
+  int reader_node; // node of the latest remote hits
+  int reader_hits; // how many remote hits in a row came from reader_node
+  LINK(RamCacheNUMAEntry, lru_link);
+  LINK(RamCacheNUMAEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+struct RamCacheNUMA: public RamCache {
+  int64_t max_bytes; // per node
+  int64_t bytes;
+  int64_t objects;
+
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+  int64_t size() const { return bytes; }
+
+  void init(int64_t max_bytes, Vol *vol);
+
+  // private
+  Vol *vol; // for stats
+  int nnodes;
+  int64_t *node_bytes;
+  Que(RamCacheNUMAEntry, lru_link) *lru;
+  uint16_t *seen;
+  DList(RamCacheNUMAEntry, hash_link) *bucket;
+  int nbuckets;
+  int ibuckets;
+#if TS_USE_HWLOC
+  hwloc_const_cpuset_t *node_cpuset;
+  int *cpu_node;
+  int ncpus;
+  hwloc_cpuset_t last_cpu;
+#endif
+
+  int current_node();
+  IOBufferData *node_copy(int n, IOBufferData *data, uint32_t len);
+  void resize_hashtable();
+  void account(int n, int64_t delta);
+  void evict(int n, RamCacheNUMAEntry *keep);
+  RamCacheNUMAEntry *remove(RamCacheNUMAEntry *e);
+
+  RamCacheNUMA(): max_bytes(0), bytes(0), objects(0), vol(NULL), nnodes(1), node_bytes(NULL), lru(NULL), seen(0),
+                  bucket(0), nbuckets(0), ibuckets(0)
+#if TS_USE_HWLOC
+    , node_cpuset(NULL), cpu_node(NULL), ncpus(0), last_cpu(NULL)
+#endif
+  { }
+};
+
+ClassAllocator<RamCacheNUMAEntry> ramCacheNUMAEntryAllocator("RamCacheNUMAEntry");
+
+static const int bucket_sizes[] = {
+  127, 251, 509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139,
+  524287, 1048573, 2097143, 4194301, 8388593, 16777213, 33554393, 67108859,
+  134217689, 268435399, 536870909
+};
+
+void
+RamCacheNUMA::resize_hashtable()
+{
+  int anbuckets = bucket_sizes[ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t s = anbuckets * sizeof(DList(RamCacheNUMAEntry, hash_link));
+  DList(RamCacheNUMAEntry, hash_link) *new_bucket = (DList(RamCacheNUMAEntry, hash_link) *)ats_malloc(s);
+  memset(new_bucket, 0, s);
+  if (bucket) {
+    for (int64_t i = 0; i < nbuckets; i++) {
+      RamCacheNUMAEntry *e = 0;
+      while ((e = bucket[i].pop()))
+        new_bucket[e->key.word(3) % anbuckets].push(e);
+    }
+    ats_free(bucket);
+  }
+  bucket = new_bucket;
+  nbuckets = anbuckets;
+  ats_free(seen);
+  seen = NULL;
+  if (cache_config_ram_cache_use_seen_filter) {
+    int size = bucket_sizes[ibuckets] * sizeof(uint16_t);
+    seen = (uint16_t *)ats_malloc(size);
+    memset(seen, 0, size);
+  }
+}
+
+void
+RamCacheNUMA::init(int64_t abytes, Vol *avol)
+{
+  vol = avol;
+#if TS_USE_HWLOC
+  hwloc_topology_t topology = ink_get_topology();
+  int n = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NODE);
+
+  if (n > 1) {
+    nnodes = n;
+    node_cpuset = (hwloc_const_cpuset_t *)ats_malloc(nnodes * sizeof(hwloc_const_cpuset_t));
+    ncpus = hwloc_bitmap_last(hwloc_topology_get_topology_cpuset(topology)) + 1;
+    cpu_node = (int *)ats_malloc(ncpus * sizeof(int));
+    memset(cpu_node, 0, ncpus * sizeof(int));
+    for (int i = 0; i < nnodes; i++) {
+      hwloc_obj_t obj = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NODE, i);
+      unsigned cpu;
+      node_cpuset[i] = obj->cpuset;
+      hwloc_bitmap_foreach_begin(cpu, obj->cpuset) {
+        if ((int)cpu < ncpus)
+          cpu_node[cpu] = i;
+      } hwloc_bitmap_foreach_end();
+    }
+    last_cpu = hwloc_bitmap_alloc();
+  }
+#endif
+  if (!ram_cache_numa_rsb)
+    register_numa_stats(nnodes);
+  DDebug("ram_cache", "initializing numa ram_cache %" PRId64 " bytes over %d nodes", abytes, nnodes);
+  max_bytes = abytes / nnodes;
+  if (!max_bytes)
+    return;
+  node_bytes = (int64_t *)ats_malloc(nnodes * sizeof(int64_t));
+  memset(node_bytes, 0, nnodes * sizeof(int64_t));
+  int64_t s = nnodes * sizeof(Que(RamCacheNUMAEntry, lru_link));
+  lru = (Que(RamCacheNUMAEntry, lru_link) *)ats_malloc(s);
+  memset(lru, 0, s);
+  resize_hashtable();
+}
+
+// Node of the CPU this thread last ran on. Only event threads bound with
+// proxy.config.exec_thread.affinity are guaranteed to stay there.
+int
+RamCacheNUMA::current_node()
+{
+#if TS_USE_HWLOC
+  if (nnodes > 1 && !hwloc_get_last_cpu_location(ink_get_topology(), last_cpu, HWLOC_CPUBIND_THREAD)) {
+    int cpu = hwloc_bitmap_first(last_cpu);
+    if (cpu >= 0 && cpu < ncpus)
+      return cpu_node[cpu];
+  }
+#endif
+  return 0;
+}
+
+// Copy of data in memory bound to node n. Binding is best effort, the
+// copy is made anyway.
+IOBufferData *
+RamCacheNUMA::node_copy(int n, IOBufferData *data, uint32_t len)
+{
+  size_t alloc_len = INK_ALIGN(len, ats_pagesize());
+  char *b = (char *)ats_memalign(ats_pagesize(), alloc_len);
+#if TS_USE_HWLOC
+  if (hwloc_set_area_membind(ink_get_topology(), b, alloc_len, node_cpuset[n], HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_MIGRATE) < 0)
+    DDebug("ram_cache", "unable to bind %zu bytes to node %d", alloc_len, n);
+#else
+  (void) n;
+#endif
+  memcpy(b, data->data(), len);
+  IOBufferData *d = new_xmalloc_IOBufferData(b, len);
+  d->_mem_type = MEMALIGNED;
+  return d;
+}
+
+// Charge delta bytes to node n.
+void
+RamCacheNUMA::account(int n, int64_t delta)
+{
+  node_bytes[n] += delta;
+  bytes += delta;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+  RecIncrRawStat(ram_cache_numa_rsb, this_ethread(), NUMA_STAT(n, numa_bytes_used_stat), delta);
+}
+
+// Evict from the cold end of node n until it fits, but never keep.
+void
+RamCacheNUMA::evict(int n, RamCacheNUMAEntry *keep)
+{
+  while (node_bytes[n] > max_bytes) {
+    RamCacheNUMAEntry *e = lru[n].head;
+    if (!e || e == keep)
+      break;
+    remove(e);
+  }
+}
+
+RamCacheNUMAEntry *
+RamCacheNUMA::remove(RamCacheNUMAEntry *e)
+{
+  RamCacheNUMAEntry *ret = e->hash_link.next;
+  uint32_t b = e->key.word(3) % nbuckets;
+  bucket[b].remove(e);
+  lru[e->node].remove(e);
+  account(e->node, -e->data->block_size());
+  DDebug("ram_cache", "put %X %d %d FREED", e->key.word(3), e->auxkey1, e->auxkey2);
+  e->data = NULL;
+  THREAD_FREE(e, ramCacheNUMAEntryAllocator, this_ethread());
+  objects--;
+  return ret;
+}
+
+int
+RamCacheNUMA::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  EThread *t = this_ethread();
+  int home = current_node();
+  uint32_t i = key->word(3) % nbuckets;
+  RamCacheNUMAEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+      int n = e->node;
+      lru[n].remove(e);
+      if (n == home)
+        e->reader_hits = 0;
+      else if (e->reader_node != home) {
+        e->reader_node = home;
+        e->reader_hits = 1;
+      } else
+        e->reader_hits++;
+      if (n != home && e->reader_hits >= NUMA_MIGRATE_HITS) {
+        // the object is mostly read from home now, move it there
+        account(n, -e->data->block_size());
+        e->data = node_copy(home, e->data, e->data->block_size());
+        e->node = home;
+        e->reader_hits = 0;
+        account(home, e->data->block_size());
+      }
+      lru[e->node].enqueue(e);
+      evict(e->node, e);
+      (*ret_data) = e->data;
+      DDebug("ram_cache", "get %X %d %d HIT node %d from %d", key->word(3), auxkey1, auxkey2, home, n);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      RecIncrRawStat(ram_cache_numa_rsb, t, NUMA_STAT(home, n != home ? numa_remote_hits_stat : numa_local_hits_stat), 1);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  DDebug("ram_cache", "get %X %d %d MISS", key->word(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  RecIncrRawStat(ram_cache_numa_rsb, t, NUMA_STAT(home, numa_misses_stat), 1);
+  return 0;
+}
+
+// 'copy' only matters on a single node, otherwise the data is always copied
+int
+RamCacheNUMA::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->word(3) % nbuckets;
+  if (cache_config_ram_cache_use_seen_filter) {
+    uint16_t k = key->word(3) >> 16;
+    uint16_t kk = seen[i];
+    seen[i] = k;
+    if ((kk != (uint16_t)k)) {
+      DDebug("ram_cache", "put %X %d %d len %d UNSEEN", key->word(3), auxkey1, auxkey2, len);
+      return 0;
+    }
+  }
+  RamCacheNUMAEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key) {
+      if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        lru[e->node].remove(e);
+        lru[e->node].enqueue(e);
+        return 1;
+      } else { // discard when aux keys conflict
+        e = remove(e);
+        continue;
+      }
+    }
+    e = e->hash_link.next;
+  }
+  int n = current_node();
+  e = THREAD_ALLOC(ramCacheNUMAEntryAllocator, this_ethread());
+  e->key = *key;
+  e->auxkey1 = auxkey1;
+  e->auxkey2 = auxkey2;
+  e->node = n;
+  e->reader_node = n;
+  e->reader_hits = 0;
+  e->data = nnodes > 1 ? node_copy(n, data, len) : data;
+  bucket[i].push(e);
+  lru[n].enqueue(e);
+  objects++;
+  account(n, e->data->block_size());
+  evict(n, NULL);
+  DDebug("ram_cache", "put %X %d %d node %d INSERTED", key->word(3), auxkey1, auxkey2, n);
+  if (objects > nbuckets) {
+    ++ibuckets;
+    resize_hashtable();
+  }
+  return 1;
+}
+
+int
+RamCacheNUMA::fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->word(3) % nbuckets;
+  RamCacheNUMAEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2) {
+      e->auxkey1 = new_auxkey1;
+      e->auxkey2 = new_auxkey2;
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  return 0;
+}
+
+RamCache *
+new_RamCacheNUMA()
+{
+  return new RamCacheNUMA;
+}
@@ -30,6 +30,48 @@
 
 #include "P_EventSystem.h"
 
+// The event loop stats are registered here rather than by the event
+// processor, whose objects are also linked into traffic_manager, which
+// has no raw stats.
+
+//
+// Work stealing counters for a thread group, proxy.process.eventloop.steals.<id>
+// and proxy.process.eventloop.steal_attempts.<id> where id is the EThread id.
+// Registering them also turns stealing on for the group. Called through
+// EventProcessor::steal_stats_hook as the groups are spawned.
+//
+static void
+register_steal_stats(EThread **threads, int n_threads)
+{
+  char name[64];
+  RecRawStatBlock *rsb = RecAllocateRawStatBlock(n_threads * 2);
+
+  for (int i = 0; i < n_threads; i++) {
+    EThread *t = threads[i];
+    snprintf(name, sizeof(name), "proxy.process.eventloop.steals.%d", t->id);
+    RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i * 2, RecRawStatSyncSum);
+    snprintf(name, sizeof(name), "proxy.process.eventloop.steal_attempts.%d", t->id);
+    RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i * 2 + 1, RecRawStatSyncSum);
+    t->steal_stat_id = i * 2;
+    t->steal_rsb = rsb;
+  }
+}
+
+//
+// Lock contention counters, summed over all event threads.
+//
+static void
+register_eventloop_stats()
+{
+  eventloop_rsb = RecAllocateRawStatBlock((int) EventLoop_Stat_Count);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.lock_retries", RECD_INT, RECP_NON_PERSISTENT,
+                     (int) eventloop_lock_retries_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.lock_waits", RECD_INT, RECP_NON_PERSISTENT,
+                     (int) eventloop_lock_waits_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(eventloop_rsb, RECT_PROCESS, "proxy.process.eventloop.lock_wakeups", RECD_INT, RECP_NON_PERSISTENT,
+                     (int) eventloop_lock_wakeups_stat, RecRawStatSyncSum);
+}
+
 void
 ink_event_system_init(ModuleVersion v)
 {
@@ -45,4 +87,6 @@ ink_event_system_init(ModuleVersion v)
   if (default_large_iobuffer_size > max_iobuffer_size)
     default_large_iobuffer_size = max_iobuffer_size;
   init_buffer_allocators();
+  register_eventloop_stats();
+  eventProcessor.steal_stats_hook = register_steal_stats;
 }
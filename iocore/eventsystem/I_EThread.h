@@ -30,6 +30,7 @@
 #include "I_PriorityEventQueue.h"
 #include "I_ProxyAllocator.h"
 #include "I_ProtectedQueue.h"
+#include "I_StealQueue.h"
 
 // TODO: This would be much nicer to have "run-time" configurable (or something),
 // perhaps based on proxy.config.stat_api.max_stats_allowed or other configs. XXX
@@ -44,6 +45,7 @@
 
 struct DiskHandler;
 struct EventIO;
+struct RecRawStatBlock;
 
 class SessionBucket;
 class Event;
@@ -269,12 +271,19 @@ public:
   ProxyAllocator sslNetVCAllocator;
   ProxyAllocator httpClientSessionAllocator;
   ProxyAllocator httpServerSessionAllocator;
-  ProxyAllocator hdrHeapAllocator;
-  ProxyAllocator strHeapAllocator;
+  // One per header heap size class (HDR_HEAP_SIZE_CLASSES in HdrHeap.h),
+  // made by the header heaps on first use.
+  ProxyAllocator *hdrHeapAllocator;
+  ProxyAllocator *strHeapAllocator;
+  // String heap sizes learned by the HTTP headers of this thread, indexed
+  // by HTTPType (HTTP.h), made on first use.
+  int *hdrStrHeapHint;
   ProxyAllocator cacheVConnectionAllocator;
   ProxyAllocator openDirEntryAllocator;
   ProxyAllocator ramCacheCLFUSEntryAllocator;
   ProxyAllocator ramCacheLRUEntryAllocator;
+  ProxyAllocator ramCacheCLOCKEntryAllocator;
+  ProxyAllocator ramCacheNUMAEntryAllocator;
   ProxyAllocator evacuationBlockAllocator;
   ProxyAllocator ioDataAllocator;
   ProxyAllocator ioAllocator;
@@ -311,6 +320,12 @@ public:
   ProtectedQueue EventQueueExternal;
   PriorityEventQueue EventQueue;
 
+  /** Migratable immediate events waiting to run, which idle threads of the
+      same type may take when work stealing is on. */
+  StealQueue EventQueueSteal;
+  RecRawStatBlock *steal_rsb;   // steal counters, set only if stealing is on
+  int steal_stat_id;
+
   EThread **ethreads_to_be_signalled;
   int n_ethreads_to_be_signalled;
 
@@ -326,6 +341,8 @@ public:
 
   void execute();
   void process_event(Event *e, int calling_code);
+  int steal_events();
+  void run_steal_queue();
   void free_event(Event *e);
   void (*signal_hook)(EThread *);
 
@@ -213,6 +213,8 @@ public:
   unsigned int immediate:1;
   unsigned int globally_allocated:1;
   unsigned int in_heap:4;
+  unsigned int migratable:1;    // immediate, no thread affinity: may be stolen
+  unsigned int lock_woken:1;    // woken by ProxyMutex::wake_waiter, not yet run
   int callback_event;
 
   ink_hrtime timeout_at;
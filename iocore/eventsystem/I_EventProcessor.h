@@ -317,6 +317,19 @@ public:
   EThread *all_dthreads[MAX_EVENT_THREADS];
   int n_dthreads;               // No. of dedicated threads
   volatile int thread_data_used;
+
+  /// Idle threads run the immediate events queued on busy threads of the
+  /// same type (proxy.config.exec_thread.work_stealing).
+  int work_stealing;
+
+  /// Registers the work stealing counters of a new thread group, which
+  /// turns stealing on for it. Set by ink_event_system_init().
+  void (*steal_stats_hook)(EThread **threads, int n_threads);
+
+  /// Events that find their continuation locked wait for the unlock
+  /// instead of retrying every DELAY_FOR_RETRY
+  /// (proxy.config.exec_thread.lock_waiters).
+  int lock_waiters;
 };
 
 extern inkcoreapi class EventProcessor eventProcessor;
@@ -38,6 +38,7 @@
 #include "I_PriorityEventQueue.h"
 #include "I_Processor.h"
 #include "I_ProtectedQueue.h"
+#include "I_StealQueue.h"
 #include "I_Thread.h"
 #include "I_VIO.h"
 #include "I_VConnection.h"
@@ -31,6 +31,7 @@
 #define THREAD_MUTEX_THREAD_HOLDING	(-1024*1024)
 
 class EThread;
+class Event;
 typedef EThread *EThreadPtr;
 typedef volatile EThreadPtr VolatileEThreadPtr;
 
@@ -88,6 +89,20 @@ public:
   
   int nthread_holding;
 
+  /**
+    Events waiting for this mutex.
+
+    With proxy.config.exec_thread.lock_waiters on, an event whose
+    continuation lock is busy is parked here instead of being retried
+    after DELAY_FOR_RETRY, and each final unlock puts the oldest one
+    back on its thread. This is a lock free stack linked through
+    Event::link, which the unlocking thread moves into the wait_head
+    list while it still holds the mutex.
+
+  */
+  Event *volatile waiters;
+  Event *wait_head, *wait_tail;
+
 #ifdef DEBUG
   ink_hrtime hold_time;
   const char *file;
@@ -105,6 +120,10 @@ public:
 #  endif                        //LOCK_CONTENTION_PROFILING
 #endif                          //DEBUG
   void free();
+  void add_waiter(Event *e);
+  Event *take_waiter();
+  void wake_waiter(Event *e);
+  void wake_next();
 
   /**
     Constructor - use new_ProxyMutex() instead.
@@ -120,6 +139,8 @@ public:
   {
     thread_holding = NULL;
     nthread_holding = 0;
+    waiters = NULL;
+    wait_head = wait_tail = NULL;
 #ifdef DEBUG
     hold_time = 0;
     file = NULL;
@@ -308,7 +329,12 @@ Mutex_unlock(ProxyMutex * m, EThread * t)
 #endif //DEBUG
       ink_assert(m->thread_holding);
       m->thread_holding = 0;
+      Event *w = (m->waiters || m->wait_head) ? m->take_waiter() : NULL;
       ink_mutex_release(&m->the_mutex);
+      if (w)
+        m->wake_waiter(w);
+      else if (m->waiters)
+        m->wake_next();
     }
   }
 }
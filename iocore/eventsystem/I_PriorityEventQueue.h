@@ -28,79 +28,69 @@
 #include "I_Event.h"
 
 
-// <5ms, 10, 20, 40, 80, 160, 320, 640, 1280, 2560, 5120
-#define N_PQ_LIST        10
-#define PQ_BUCKET_TIME(_i) (HRTIME_MSECONDS(5) << (_i))
+// Hashed hierarchical timing wheel. Level 0 has a slot for each of the
+// next 256 ticks, each level above has slots 256 times as wide, which
+// puts the last level 49 days out; anything further waits in overflow.
+// An event is placed in the slot of the tick it is due in and is spread
+// over the levels below as its slot comes around, so scheduling,
+// removing and expiring an event are all O(1).
+#define PQ_TICK          HRTIME_MSECONDS(1)
+#define PQ_LEVEL_BITS    8
+#define PQ_LEVEL_SLOTS   (1 << PQ_LEVEL_BITS)
+#define PQ_LEVEL_MASK    (PQ_LEVEL_SLOTS - 1)
+#define PQ_LEVEL_WORDS   (PQ_LEVEL_SLOTS / 64)
+#define PQ_LEVELS        4
+
+// Event::in_heap is the level the event is in, or
+#define PQ_IN_OVERFLOW   PQ_LEVELS
+#define PQ_IN_READY      (PQ_LEVELS + 1)
 
 class EThread;
 
 struct PriorityEventQueue
 {
 
-  Que(Event, link) after[N_PQ_LIST];
+  Que(Event, link) ready;
+  Que(Event, link) slots[PQ_LEVELS][PQ_LEVEL_SLOTS];
+  Que(Event, link) overflow;
+  uint64_t occupied[PQ_LEVELS][PQ_LEVEL_WORDS];
+  int64_t cur_tick;
   ink_hrtime last_check_time;
-  uint32_t last_check_buckets;
+
+  // Ticks are rounded up, events never run early
+  static int64_t tick_of(Event * e)
+  {
+    return (e->timeout_at + PQ_TICK - 1) / PQ_TICK;
+  }
 
   void enqueue(Event * e, ink_hrtime now)
   {
-    ink_hrtime t = e->timeout_at - now;
-    int i = 0;
-    // equivalent but faster
-    if (t <= PQ_BUCKET_TIME(3))
-    {
-      if (t <= PQ_BUCKET_TIME(1)) {
-        if (t <= PQ_BUCKET_TIME(0)) {
-          i = 0;
-        } else
-        {
-          i = 1;
-        }
-      } else {
-        if (t <= PQ_BUCKET_TIME(2)) {
-          i = 2;
-        } else {
-          i = 3;
-        }
-      }
-    } else {
-      if (t <= PQ_BUCKET_TIME(7)) {
-        if (t <= PQ_BUCKET_TIME(5)) {
-          if (t <= PQ_BUCKET_TIME(4)) {
-            i = 4;
-          } else {
-            i = 5;
-          }
-        } else {
-          if (t <= PQ_BUCKET_TIME(6)) {
-            i = 6;
-          } else {
-            i = 7;
-          }
-        }
-      } else {
-        if (t <= PQ_BUCKET_TIME(8)) {
-          i = 8;
-        } else {
-          i = 9;
-        }
-      }
-    }
+    (void) now;
     e->in_the_priority_queue = 1;
-    e->in_heap = i;
-    after[i].enqueue(e);
+    place(e);
   }
 
   void remove(Event * e)
   {
     ink_assert(e->in_the_priority_queue);
     e->in_the_priority_queue = 0;
-    after[e->in_heap].remove(e);
+    if (e->in_heap == PQ_IN_READY)
+      ready.remove(e);
+    else if (e->in_heap == PQ_IN_OVERFLOW)
+      overflow.remove(e);
+    else {
+      int level = e->in_heap;
+      int slot = (tick_of(e) >> (PQ_LEVEL_BITS * level)) & PQ_LEVEL_MASK;
+      slots[level][slot].remove(e);
+      if (!slots[level][slot].head)
+        occupied[level][slot >> 6] &= ~((uint64_t) 1 << (slot & 63));
+    }
   }
 
   Event *dequeue_ready(ink_hrtime t)
   {
     (void) t;
-    Event *e = after[0].dequeue();
+    Event *e = ready.dequeue();
     if (e) {
       ink_assert(e->in_the_priority_queue);
       e->in_the_priority_queue = 0;
@@ -110,16 +100,36 @@ struct PriorityEventQueue
 
   void check_ready(ink_hrtime now, EThread * t);
 
-  ink_hrtime earliest_timeout()
+  ink_hrtime earliest_timeout();
+
+  PriorityEventQueue();
+
+private:
+  void place(Event * e)
   {
-    for (int i = 0; i < N_PQ_LIST; i++) {
-      if (after[i].head)
-        return last_check_time + (PQ_BUCKET_TIME(i) / 2);
+    int64_t tick = tick_of(e);
+    int64_t delta = tick - cur_tick;
+    int level = 0;
+
+    if (delta <= 0) {
+      e->in_heap = PQ_IN_READY;
+      ready.enqueue(e);
+      return;
     }
-    return last_check_time + HRTIME_FOREVER;
+    while (level < PQ_LEVELS && delta >= ((int64_t) 1 << (PQ_LEVEL_BITS * (level + 1))))
+      level++;
+    if (level == PQ_LEVELS) {
+      e->in_heap = PQ_IN_OVERFLOW;
+      overflow.enqueue(e);
+      return;
+    }
+    int slot = (tick >> (PQ_LEVEL_BITS * level)) & PQ_LEVEL_MASK;
+    e->in_heap = level;
+    slots[level][slot].enqueue(e);
+    occupied[level][slot >> 6] |= (uint64_t) 1 << (slot & 63);
   }
 
-  PriorityEventQueue();
+  void cascade(Que(Event, link) & q, EThread * t);
 };
 
 #endif
@@ -0,0 +1,57 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/****************************************************************************
+
+  Steal Queue, a bounded FIFO of immediate events with the following
+  functionality:
+  (1). Only the owning EThread adds events, at the bottom.
+  (2). The owner and any idle EThread of the same type take events from
+       the top, the oldest first. Takers race with a compare and swap on
+       the top index, so no lock is needed on either side.
+  (3). When the queue is full the owner simply runs the event itself.
+
+
+ ****************************************************************************/
+#ifndef _I_StealQueue_h_
+#define _I_StealQueue_h_
+
+#include "libts.h"
+#include "I_Event.h"
+
+#define STEAL_QUEUE_SIZE 256    // must be a power of 2
+
+struct StealQueue
+{
+  bool push(Event * e);         // owner thread only
+  Event *take();                // any thread
+  bool empty();
+
+  volatile int64_t top;
+  volatile int64_t bottom;
+  Event *volatile ring[STEAL_QUEUE_SIZE];
+
+  StealQueue();
+};
+
+#endif
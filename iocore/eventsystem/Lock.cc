@@ -81,6 +81,65 @@ lock_taken(const char *file, int line, const char *handler)
 #endif
 }
 
+void
+ProxyMutex::add_waiter(Event *e)
+{
+  Event *head;
+
+  do {
+    head = waiters;
+    e->link.next = head;
+  } while (!ink_atomic_cas(&waiters, head, e));
+}
+
+// Called with the lock held, before the final unlock releases it. Moves
+// the newly parked events, newest first on the stack, to the tail of the
+// wait list and takes the oldest waiter off its head.
+Event *
+ProxyMutex::take_waiter()
+{
+  Event *e = ink_atomic_swap(&waiters, (Event *) NULL);
+  Event *fifo = NULL, *last = e;
+
+  while (e) {
+    Event *next = e->link.next;
+    e->link.next = fifo;
+    fifo = e;
+    e = next;
+  }
+  if (fifo) {
+    if (wait_tail)
+      wait_tail->link.next = fifo;
+    else
+      wait_head = fifo;
+    wait_tail = last;
+  }
+  if ((e = wait_head)) {
+    if (!(wait_head = e->link.next))
+      wait_tail = NULL;
+    e->link.next = NULL;
+  }
+  return e;
+}
+
+// Called after the lock is released. Only the oldest waiter is woken,
+// its own unlock wakes the next one. If it is cancelled before it gets
+// the lock, whoever frees it calls wake_next() instead.
+void
+ProxyMutex::wake_waiter(Event *e)
+{
+  e->lock_woken = 1;
+  e->ethread->EventQueueExternal.enqueue(e);
+}
+
+// Taking and dropping the lock wakes the next waiter. If the lock is
+// busy, its holder's unlock does.
+void
+ProxyMutex::wake_next()
+{
+  MUTEX_TRY_LOCK(lock, this, this_ethread());
+}
+
 #ifdef LOCK_CONTENTION_PROFILING
 void
 ProxyMutex::print_lock_stats(int flag)
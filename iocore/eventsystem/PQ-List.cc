@@ -26,38 +26,101 @@
 PriorityEventQueue::PriorityEventQueue()
 {
   last_check_time = ink_get_based_hrtime_internal();
-  last_check_buckets = last_check_time / PQ_BUCKET_TIME(0);
+  cur_tick = last_check_time / PQ_TICK;
+  memset(occupied, 0, sizeof(occupied));
+}
+
+// Place the events of a slot that has come around again, dropping the
+// cancelled ones on the way
+void
+PriorityEventQueue::cascade(Que(Event, link) & q, EThread * t)
+{
+  Que(Event, link) l = q;
+  Event *e;
+
+  q.clear();
+  while ((e = l.dequeue()) != NULL) {
+    if (e->cancelled) {
+      e->in_the_priority_queue = 0;
+      e->cancelled = 0;
+      if (e->lock_woken)
+        e->mutex->wake_next();
+      EVENT_FREE(e, eventAllocator, t);
+    } else
+      place(e);
+  }
 }
 
 void
 PriorityEventQueue::check_ready(ink_hrtime now, EThread * t)
 {
-  int i, j, k = 0;
-  uint32_t check_buckets = (uint32_t) (now / PQ_BUCKET_TIME(0));
-  uint32_t todo_buckets = check_buckets ^ last_check_buckets;
+  int64_t now_tick = now / PQ_TICK;
+  Event *e;
+
   last_check_time = now;
-  last_check_buckets = check_buckets;
-  todo_buckets &= ((1 << (N_PQ_LIST - 1)) - 1);
-  while (todo_buckets) {
-    k++;
-    todo_buckets >>= 1;
-  }
-  for (i = 1; i <= k; i++) {
-    Event *e;
-    Que(Event, link) q = after[i];
-    after[i].clear();
-    while ((e = q.dequeue()) != NULL) {
-      if (e->cancelled) {
-        e->in_the_priority_queue = 0;
-        e->cancelled = 0;
-        EVENT_FREE(e, eventAllocator, t);
-      } else {
-        ink_hrtime tt = e->timeout_at - now;
-        for (j = i; j > 0 && tt <= PQ_BUCKET_TIME(j - 1);)
-          j--;
-        e->in_heap = j;
-        after[j].enqueue(e);
+  while (cur_tick < now_tick) {
+    ++cur_tick;
+    if (!(cur_tick & PQ_LEVEL_MASK)) {
+      for (int level = PQ_LEVELS - 1; level > 0; level--) {
+        int shift = PQ_LEVEL_BITS * level;
+        if (cur_tick & (((int64_t) 1 << shift) - 1))
+          continue;
+        if (level == PQ_LEVELS - 1 && overflow.head)
+          cascade(overflow, t);
+        int slot = (cur_tick >> shift) & PQ_LEVEL_MASK;
+        if (occupied[level][slot >> 6] & ((uint64_t) 1 << (slot & 63))) {
+          occupied[level][slot >> 6] &= ~((uint64_t) 1 << (slot & 63));
+          cascade(slots[level][slot], t);
+        }
       }
     }
+    int slot = cur_tick & PQ_LEVEL_MASK;
+    if (occupied[0][slot >> 6] & ((uint64_t) 1 << (slot & 63))) {
+      occupied[0][slot >> 6] &= ~((uint64_t) 1 << (slot & 63));
+      while ((e = slots[0][slot].dequeue()) != NULL) {
+        e->in_heap = PQ_IN_READY;
+        ready.enqueue(e);
+      }
+    }
+  }
+}
+
+// Distance in slots from the given slot to the next occupied one in a
+// level, 0 if there is none
+static inline int
+pq_next_occupied(const uint64_t *bits, int from)
+{
+  int start = (from + 1) & PQ_LEVEL_MASK;
+  int w = start >> 6;
+  uint64_t word = bits[w] & (~(uint64_t) 0 << (start & 63));
+
+  for (int i = 0; i <= PQ_LEVEL_WORDS; i++) {
+    if (word) {
+      int slot = (w << 6) + __builtin_ctzll(word);
+      // the slot just cascaded holds events a whole turn away
+      return slot == from ? PQ_LEVEL_SLOTS : (slot - from) & PQ_LEVEL_MASK;
+    }
+    w = (w + 1) % PQ_LEVEL_WORDS;
+    word = bits[w];
+  }
+  return 0;
+}
+
+ink_hrtime
+PriorityEventQueue::earliest_timeout()
+{
+  ink_hrtime next = last_check_time + HRTIME_FOREVER;
+
+  if (ready.head)
+    return last_check_time;
+  for (int level = 0; level < PQ_LEVELS; level++) {
+    int shift = PQ_LEVEL_BITS * level;
+    int d = pq_next_occupied(occupied[level], (cur_tick >> shift) & PQ_LEVEL_MASK);
+    if (d) {
+      ink_hrtime at = (((cur_tick >> shift) + d) << shift) * PQ_TICK;
+      if (at < next)
+        next = at;
+    }
   }
+  return next;
 }
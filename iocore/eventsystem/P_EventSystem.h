@@ -43,6 +43,7 @@
 #include "P_UnixEvent.h"
 #include "P_UnixEThread.h"
 #include "P_ProtectedQueue.h"
+#include "P_StealQueue.h"
 #include "P_UnixEventProcessor.h"
 #include "P_UnixSocketManager.h"
 #undef  EVENT_SYSTEM_MODULE_VERSION
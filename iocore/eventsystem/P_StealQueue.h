@@ -0,0 +1,78 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/****************************************************************************
+
+  Steal Queue
+
+
+ ****************************************************************************/
+#ifndef _P_StealQueue_h_
+#define _P_StealQueue_h_
+
+#include "I_EventSystem.h"
+
+
+TS_INLINE
+StealQueue::StealQueue():top(0), bottom(0)
+{
+  memset((void *) ring, 0, sizeof(ring));
+}
+
+TS_INLINE bool
+StealQueue::empty()
+{
+  return top >= bottom;
+}
+
+// Called from the owning thread only.
+TS_INLINE bool
+StealQueue::push(Event * e)
+{
+  int64_t b = bottom;
+
+  if (b - top >= STEAL_QUEUE_SIZE)
+    return false;
+  ring[b & (STEAL_QUEUE_SIZE - 1)] = e;
+  // the event must be visible before the slot is
+  INK_WRITE_MEMORY_BARRIER;
+  bottom = b + 1;
+  return true;
+}
+
+// A slot is only rewritten by the owner once top has moved past it, so a
+// taker that read a stale slot always loses the race on top.
+TS_INLINE Event *
+StealQueue::take()
+{
+  for (;;) {
+    int64_t t = top;
+    if (t >= bottom)
+      return NULL;
+    Event *e = ring[t & (STEAL_QUEUE_SIZE - 1)];
+    if (ink_atomic_cas(&top, t, t + 1))
+      return e;
+  }
+}
+
+#endif
@@ -36,6 +36,16 @@
 
 const int DELAY_FOR_RETRY = HRTIME_MSECONDS(10);
 
+enum EventLoop_Stats
+{
+  eventloop_lock_retries_stat,
+  eventloop_lock_waits_stat,
+  eventloop_lock_wakeups_stat,
+  EventLoop_Stat_Count
+};
+
+extern RecRawStatBlock *eventloop_rsb;
+
 TS_INLINE Event *
 EThread::schedule_spawn(Continuation * cont)
 {
@@ -92,6 +102,7 @@ TS_INLINE Event *
 EThread::schedule(Event * e, bool fast_signal)
 {
   e->ethread = this;
+  e->migratable = false;
   ink_assert(tt == REGULAR);
   if (e->continuation->mutex)
     e->mutex = e->continuation->mutex;
@@ -166,6 +177,8 @@ TS_INLINE void
 EThread::free_event(Event * e)
 {
   ink_assert(!e->in_the_priority_queue && !e->in_the_prot_queue);
+  if (e->lock_woken)
+    e->mutex->wake_next();
   e->mutex = NULL;
   EVENT_FREE(e, eventAllocator, this);
 }
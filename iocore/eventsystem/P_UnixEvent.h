@@ -31,6 +31,8 @@ Event::init(Continuation * c, ink_hrtime atimeout_at, ink_hrtime aperiod)
   timeout_at = atimeout_at;
   period = aperiod;
   immediate = !period && !atimeout_at;
+  migratable = false;
+  lock_woken = false;
   cancelled = false;
   return this;
 }
@@ -38,6 +40,8 @@ Event::init(Continuation * c, ink_hrtime atimeout_at, ink_hrtime aperiod)
 TS_INLINE void
 Event::free()
 {
+  if (lock_woken)
+    mutex->wake_next();
   mutex = NULL;
   eventAllocator.free(this);
 }
@@ -50,6 +54,8 @@ Event::Event():
   immediate(false),
   globally_allocated(true),
   in_heap(false),
+  migratable(false),
+  lock_woken(false),
   timeout_at(0),
   period(0)
 {
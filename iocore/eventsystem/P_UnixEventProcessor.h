@@ -33,7 +33,10 @@ EventProcessor::EventProcessor():
 n_ethreads(0),
 n_thread_groups(0),
 n_dthreads(0),
-thread_data_used(0)
+thread_data_used(0),
+work_stealing(0),
+steal_stats_hook(NULL),
+lock_waiters(0)
 {
   memset(all_ethreads, 0, sizeof(all_ethreads));
   memset(all_dthreads, 0, sizeof(all_dthreads));
@@ -76,6 +79,9 @@ EventProcessor::schedule(Event * e, EventType etype, bool fast_signal)
 {
   ink_assert(etype < MAX_EVENT_TYPES);
   e->ethread = assign_thread(etype);
+  // Only a continuation with its own mutex is free to run on any thread of
+  // the type, otherwise it is bound to the mutex of the thread picked here.
+  e->migratable = e->immediate && e->continuation->mutex;
   if (e->continuation->mutex)
     e->mutex = e->continuation->mutex;
   else
@@ -162,6 +162,8 @@ ProtectedQueue::dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool slee
     if (!e->cancelled)
       localQueue.enqueue(e);
     else {
+      if (e->lock_woken)
+        e->mutex->wake_next();
       e->mutex = NULL;
       eventAllocator.free(e);
     }
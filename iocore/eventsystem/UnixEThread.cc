@@ -38,11 +38,14 @@ struct AIOCallback;
 #define NO_HEARTBEAT                  	-1
 #define THREAD_MAX_HEARTBEAT_MSECONDS	60
 #define NO_ETHREAD_ID                   -1
+#define MAX_STEALS_PER_LOOP             16
 
 EThread::EThread()
   : generator((uint64_t)ink_get_hrtime_internal() ^ (uint64_t)(uintptr_t)this),
+   hdrHeapAllocator(NULL), strHeapAllocator(NULL), hdrStrHeapHint(NULL),
    ethreads_to_be_signalled(NULL),
    n_ethreads_to_be_signalled(0),
+   steal_rsb(NULL), steal_stat_id(0),
    main_accept_index(-1),
    id(NO_ETHREAD_ID), event_types(0),
    signal_hook(0),
@@ -53,8 +56,13 @@ EThread::EThread()
 
 EThread::EThread(ThreadType att, int anid)
   : generator((uint64_t)ink_get_hrtime_internal() ^ (uint64_t)(uintptr_t)this),
+    hdrHeapAllocator(NULL),
+    strHeapAllocator(NULL),
+    hdrStrHeapHint(NULL),
     ethreads_to_be_signalled(NULL),
     n_ethreads_to_be_signalled(0),
+    steal_rsb(NULL),
+    steal_stat_id(0),
     main_accept_index(-1),
     id(anid),
     event_types(0),
@@ -93,8 +101,10 @@ EThread::EThread(ThreadType att, int anid)
 
 EThread::EThread(ThreadType att, Event * e, ink_sem * sem)
  : generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t) this)),
+   hdrHeapAllocator(NULL), strHeapAllocator(NULL), hdrStrHeapHint(NULL),
    ethreads_to_be_signalled(NULL),
    n_ethreads_to_be_signalled(0),
+   steal_rsb(NULL), steal_stat_id(0),
    main_accept_index(-1),
    id(NO_ETHREAD_ID), event_types(0),
    signal_hook(0),
@@ -132,11 +142,31 @@ void
 EThread::process_event(Event * e, int calling_code)
 {
   ink_assert((!e->in_the_prot_queue && !e->in_the_priority_queue));
+  // counted here rather than in ProxyMutex::wake_waiter, which is also
+  // linked into programs without the event loop stats
+  if (e->lock_woken && eventloop_rsb)
+    RecIncrRawStat(eventloop_rsb, this, eventloop_lock_wakeups_stat, 1);
   MUTEX_TRY_LOCK_FOR(lock, e->mutex.m_ptr, this, e->continuation);
   if (!lock) {
-    e->timeout_at = cur_time + DELAY_FOR_RETRY;
-    EventQueueExternal.enqueue_local(e);
+    if (eventProcessor.lock_waiters && e->period >= 0) {
+      // Wait for the unlock. Poll events keep retrying, they must run
+      // between polls.
+      ProxyMutex *m = e->mutex;
+      e->timeout_at = e->period ? cur_time : 0;
+      if (eventloop_rsb)
+        RecIncrRawStat(eventloop_rsb, this, eventloop_lock_waits_stat, 1);
+      m->add_waiter(e);
+      // The holder may have unlocked before the event was added, then
+      // nobody would wake it. Taking and dropping the lock wakes it.
+      MUTEX_TRY_LOCK(relock, m, this);
+    } else {
+      e->timeout_at = cur_time + DELAY_FOR_RETRY;
+      if (eventloop_rsb)
+        RecIncrRawStat(eventloop_rsb, this, eventloop_lock_retries_stat, 1);
+      EventQueueExternal.enqueue_local(e);
+    }
   } else {
+    e->lock_woken = 0;
     if (e->cancelled) {
       free_event(e);
       return;
@@ -163,6 +193,64 @@ EThread::process_event(Event * e, int calling_code)
   }
 }
 
+//
+// int EThread::steal_events()
+//
+// Called when this thread has nothing to do: take the immediate events
+// that busy threads of the same type have queued but not started, and
+// run them here. Events left in a peer's steal queue mean that peer is
+// still working through an earlier batch.
+//
+int
+EThread::steal_events()
+{
+  int etype = ffs(event_types) - 1;
+  int n = eventProcessor.n_threads_for_type[etype];
+  int stolen = 0;
+  Event *e;
+
+  if (n <= 1)
+    return 0;
+  RecIncrRawStat(steal_rsb, this, steal_stat_id + 1, 1);
+  int start = (int) (generator.random() % n);
+  for (int i = 0; i < n && stolen < MAX_STEALS_PER_LOOP; i++) {
+    EThread *peer = eventProcessor.eventthread[etype][(start + i) % n];
+    if (peer == this || peer->event_types != event_types)
+      continue;
+    while (stolen < MAX_STEALS_PER_LOOP && (e = peer->EventQueueSteal.take())) {
+      stolen++;
+      e->ethread = this;
+      if (e->cancelled)
+        free_event(e);
+      else
+        process_event(e, e->callback_event);
+    }
+  }
+  if (stolen)
+    RecIncrRawStat(steal_rsb, this, steal_stat_id, stolen);
+  return stolen;
+}
+
+//
+// void EThread::run_steal_queue()
+//
+// Run the events of our own steal queue which no peer has taken. They
+// arrived before any immediate event still to be run, so this is called
+// before running one to keep the events in order.
+//
+void
+EThread::run_steal_queue()
+{
+  Event *e;
+
+  while ((e = EventQueueSteal.take())) {
+    if (e->cancelled)
+      free_event(e);
+    else
+      process_event(e, e->callback_event);
+  }
+}
+
 //
 // void  EThread::execute()
 //
@@ -188,12 +276,20 @@ EThread::execute() {
         // execute all the available external events that have
         // already been dequeued
         cur_time = ink_get_based_hrtime_internal();
+        // peers had the whole last pass to take these
+        run_steal_queue();
         while ((e = EventQueueExternal.dequeue_local())) {
           if (e->cancelled)
              free_event(e);
           else if (!e->timeout_at) { // IMMEDIATE
             ink_assert(e->period == 0);
-            process_event(e, e->callback_event);
+            // leave migratable events where idle peers can take them until
+            // the next pass, the events behind them wait for those left
+            if (!(steal_rsb && e->migratable && e->mutex.m_ptr != mutex && EventQueueSteal.push(e))) {
+              if (!EventQueueSteal.empty())
+                run_steal_queue();
+              process_event(e, e->callback_event);
+            }
           } else if (e->timeout_at > 0) // INTERVAL
             EventQueue.enqueue(e, cur_time);
           else { // NEGATIVE
@@ -235,9 +331,11 @@ EThread::execute() {
           if (!INK_ATOMICLIST_EMPTY(EventQueueExternal.al))
             EventQueueExternal.dequeue_timed(cur_time, next_time, false);
           while ((e = EventQueueExternal.dequeue_local())) {
-            if (!e->timeout_at)
+            if (!e->timeout_at) {
+              if (!EventQueueSteal.empty())
+                run_steal_queue();
               process_event(e, e->callback_event);
-            else {
+            } else {
               if (e->cancelled)
                 free_event(e);
               else {
@@ -264,6 +362,8 @@ EThread::execute() {
               }
             }
           }
+          if (steal_rsb && INK_ATOMICLIST_EMPTY(EventQueueExternal.al))
+            steal_events();
           // execute poll events
           while ((e = NegativeQueue.dequeue()))
             process_event(e, EVENT_POLL);
@@ -281,7 +381,11 @@ EThread::execute() {
           // cond_timedwait.
           if (n_ethreads_to_be_signalled)
             flush_signals(this);
-          EventQueueExternal.dequeue_timed(cur_time, next_time, true);
+          // don't sleep on our own events left for peers, or if there was
+          // work to steal
+          bool may_sleep = !(steal_rsb && (!EventQueueSteal.empty() ||
+                                           (INK_ATOMICLIST_EMPTY(EventQueueExternal.al) && steal_events())));
+          EventQueueExternal.dequeue_timed(cur_time, next_time, may_sleep);
         }
       }
     }
@@ -90,6 +90,12 @@ bind_cpu(ink_cpuset_t *cpuset, ink_thread tid)
 }
 #endif
 
+//
+// Lock contention counters, summed over all event threads. Registered by
+// ink_event_system_init(), NULL in programs which do not call it.
+//
+RecRawStatBlock *eventloop_rsb = NULL;
+
 EventType
 EventProcessor::spawn_event_threads(int n_threads, const char* et_name, size_t stacksize)
 {
@@ -111,6 +117,8 @@ EventProcessor::spawn_event_threads(int n_threads, const char* et_name, size_t s
   }
 
   n_threads_for_type[new_thread_group_id] = n_threads;
+  if (work_stealing && n_threads > 1 && steal_stats_hook)
+    steal_stats_hook(eventthread[new_thread_group_id], n_threads);
   for (i = 0; i < n_threads; i++) {
     snprintf(thr_name, MAX_THREAD_NAME_LENGTH, "[%s %d]", et_name, i);
     eventthread[new_thread_group_id][i]->start(thr_name, stacksize);
@@ -157,6 +165,11 @@ EventProcessor::start(int n_event_threads, size_t stacksize)
   }
   n_threads_for_type[ET_CALL] = n_event_threads;
 
+  REC_ReadConfigInteger(work_stealing, "proxy.config.exec_thread.work_stealing");
+  if (work_stealing && n_event_threads > 1 && steal_stats_hook)
+    steal_stats_hook(eventthread[ET_CALL], n_event_threads);
+  REC_ReadConfigInteger(lock_waiters, "proxy.config.exec_thread.lock_waiters");
+
 #if TS_USE_HWLOC
   int affinity = 0;
   REC_ReadConfigInteger(affinity, "proxy.config.exec_thread.affinity");
@@ -0,0 +1,301 @@
+/** @file
+
+  Checks the PriorityEventQueue timing wheel and compares its cost with
+  the bucket lists it replaced
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "I_EventSystem.h"
+#include "ink_rand.h"
+
+Diags *diags;
+
+#define CHECK_EVENTS     20000
+#define BENCH_PENDING    100000
+#define BENCH_SHORT      64           // short timers scheduled per tick
+#define BENCH_TICKS      20000
+
+static int failures = 0;
+
+#define CHECK(_x, ...) do { \
+  if (!(_x)) {              \
+    printf("FAILED: " __VA_ARGS__); \
+    printf("\n");           \
+    failures++;             \
+  }                         \
+} while (0)
+
+//
+// The exponentially sized bucket lists PriorityEventQueue used to be,
+// for comparison: <5ms, 10, 20, 40, 80, 160, 320, 640, 1280, 2560, 5120
+//
+#define N_PQ_LIST        10
+#define PQ_BUCKET_TIME(_i) (HRTIME_MSECONDS(5) << (_i))
+
+struct ListEventQueue
+{
+  Que(Event, link) after[N_PQ_LIST];
+  ink_hrtime last_check_time;
+  uint32_t last_check_buckets;
+
+  ListEventQueue(ink_hrtime now)
+  {
+    last_check_time = now;
+    last_check_buckets = last_check_time / PQ_BUCKET_TIME(0);
+  }
+
+  void enqueue(Event * e, ink_hrtime now)
+  {
+    ink_hrtime t = e->timeout_at - now;
+    int i = 0;
+
+    while (i < N_PQ_LIST - 1 && t > PQ_BUCKET_TIME(i))
+      i++;
+    e->in_the_priority_queue = 1;
+    e->in_heap = i;
+    after[i].enqueue(e);
+  }
+
+  void remove(Event * e)
+  {
+    e->in_the_priority_queue = 0;
+    after[e->in_heap].remove(e);
+  }
+
+  Event *dequeue_ready(ink_hrtime)
+  {
+    Event *e = after[0].dequeue();
+    if (e)
+      e->in_the_priority_queue = 0;
+    return e;
+  }
+
+  void check_ready(ink_hrtime now, EThread *)
+  {
+    int i, j, k = 0;
+    uint32_t check_buckets = (uint32_t) (now / PQ_BUCKET_TIME(0));
+    uint32_t todo_buckets = check_buckets ^ last_check_buckets;
+    last_check_time = now;
+    last_check_buckets = check_buckets;
+    todo_buckets &= ((1 << (N_PQ_LIST - 1)) - 1);
+    while (todo_buckets) {
+      k++;
+      todo_buckets >>= 1;
+    }
+    for (i = 1; i <= k; i++) {
+      Event *e;
+      Que(Event, link) q = after[i];
+      after[i].clear();
+      while ((e = q.dequeue()) != NULL) {
+        ink_hrtime tt = e->timeout_at - now;
+        for (j = i; j > 0 && tt <= PQ_BUCKET_TIME(j - 1);)
+          j--;
+        e->in_heap = j;
+        after[j].enqueue(e);
+      }
+    }
+  }
+};
+
+static Event *
+new_event()
+{
+  Event *e = eventAllocator.alloc();
+  e->globally_allocated = true;
+  e->cancelled = false;
+  e->in_the_priority_queue = 0;
+  e->cookie = NULL;
+  return e;
+}
+
+//
+// Every event comes out on the first check_ready() at or after its
+// timeout, never before; removed events never come out, cancelled ones
+// either come out cancelled or are dropped on the way.
+//
+static void
+check_wheel()
+{
+  PriorityEventQueue pq;
+  InkRand rand(13);
+  ink_hrtime start = pq.last_check_time;
+  ink_hrtime now = start, prev = start;
+  Event **events = (Event **) ats_malloc(CHECK_EVENTS * sizeof(Event *));
+  int expected = 0, fired = 0, cancelled_seen = 0;
+
+  for (int i = 0; i < CHECK_EVENTS; i++) {
+    Event *e = events[i] = new_event();
+    uint64_t r = rand.random();
+    switch (r % 10) {
+    case 0:                    // hours out, across the upper levels
+      e->timeout_at = start + HRTIME_SECONDS(r % (3 * 3600));
+      break;
+    case 1:                    // a few seconds, within a tick of the start
+      e->timeout_at = start + (r >> 8) % HRTIME_MSECONDS(2);
+      break;
+    default:
+      e->timeout_at = start + (r >> 8) % HRTIME_SECONDS(20);
+      break;
+    }
+    pq.enqueue(e, now);
+  }
+  // remove one in ten, as rescheduling does, and cancel one in ten in place
+  for (int i = 0; i < CHECK_EVENTS; i++) {
+    if (i % 10 == 3) {
+      pq.remove(events[i]);
+      ink_assert(!events[i]->in_the_priority_queue);
+      eventAllocator.free(events[i]);
+      events[i] = NULL;
+    } else if (i % 10 == 7) {
+      // the queue owns it now and may free it as its slot cascades
+      events[i]->cancelled = true;
+      events[i] = NULL;
+    } else
+      expected++;
+  }
+
+  // an event past the last level waits in overflow until removed
+  Event *far = new_event();
+  far->timeout_at = start + HRTIME_DAYS(60);
+  pq.enqueue(far, now);
+  CHECK(far->in_heap == PQ_IN_OVERFLOW, "event 60 days out is not in overflow");
+  pq.remove(far);
+  eventAllocator.free(far);
+
+  int step = 0;
+  while (now < start + HRTIME_HOURS(3) + HRTIME_SECONDS(1)) {
+    // fine steps while the short events run, then coarse ones
+    if (now < start + HRTIME_SECONDS(21))
+      now += HRTIME_USECONDS(300) + rand.random() % HRTIME_MSECONDS(7);
+    else
+      now += HRTIME_SECONDS(1) + rand.random() % HRTIME_SECONDS(60);
+
+    if (!pq.ready.head && ++step % 500 == 0) {
+      ink_hrtime earliest = pq.earliest_timeout();
+      for (int i = 0; i < CHECK_EVENTS; i++) {
+        Event *e = events[i];
+        if (e && e->in_the_priority_queue)
+          CHECK(earliest <= PriorityEventQueue::tick_of(e) * PQ_TICK,
+                "earliest_timeout %" PRId64 " is after an event due at %" PRId64, earliest, e->timeout_at);
+      }
+    }
+
+    pq.check_ready(now, NULL);
+    Event *e;
+    while ((e = pq.dequeue_ready(now))) {
+      CHECK(e->timeout_at <= now, "event due at %" PRId64 " ran early at %" PRId64, e->timeout_at, now);
+      CHECK(prev == start || PriorityEventQueue::tick_of(e) > prev / PQ_TICK,
+            "event due at %" PRId64 " ran late at %" PRId64 ", it was due at %" PRId64, e->timeout_at, now, prev);
+      if (e->cancelled)
+        cancelled_seen++;
+      else
+        fired++;
+      for (int i = 0; i < CHECK_EVENTS && !e->cancelled; i++) {
+        if (events[i] == e) {
+          events[i] = NULL;
+          break;
+        }
+      }
+      eventAllocator.free(e);
+    }
+    prev = now;
+  }
+  CHECK(fired == expected, "%d of %d events ran", fired, expected);
+  CHECK(!pq.ready.head, "events left ready");
+  for (int i = 0; i < CHECK_EVENTS; i++)
+    CHECK(!events[i], "event %d due at %" PRId64 " never ran", i, events[i]->timeout_at);
+  printf("timing wheel: %d events ran on time, %d cancelled ones came out, %d were dropped in place\n",
+         fired, cancelled_seen, CHECK_EVENTS / 10 - cancelled_seen);
+  ats_free(events);
+}
+
+//
+// A thread with many long timers pending, scheduling and rescheduling
+// short ones each tick.
+//
+template<class Q> static double
+bench(Q & q, ink_hrtime start)
+{
+  InkRand rand(42);
+  Event **events = (Event **) ats_malloc((BENCH_PENDING + BENCH_SHORT) * sizeof(Event *));
+  ink_hrtime now = start;
+  int64_t ran = 0;
+
+  for (int i = 0; i < BENCH_PENDING; i++) {
+    events[i] = new_event();
+    events[i]->timeout_at = now + HRTIME_MSECONDS(1) + rand.random() % HRTIME_SECONDS(30);
+    q.enqueue(events[i], now);
+  }
+  for (int i = BENCH_PENDING; i < BENCH_PENDING + BENCH_SHORT; i++) {
+    events[i] = new_event();
+    events[i]->timeout_at = 0;
+  }
+
+  ink_hrtime begin = ink_get_hrtime_internal();
+  for (int tick = 0; tick < BENCH_TICKS; tick++) {
+    now += HRTIME_MSECONDS(1);
+    // reschedule the short timers, most are cancelled before they run
+    for (int i = BENCH_PENDING; i < BENCH_PENDING + BENCH_SHORT; i++) {
+      Event *e = events[i];
+      if (e->in_the_priority_queue)
+        q.remove(e);
+      e->timeout_at = now + HRTIME_MSECONDS(1) + rand.random() % HRTIME_MSECONDS(100);
+      q.enqueue(e, now);
+    }
+    q.check_ready(now, NULL);
+    Event *e;
+    while ((e = q.dequeue_ready(now))) {
+      ran++;
+      e->timeout_at = now + HRTIME_MSECONDS(1) + rand.random() % HRTIME_SECONDS(30);
+      q.enqueue(e, now);
+    }
+  }
+  ink_hrtime elapsed = ink_get_hrtime_internal() - begin;
+
+  for (int i = 0; i < BENCH_PENDING + BENCH_SHORT; i++) {
+    if (events[i]->in_the_priority_queue)
+      q.remove(events[i]);
+    eventAllocator.free(events[i]);
+  }
+  ats_free(events);
+  printf("  %" PRId64 " events ran, ", ran);
+  return (double) elapsed / BENCH_TICKS;
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char * /* argv ATS_UNUSED */[])
+{
+  check_wheel();
+
+  PriorityEventQueue wheel;
+  double wheel_ns = bench(wheel, wheel.last_check_time);
+  printf("timing wheel: %.0f ns/ms\n", wheel_ns);
+  ListEventQueue lists(wheel.last_check_time);
+  double lists_ns = bench(lists, wheel.last_check_time);
+  printf("bucket lists: %.0f ns/ms\n", lists_ns);
+  printf("%d pending, %d short timers rescheduled per ms: timing wheel %.1fx the speed of the bucket lists\n",
+         BENCH_PENDING, BENCH_SHORT, lists_ns / wheel_ns);
+
+  if (failures) {
+    printf("%d checks FAILED\n", failures);
+    return 1;
+  }
+  return 0;
+}
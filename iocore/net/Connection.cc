@@ -235,6 +235,16 @@ Server::setup_fd_for_listen(
     goto Lerror;
   }
 
+  if (f_reuse_port) {
+#ifdef SO_REUSEPORT
+    if ((res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0) {
+      goto Lerror;
+    }
+#else
+    Error("[Server::listen] SO_REUSEPORT requested but not supported on this platform\n");
+#endif
+  }
+
 #ifdef SET_TCP_NO_DELAY
   if ((res = safe_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, SOCKOPT_ON, sizeof(int))) < 0) {
     goto Lerror;
@@ -464,6 +464,18 @@ public:
   /** Set the TCP initial congestion window */
   virtual int set_tcp_init_cwnd(int init_cwnd) = 0;
 
+  /** Send large writes from the IOBuffers without copying them into the kernel.
+
+      The blocks written are held until the kernel reports it is done with
+      them. Returns false if the connection type or platform can not do this,
+      in which case writes are copied as usual. Turning it off releases the
+      blocks of the sends that are done.
+  */
+  virtual bool set_zero_copy(bool enable) {
+    (void) enable;
+    return false;
+  }
+
   /** Set local sock addr struct. */
   virtual void set_local_addr() = 0;
 
@@ -111,6 +111,101 @@ register_net_stats()
   RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.inactivity_cop_lock_acquire_failure",
                      RECD_INT, RECP_NULL, (int) inactivity_cop_lock_acquire_failure_stat,
                      RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.zero_copy_writes",
+                     RECD_INT, RECP_NULL, (int) net_zero_copy_writes_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_zero_copy_writes_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.zero_copy_copied",
+                     RECD_INT, RECP_NULL, (int) net_zero_copy_copied_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_zero_copy_copied_stat);
+
+  // The share of resumed handshakes is the session resumption hit rate,
+  // the cache and ticket counts show where the misses come from.
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.full_handshakes",
+                     RECD_INT, RECP_NULL, (int) ssl_full_handshake_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_full_handshake_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.resumed_handshakes",
+                     RECD_INT, RECP_NULL, (int) ssl_resumed_handshake_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_resumed_handshake_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.session_cache.hits",
+                     RECD_INT, RECP_NULL, (int) ssl_session_cache_hit_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_session_cache_hit_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.session_cache.misses",
+                     RECD_INT, RECP_NULL, (int) ssl_session_cache_miss_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_session_cache_miss_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.session_cache.evictions",
+                     RECD_INT, RECP_NULL, (int) ssl_session_cache_eviction_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_session_cache_eviction_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.session_cache.store_hits",
+                     RECD_INT, RECP_NULL, (int) ssl_session_store_hit_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_session_store_hit_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.session_ticket.old_key",
+                     RECD_INT, RECP_NULL, (int) ssl_session_ticket_old_key_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_session_ticket_old_key_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.session_ticket.unknown_key",
+                     RECD_INT, RECP_NULL, (int) ssl_session_ticket_unknown_key_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_session_ticket_unknown_key_stat);
+
+  // Times are in microseconds. The handshake time over the handshake
+  // count is the mean server handshake latency; with handshake threads,
+  // the queue time is how long steps waited for one, and the run time
+  // over the wall time of the threads is how busy they are.
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.handshake.time",
+                     RECD_INT, RECP_NULL, (int) ssl_handshake_time_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_handshake_time_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.handshake.offloaded_steps",
+                     RECD_INT, RECP_NULL, (int) ssl_handshake_offloaded_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_handshake_offloaded_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.handshake.queue_time",
+                     RECD_INT, RECP_NULL, (int) ssl_handshake_queue_time_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_handshake_queue_time_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.ssl.handshake.run_time",
+                     RECD_INT, RECP_NULL, (int) ssl_handshake_run_time_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(ssl_handshake_run_time_stat);
+}
+
+//
+// Per thread accept counts, proxy.process.net.accepts_per_thread.<n>, for
+// the per thread accept modes. These show how evenly new connections are
+// spread across the threads. Each type of accepting thread has its own
+// block, named by prefix, so that SSL threads are counted apart from the
+// net threads. The thread counts are only known once the event threads are
+// running, so a block is registered by the first per thread accept on its
+// threads.
+//
+static ProcessMutex net_accept_thread_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static NetAcceptThreadStats net_accept_thread_stats[MAX_EVENT_TYPES];
+
+NetAcceptThreadStats *
+register_net_accept_thread_stats(EventType etype, const char *prefix)
+{
+  NetAcceptThreadStats *stats = &net_accept_thread_stats[etype];
+  char name[128];
+
+  ink_mutex_acquire(&net_accept_thread_stats_mutex);
+  if (!stats->rsb) {
+    int n_threads = eventProcessor.n_threads_for_type[etype];
+
+    stats->rsb = RecAllocateRawStatBlock(n_threads);
+    for (int i = 0; i < n_threads; i++) {
+      snprintf(name, sizeof(name), "%s.%d", prefix, i);
+      RecRegisterRawStat(stats->rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i, RecRawStatSyncSum);
+    }
+    stats->count = n_threads;
+  }
+  ink_mutex_release(&net_accept_thread_stats_mutex);
+  return stats;
 }
 
 void
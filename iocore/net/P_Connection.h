@@ -163,6 +163,9 @@ struct Server: public Connection
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter;
 
+  /// If set, the listen socket is opened with SO_REUSEPORT.
+  bool f_reuse_port;
+
   //
   // Use this call for the main proxy accept
   //
@@ -187,6 +190,8 @@ struct Server: public Connection
   Server()
     : Connection()
     , f_inbound_transparent(false)
+    , http_accept_filter(false)
+    , f_reuse_port(false)
   {
     ink_zero(accept_addr);
   }
@@ -51,6 +51,20 @@ enum Net_Stats
   socks_connections_unsuccessful_stat,
   socks_connections_currently_open_stat,
   inactivity_cop_lock_acquire_failure_stat,
+  net_zero_copy_writes_stat,
+  net_zero_copy_copied_stat,
+  ssl_full_handshake_stat,
+  ssl_resumed_handshake_stat,
+  ssl_session_cache_hit_stat,
+  ssl_session_cache_miss_stat,
+  ssl_session_cache_eviction_stat,
+  ssl_session_store_hit_stat,
+  ssl_session_ticket_old_key_stat,
+  ssl_session_ticket_unknown_key_stat,
+  ssl_handshake_time_stat,
+  ssl_handshake_offloaded_stat,
+  ssl_handshake_queue_time_stat,
+  ssl_handshake_run_time_stat,
   Net_Stat_Count
 };
 
@@ -60,6 +74,7 @@ extern RecRawStatBlock *net_rsb;
 #define SSL_HANDSHAKE_WANT_WRITE  7
 #define SSL_HANDSHAKE_WANT_ACCEPT 8
 #define SSL_HANDSHAKE_WANT_CONNECT 9
+#define SSL_HANDSHAKE_WANT_ASYNC  11
 
 #define NET_DEBUG_COUNT_DYN_STAT(_x, _y) \
 RecIncrRawStatCount(net_rsb, mutex->thread_holding, (int)_x, _y)
@@ -86,6 +101,10 @@ do { \
 	RecSetRawStatCount(net_rsb, x, 0); \
 } while (0);
 
+// From OpenSSL callbacks, which have no continuation at hand
+#define SSL_INCREMENT_DYN_STAT(_x) \
+RecIncrRawStatSum(net_rsb, this_ethread(), (int)_x, 1)
+
 // For global access
 #define NET_SUM_GLOBAL_DYN_STAT(_x, _r) RecIncrGlobalRawStatSum(net_rsb, (_x), (_r))
 #define NET_READ_GLOBAL_DYN_SUM(_x, _sum) RecGetGlobalRawStatSum(net_rsb, _x, &_sum)
@@ -108,6 +127,20 @@ do { \
 #include "P_SSLNetProcessor.h"
 #include "P_SSLNetAccept.h"
 #include "P_SSLCertLookup.h"
+#include "P_SSLSessionCache.h"
+
+// Per thread accept counts, one block for each type of accepting thread
+struct NetAcceptThreadStats
+{
+  RecRawStatBlock *rsb;
+  int count;
+};
+NetAcceptThreadStats *register_net_accept_thread_stats(EventType etype, const char *prefix);
+
+#define NET_INCREMENT_ACCEPT_THREAD_STAT(_stats, _t, _id) do { \
+  if ((_stats) && (_id) < (_stats)->count) \
+    RecIncrRawStatSum((_stats)->rsb, (_t), (_id), 1); \
+} while (0)
 
 #undef  NET_SYSTEM_MODULE_VERSION
 #define NET_SYSTEM_MODULE_VERSION makeModuleVersion(                    \
@@ -54,7 +54,11 @@ typedef int (AcceptFunction) (NetAccept * na, void *e, bool blockable);
 typedef AcceptFunction *AcceptFunctionPtr;
 AcceptFunction net_accept;
 
+// Set the per port socket options (TCP_DEFER_ACCEPT etc.) on a listen socket.
+void net_listen_sockopts(int fd);
+
 class UnixNetVConnection;
+struct NetAcceptThreadStats;
 
 // TODO fix race between cancel accept and call back
 struct NetAcceptAction:public Action, public RefCountObj
@@ -99,6 +103,13 @@ struct NetAccept:public Continuation
   EventType etype;
   UnixNetVConnection *epoll_vc; // only storage for epoll events
   EventIO ep;
+  /// This thread of a per thread accept listens on a SO_REUSEPORT socket
+  /// of its own, which it closes when the accept is cancelled.
+  bool reuse_port;
+  /// Index of the accepting thread for per thread accepts, -1 otherwise.
+  int id;
+  /// Accept counts of the threads of a per thread accept.
+  NetAcceptThreadStats *thread_stats;
 
   // Functions all THREAD_FREE and THREAD_ALLOC to be performed
   // for both SSL and regular NetVConnection transparent to
@@ -113,6 +124,7 @@ struct NetAccept:public Continuation
   virtual void init_accept_per_thread();
   // 0 == success
   int do_listen(bool non_blocking, bool transparent = false);
+  void listen_per_thread(NetAccept *a);
 
   int do_blocking_accept(EThread * t);
   virtual int acceptEvent(int event, void *e);
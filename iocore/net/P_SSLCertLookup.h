@@ -30,16 +30,47 @@
 struct SSLConfigParams;
 struct SSLContextStorage;
 
+// A server certificate context. The SSL_CTX can be made the first time a handshake asks for it,
+// so that a large certificate configuration only holds the contexts that are in use. Lookups
+// take references, so a certificate can be shared across names and across configurations.
+struct SSLCertContext : public RefCountObj
+{
+  explicit SSLCertContext(SSL_CTX * c = NULL);
+  virtual ~SSLCertContext();
+
+  // Return the SSL_CTX, making it if this is the first use. NULL if it can't be made.
+  SSL_CTX * get();
+
+  // Whether making the SSL_CTX failed.
+  bool failed() const { return make_failed; }
+
+protected:
+  // Make the SSL_CTX. This is called at most once, with the mutex held.
+  virtual SSL_CTX * make() { return NULL; }
+
+private:
+  SSL_CTX * volatile  ctx;
+  bool                make_failed;
+  ink_mutex           mutex;
+};
+
 struct SSLCertLookup : public ConfigInfo
 {
   SSLContextStorage * ssl_storage;
   SSL_CTX *           ssl_default;
 
+  bool insert(SSLCertContext * cc, const char * name);
+  bool insert(SSLCertContext * cc, const IpEndpoint& address);
+  // Insert an SSL_CTX that is already made. The lookup owns it from then on.
   bool insert(SSL_CTX * ctx, const char * name);
   bool insert(SSL_CTX * ctx, const IpEndpoint& address);
   SSL_CTX * findInfoInHash(const char * address) const;
   SSL_CTX * findInfoInHash(const IpEndpoint& address) const;
 
+  // Keep a certificate by the configuration that made it, so that the next configuration can reuse it.
+  void remember(const char * spec, SSLCertContext * cc);
+  SSLCertContext * recall(const char * spec) const;
+
   // Return the last-resort default TLS context if there is no name or address match.
   SSL_CTX * defaultContext() const { return ssl_default; }
 
@@ -49,7 +49,8 @@ struct SSLConfigParams : public ConfigInfo
   enum SSL_SESSION_CACHE_MODE
   {
     SSL_SESSION_CACHE_MODE_OFF = 0,
-    SSL_SESSION_CACHE_MODE_SERVER = 1
+    SSL_SESSION_CACHE_MODE_SERVER = 1,
+    SSL_SESSION_CACHE_MODE_SERVER_ATS = 2
   };
 
   SSLConfigParams();
@@ -66,6 +67,8 @@ struct SSLConfigParams : public ConfigInfo
   int     verify_depth;
   int     ssl_session_cache; // SSL_SESSION_CACHE_MODE
   int     ssl_session_cache_size;
+  int     ssl_session_cache_num_buckets;
+  int     multicert_load_on_demand;
 
   char *  clientCertPath;
   char *  clientKeyPath;
@@ -111,4 +114,38 @@ private:
   static int configid;
 };
 
+// The session ticket keys, shared by every server context so that any
+// of our servers, before or after a restart, can resume a session from
+// a ticket another issued. New tickets are sealed with the first key;
+// the others are still accepted, and their tickets replaced, while a
+// rotation makes its way to every server.
+struct SSLTicketKey
+{
+  unsigned char name[16];
+  unsigned char hmac_secret[16];
+  unsigned char aes_key[16];
+};
+
+struct SSLTicketKeyBlock : public ConfigInfo
+{
+  SSLTicketKey * keys;
+  unsigned num_keys;
+
+  SSLTicketKeyBlock() : keys(NULL), num_keys(0) { }
+  virtual ~SSLTicketKeyBlock() { ats_free(keys); }
+};
+
+struct SSLTicketKeyConfig
+{
+  static void startup();
+  static void reconfigure();
+  static SSLTicketKeyBlock * acquire();
+  static void release(SSLTicketKeyBlock * keys);
+
+  typedef ConfigProcessor::scoped_config<SSLTicketKeyConfig, SSLTicketKeyBlock> scoped_config;
+
+private:
+  static int configid;
+};
+
 #endif
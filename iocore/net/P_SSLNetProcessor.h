@@ -62,6 +62,11 @@ public:
 
   static EventType ET_SSL;
 
+  // Threads that run the server side of handshakes for the ET_SSL
+  // threads, if proxy.config.ssl.handshake.threads asks for any.
+  static EventType ET_SSL_HANDSHAKE;
+  static int handshake_threads;
+
   //
   // Private
   //
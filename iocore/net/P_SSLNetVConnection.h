@@ -52,6 +52,22 @@
 #endif
 
 class SSLNextProtocolSet;
+class SSLNetVConnection;
+
+//
+// Runs a step of a server handshake on a handshake thread and brings
+// the outcome back to the thread of the connection.
+//
+struct SSLHandShakeOffload:public Continuation
+{
+  SSLNetVConnection *vc;
+  ink_hrtime queued_at;
+  int ssl_error;
+  int err;
+
+  int runEvent(int event, Event * e);
+  int doneEvent(int event, Event * e);
+};
 
 //////////////////////////////////////////////////////////////////
 //
@@ -86,10 +102,26 @@ public:
   {
     sslClientConnection = state;
   };
+  // A connection that failed with a protocol error or an alert is not shut
+  // down cleanly, so its session is not kept for resumption.
+  void setSSLFatalError(bool state)
+  {
+    sslFatalError = state;
+  };
+  // The handshake thread has the SSL object and the socket, closing
+  // the connection has to wait until they come back.
+  virtual bool getSSLHandShakeOffloaded()
+  {
+    return handShakeOffload == SSL_OFFLOAD_RUNNING;
+  };
   int sslServerHandShakeEvent(int &err);
   int sslClientHandShakeEvent(int &err);
+  void sslHandShakeOffload();
+  void sslHandShakeOffloadDone();
   virtual void net_read_io(NetHandler * nh, EThread * lthread);
   virtual int64_t load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_wrote, MIOBufferAccessor & buf);
+  // Records are encrypted into a private buffer, there is nothing to share.
+  virtual bool set_zero_copy(bool /* enable */) { return false; }
 
   void registerNextProtocolSet(const SSLNextProtocolSet *);
 
@@ -115,8 +147,19 @@ private:
   SSLNetVConnection(const SSLNetVConnection &);
   SSLNetVConnection & operator =(const SSLNetVConnection &);
 
+  enum
+  {
+    SSL_OFFLOAD_NONE,
+    SSL_OFFLOAD_RUNNING,        // a handshake thread is running a step
+    SSL_OFFLOAD_DONE            // the outcome of the step is waiting in offload
+  };
+
   bool sslHandShakeComplete;
   bool sslClientConnection;
+  bool sslFatalError;
+  int handShakeOffload;
+  SSLHandShakeOffload offload;
+  ink_hrtime sslHandShakeBegin;
   const SSLNextProtocolSet * npnSet;
   Continuation * npnEndpoint;
 };
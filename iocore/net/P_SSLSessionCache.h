@@ -0,0 +1,85 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+
+#ifndef __P_SSLSESSIONCACHE_H__
+#define __P_SSLSESSIONCACHE_H__
+
+#include "libts.h"
+#include "P_SSLUtils.h"
+
+// Sessions larger than this, typically ones carrying a big client
+// certificate chain, are not cached.
+#define SSL_SESSION_MAX_DER   (10 * 1024)
+
+// An external session store shared with other servers, for instance a
+// daemon on the local host fronting the store shared by every server
+// behind a load balancer. These are called on the network threads in
+// the middle of a handshake, so they must answer quickly rather than
+// wait on a slow store; a miss only costs a full handshake.
+//
+// get copies the DER encoded session into buf and returns its length,
+// or 0 if there is none or it does not fit.
+typedef int (*SSLSessionStoreGetFunc) (const unsigned char *id, int id_len, unsigned char *buf, int buf_len);
+typedef void (*SSLSessionStorePutFunc) (const unsigned char *id, int id_len, const unsigned char *data, int len, time_t expires);
+typedef void (*SSLSessionStoreRemoveFunc) (const unsigned char *id, int id_len);
+
+struct SSLSessionBucket;
+
+// The server session cache shared by all threads and SSL contexts. It
+// is split into buckets by session ID, each with its own lock and LRU
+// list, so handshakes on different threads rarely wait for each other.
+// Sessions are kept DER encoded, the form they take in the external
+// store too.
+struct SSLSessionCache
+{
+  SSLSessionCache(int size, int nbuckets);
+  ~SSLSessionCache();
+
+  // Return a new reference to the session with this ID, looking in the
+  // external store if it is not here, or NULL.
+  SSL_SESSION * get(const unsigned char * id, int id_len);
+  void insert(SSL_SESSION * session);
+  void remove(const unsigned char * id, int id_len);
+
+  static void set_store(SSLSessionStoreGetFunc get, SSLSessionStorePutFunc put, SSLSessionStoreRemoveFunc remove);
+
+private:
+  SSLSessionBucket * bucket_for(const unsigned char * id, int id_len) const;
+  void insert_der(const unsigned char * id, int id_len, const unsigned char * der, int len, time_t expires);
+
+  SSLSessionBucket * buckets;
+  int nbuckets;
+  int bucket_size;
+
+  static SSLSessionStoreGetFunc store_get;
+  static SSLSessionStorePutFunc store_put;
+  static SSLSessionStoreRemoveFunc store_remove;
+};
+
+extern SSLSessionCache * ssl_session_cache;
+
+// Use the shared session cache for the sessions of this server context.
+void SSLSessionCacheEnable(SSL_CTX * ctx);
+
+#endif /* __P_SSLSESSIONCACHE_H__ */
@@ -60,13 +60,16 @@ void SSLInitializeLibrary();
 
 void SSLDiagnostic(const SrcLoc& loc, bool debug, const char * fmt, ...) TS_PRINTFLIKE(3, 4);
 
+// Whether a session was negotiated with the certificate this connection uses.
+bool SSLSessionMatchesContext(SSL * ssl, SSL_SESSION * session);
+
 // Return a static string name for a SSL_ERROR constant.
 const char * SSLErrorName(int ssl_error);
 
 // Log a SSL network buffer.
 void SSLDebugBufferPrint(const char * tag, const char * buffer, unsigned buflen, const char * message);
 
-// Load the SSL certificate configuration.
-bool SSLParseCertificateConfiguration(const SSLConfigParams * params, SSLCertLookup * lookup);
+// Load the SSL certificate configuration, keeping the unchanged certificates of the previous one (if any).
+bool SSLParseCertificateConfiguration(const SSLConfigParams * params, SSLCertLookup * lookup, const SSLCertLookup * previous);
 
 #endif /* __P_SSLUTILS_H__ */
@@ -176,6 +176,41 @@ struct PollCont:public Continuation
 };
 
 
+#ifndef INACTIVITY_TIMEOUT
+//
+// NetTimeoutWheel
+//
+// Hierarchical timing wheel of the NetVCs a NetHandler has to look at
+// for timeouts, by the tick they are due. Levels of 64 slots cover one,
+// 64 and 4096 ticks per slot; anything further out waits in the top
+// level and is placed again as it comes around. A VC is placed at most
+// once: moving its deadline later leaves it where it is and it is placed
+// again when that slot comes due, so keeping a connection busy costs
+// nothing here.
+//
+#define NET_TIMEOUT_WHEEL_TICK     HRTIME_SECONDS(1)
+#define NET_TIMEOUT_WHEEL_BITS     6
+#define NET_TIMEOUT_WHEEL_SLOTS    (1 << NET_TIMEOUT_WHEEL_BITS)
+#define NET_TIMEOUT_WHEEL_MASK     (NET_TIMEOUT_WHEEL_SLOTS - 1)
+#define NET_TIMEOUT_WHEEL_LEVELS   3
+
+struct NetTimeoutWheel
+{
+  DList(UnixNetVConnection, timeout_link) slots[NET_TIMEOUT_WHEEL_LEVELS][NET_TIMEOUT_WHEEL_SLOTS];
+  int64_t cur_tick;
+
+  void schedule(UnixNetVConnection *vc, ink_hrtime at);
+  void remove(UnixNetVConnection *vc);
+  void advance(ink_hrtime now, DList(UnixNetVConnection, cop_link) &due);
+
+  NetTimeoutWheel() : cur_tick(ink_get_hrtime() / NET_TIMEOUT_WHEEL_TICK) { }
+
+private:
+  void place(UnixNetVConnection *vc);
+  void cascade(int level);
+};
+#endif
+
 //
 // NetHandler
 //
@@ -192,6 +227,12 @@ public:
   DList(UnixNetVConnection, cop_link) cop_list;
   ASLLM(UnixNetVConnection, NetState, read, enable_link) read_enable_list;
   ASLLM(UnixNetVConnection, NetState, write, enable_link) write_enable_list;
+  Que(NetZeroCopy, link) zero_copy_linger_list;
+#ifndef INACTIVITY_TIMEOUT
+  NetTimeoutWheel timeout_wheel;
+  // VCs whose timeouts changed on another thread, for the inactivity cop
+  ASLL(UnixNetVConnection, timeout_enable_link) timeout_enable_list;
+#endif
 
   time_t sec;
   int cycles;
@@ -200,6 +241,7 @@ public:
   int mainNetEvent(int event, Event * data);
   int mainNetEventExt(int event, Event * data);
   void process_enabled_list(NetHandler *);
+  void process_zero_copy_linger_list();
 
   NetHandler();
 };
@@ -383,6 +425,37 @@ check_transient_accept_error(int res)
   }
 }
 
+#ifndef INACTIVITY_TIMEOUT
+//
+// Have the wheel hand back the VC on the tick \a at falls in, or the
+// next one. A VC already due by then is left where it is.
+//
+TS_INLINE void
+NetTimeoutWheel::schedule(UnixNetVConnection *vc, ink_hrtime at)
+{
+  int64_t tick = at / NET_TIMEOUT_WHEEL_TICK;
+
+  if (tick <= cur_tick)
+    tick = cur_tick + 1;
+  if (vc->timeout_slot >= 0) {
+    if (vc->timeout_tick <= tick)
+      return;
+    remove(vc);
+  }
+  vc->timeout_tick = tick;
+  place(vc);
+}
+
+TS_INLINE void
+NetTimeoutWheel::remove(UnixNetVConnection *vc)
+{
+  if (vc->timeout_slot >= 0) {
+    slots[vc->timeout_slot >> NET_TIMEOUT_WHEEL_BITS][vc->timeout_slot & NET_TIMEOUT_WHEEL_MASK].remove(vc);
+    vc->timeout_slot = -1;
+  }
+}
+#endif
+
 //
 // Disable a UnixNetVConnection
 //
@@ -96,6 +96,45 @@ struct OOB_callback:public Continuation
   }
 };
 
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define TS_HAS_ZERO_COPY_SEND 1
+#endif
+
+//
+// Zero copy sends (MSG_ZEROCOPY).
+//
+// The kernel numbers each zero copy sendmsg() on a socket and later posts
+// the numbers it has finished with to the socket error queue.  Until then
+// it still reads the user pages, so the blocks of every send are held here
+// (by reference, no copy) and released as the completions are reaped.
+//
+struct ZeroCopySend
+{
+  uint32_t seq;
+  Ptr<IOBufferBlock> blocks;
+  LINK(ZeroCopySend, link);
+};
+
+struct NetZeroCopy
+{
+  bool enabled;
+  uint32_t next_seq;
+  Que(ZeroCopySend, link) pending;
+
+  // Set once the NetVConnection is closed with sends still in flight: the
+  // socket is kept open by the NetHandler until they complete.
+  int fd;
+  ink_hrtime linger_until;
+  LINK(NetZeroCopy, link);
+
+  void add(IOBufferBlock *b, int64_t offset, int64_t len);
+  bool reap(int sock);
+  void release_all();
+
+  NetZeroCopy():enabled(false), next_seq(0), fd(NO_FD), linger_until(0) { }
+  ~NetZeroCopy() { release_all(); }
+};
+
 class UnixNetVConnection:public NetVConnection
 {
 public:
@@ -173,6 +212,9 @@ public:
   virtual bool getSSLHandShakeComplete() {
     return (true);
   }
+  virtual bool getSSLHandShakeOffloaded() {
+    return (false);
+  }
   virtual bool getSSLClientConnection()
   {
     return (false);
@@ -197,6 +239,10 @@ public:
   NetState write;
 
   LINK(UnixNetVConnection, cop_link);
+#ifndef INACTIVITY_TIMEOUT
+  LINK(UnixNetVConnection, timeout_link);
+  SLINK(UnixNetVConnection, timeout_enable_link);
+#endif
   LINKM(UnixNetVConnection, read, ready_link)
   SLINKM(UnixNetVConnection, read, enable_link)
   LINKM(UnixNetVConnection, write, ready_link)
@@ -208,6 +254,9 @@ public:
   Event *inactivity_timeout;
 #else
   ink_hrtime next_inactivity_timeout_at;
+  int64_t timeout_tick;         // NetTimeoutWheel tick it is due back at
+  int timeout_slot;             // level and slot in the wheel, -1 if not in it
+  volatile int in_timeout_enable_list;
 #endif
   Event *active_timeout;
   EventIO ep;
@@ -233,6 +282,7 @@ public:
   ink_hrtime submit_time;
   OOB_callback *oob_ptr;
   bool from_accept_thread;
+  NetZeroCopy *zero_copy;
 
   int startEvent(int event, Event *e);
   int acceptEvent(int event, Event *e);
@@ -246,6 +296,7 @@ public:
   virtual void set_local_addr();
   virtual void set_remote_addr();
   virtual int set_tcp_init_cwnd(int init_cwnd);
+  virtual bool set_zero_copy(bool enable);
   virtual void apply_options();
 };
 
@@ -253,6 +304,10 @@ extern ClassAllocator<UnixNetVConnection> netVCAllocator;
 
 typedef int (UnixNetVConnection::*NetVConnHandler) (int, void *);
 
+#ifndef INACTIVITY_TIMEOUT
+void net_check_timeout_at(UnixNetVConnection * vc, ink_hrtime at);
+#endif
+
 
 TS_INLINE void
 UnixNetVConnection::set_remote_addr()
@@ -286,6 +341,8 @@ UnixNetVConnection::set_inactivity_timeout(ink_hrtime timeout)
   inactivity_timeout_in = timeout;
 #ifndef INACTIVITY_TIMEOUT
   next_inactivity_timeout_at = ink_get_hrtime() + timeout;
+  if (timeout)
+    net_check_timeout_at(this, next_inactivity_timeout_at);
 #else
   if (inactivity_timeout)
     inactivity_timeout->cancel_action(this);
@@ -28,8 +28,6 @@
 #include "P_SSLConfig.h"
 #include "I_EventSystem.h"
 #include "I_Layout.h"
-#include "Regex.h"
-#include "Trie.h"
 #include "ts/TestBox.h"
 
 struct SSLAddressLookupKey
@@ -68,29 +66,94 @@ private:
   unsigned char sep; // offset of address/port separator
 };
 
+// A radix trie over DNS names, one label at a time from the top level domain down, so that a wildcard
+// can only match whole labels. Runs of labels that don't branch share a node. Each node holds the
+// certificate for its exact name and the certificate for the wildcard one level below it.
+struct SSLNameNode
+{
+  explicit SSLNameNode(const char * e = "", unsigned len = 0);
+  ~SSLNameNode();
+
+  SSLNameNode * child(const char * label, unsigned len, uint32_t hash) const;
+  void adopt(SSLNameNode * node);
+  void replace(SSLNameNode * node, SSLNameNode * with);
+
+  void setEdge(const char * e, unsigned len);
+
+  char *            edge;     // the reversed labels from the parent, lower case
+  unsigned          edgelen;
+  unsigned          labellen; // length of the first label of the edge
+  uint32_t          hash;     // hash of the first label of the edge
+  SSLCertContext *  exact;
+  SSLCertContext *  wildcard;
+
+  // The children, open addressed by the hash of their first label. There is at most one child for
+  // each first label.
+  SSLNameNode **    children;
+  unsigned          nchildren;
+  unsigned          nslots;
+};
+
 struct SSLContextStorage
 {
   SSLContextStorage();
   ~SSLContextStorage();
 
-  bool insert(SSL_CTX * ctx, const char * name);
-  SSL_CTX * lookup(const char * name) const;
+  bool insert(SSLCertContext * cc, const char * name);
+  SSLCertContext * lookup(const char * name) const;
+
+  // SSL_CTXs inserted directly, by pointer, so that each one gets a single SSLCertContext.
+  InkHashTable *  made;
+  // Certificates by the configuration that made them.
+  InkHashTable *  specs;
 
 private:
-  struct SSLEntry
-  {
-    explicit SSLEntry(SSL_CTX * c) : ctx(c) {}
+  SSLNameNode     root;
+};
 
-    void Print() const { Debug("ssl", "SSLEntry=%p SSL_CTX=%p", this, ctx); }
+SSLCertContext::SSLCertContext(SSL_CTX * c)
+  : ctx(c), make_failed(false)
+{
+  ink_mutex_init(&this->mutex, "SSLCertContext");
+}
 
-    SSL_CTX * ctx;
-    LINK(SSLEntry, link);
-  };
+SSLCertContext::~SSLCertContext()
+{
+  SSL_CTX_free(this->ctx);
+  ink_mutex_destroy(&this->mutex);
+}
 
-  Trie<SSLEntry>  wildcards;
-  InkHashTable *  hostnames;
-  Vec<SSL_CTX *>  references;
-};
+SSL_CTX *
+SSLCertContext::get()
+{
+  // Once there is a context it never changes, so only the first handshakes need the lock.
+  if (likely(this->ctx != NULL) || this->make_failed) {
+    return this->ctx;
+  }
+
+  ink_scoped_mutex lock(this->mutex);
+
+  if (this->ctx == NULL && !this->make_failed) {
+    SSL_CTX * c = this->make();
+
+    if (c) {
+      ink_atomic_swap(&this->ctx, c);
+    } else {
+      // Don't try again on every handshake; reloading the configuration makes a new one.
+      this->make_failed = true;
+    }
+  }
+
+  return this->ctx;
+}
+
+static void
+ssl_cert_context_release(SSLCertContext * cc)
+{
+  if (cc && cc->refcount_dec() == 0) {
+    cc->free();
+  }
+}
 
 SSLCertLookup::SSLCertLookup()
   : ssl_storage(NEW(new SSLContextStorage())), ssl_default(NULL)
@@ -105,60 +168,110 @@ SSLCertLookup::~SSLCertLookup()
 SSL_CTX *
 SSLCertLookup::findInfoInHash(const char * address) const
 {
-  return this->ssl_storage->lookup(address);
+  SSLCertContext * cc = this->ssl_storage->lookup(address);
+  return cc ? cc->get() : NULL;
 }
 
 SSL_CTX *
 SSLCertLookup::findInfoInHash(const IpEndpoint& address) const
 {
-  SSL_CTX * ctx;
+  SSLCertContext * cc;
   SSLAddressLookupKey key(address);
 
   // First try the full address.
-  if ((ctx = this->ssl_storage->lookup(key.get()))) {
-    return ctx;
+  if ((cc = this->ssl_storage->lookup(key.get()))) {
+    return cc->get();
   }
 
   // If that failed, try the address without the port.
   if (address.port()) {
     key.split();
-    return this->ssl_storage->lookup(key.get());
+    if ((cc = this->ssl_storage->lookup(key.get()))) {
+      return cc->get();
+    }
   }
 
   return NULL;
 }
 
+bool
+SSLCertLookup::insert(SSLCertContext * cc, const char * name)
+{
+  return this->ssl_storage->insert(cc, name);
+}
+
+bool
+SSLCertLookup::insert(SSLCertContext * cc, const IpEndpoint& address)
+{
+  SSLAddressLookupKey key(address);
+  return this->ssl_storage->insert(cc, key.get());
+}
+
+// Wrap a context that the caller made in a single SSLCertContext, however many times it is inserted.
+static SSLCertContext *
+ssl_made_context(InkHashTable * made, SSL_CTX * ctx)
+{
+  InkHashTableValue value;
+
+  if (ink_hash_table_lookup(made, (const char *)ctx, &value)) {
+    return (SSLCertContext *)value;
+  }
+
+  SSLCertContext * cc = NEW(new SSLCertContext(ctx));
+
+  cc->refcount_inc();
+  ink_hash_table_insert(made, (const char *)ctx, cc);
+  return cc;
+}
+
 bool
 SSLCertLookup::insert(SSL_CTX * ctx, const char * name)
 {
-  return this->ssl_storage->insert(ctx, name);
+  return this->ssl_storage->insert(ssl_made_context(this->ssl_storage->made, ctx), name);
 }
 
 bool
 SSLCertLookup::insert(SSL_CTX * ctx, const IpEndpoint& address)
 {
-  SSLAddressLookupKey key(address);
-  return this->ssl_storage->insert(ctx, key.get());
+  return this->insert(ssl_made_context(this->ssl_storage->made, ctx), address);
 }
 
-struct ats_wildcard_matcher
+void
+SSLCertLookup::remember(const char * spec, SSLCertContext * cc)
 {
-  ats_wildcard_matcher() {
-    if (regex.compile("^\\*\\.[^\\*.]+") != 0) {
-      Fatal("failed to compile TLS wildcard matching regex");
-    }
+  InkHashTableValue value;
+
+  cc->refcount_inc();
+  if (ink_hash_table_lookup(this->ssl_storage->specs, spec, &value)) {
+    ssl_cert_context_release((SSLCertContext *)value);
   }
 
-  ~ats_wildcard_matcher() {
+  ink_hash_table_insert(this->ssl_storage->specs, spec, cc);
+}
+
+SSLCertContext *
+SSLCertLookup::recall(const char * spec) const
+{
+  InkHashTableValue value;
+
+  if (ink_hash_table_lookup(this->ssl_storage->specs, spec, &value)) {
+    return (SSLCertContext *)value;
   }
 
-  bool match(const char * hostname) const {
-    return regex.match(hostname) != -1;
+  return NULL;
+}
+
+// A wildcard is "*." followed by a name whose first label has no '*' in it.
+static bool
+ssl_wildcard_name(const char * name)
+{
+  if (name[0] != '*' || name[1] != '.') {
+    return false;
   }
 
-private:
-  DFA regex;
-};
+  unsigned len = strcspn(name + 2, "*.");
+  return len > 0 && name[2 + len] != '*';
+}
 
 static char *
 reverse_dns_name(const char * hostname, char (&reversed)[TS_MAX_HOST_NAME_LEN+1])
@@ -198,90 +311,260 @@ reverse_dns_name(const char * hostname, char (&reversed)[TS_MAX_HOST_NAME_LEN+1]
   return ptr;
 }
 
+static uint32_t
+ssl_label_hash(const char * label, unsigned len)
+{
+  uint32_t hash = 2166136261u; // FNV-1a
+
+  for (unsigned i = 0; i < len; ++i) {
+    hash = (hash ^ (unsigned char)ParseRules::ink_tolower(label[i])) * 16777619u;
+  }
+
+  return hash;
+}
+
+static unsigned
+ssl_label_length(const char * name, unsigned len)
+{
+  const char * dot = (const char *)memchr(name, '.', len);
+  return dot ? dot - name : len;
+}
+
+SSLNameNode::SSLNameNode(const char * e, unsigned len)
+  : edge(NULL), edgelen(0), labellen(0), hash(0), exact(NULL), wildcard(NULL), children(NULL), nchildren(0), nslots(0)
+{
+  this->setEdge(e, len);
+}
+
+SSLNameNode::~SSLNameNode()
+{
+  for (unsigned i = 0; i < this->nslots; ++i) {
+    delete this->children[i];
+  }
+
+  ssl_cert_context_release(this->exact);
+  ssl_cert_context_release(this->wildcard);
+  ats_free(this->children);
+  ats_free(this->edge);
+}
+
+void
+SSLNameNode::setEdge(const char * e, unsigned len)
+{
+  char * copy = ats_strndup(e, len);
+
+  ats_free(this->edge);
+  this->edge = copy;
+  this->edgelen = len;
+  this->labellen = ssl_label_length(copy, len);
+  this->hash = ssl_label_hash(copy, this->labellen);
+}
+
+SSLNameNode *
+SSLNameNode::child(const char * label, unsigned len, uint32_t h) const
+{
+  if (this->nslots == 0) {
+    return NULL;
+  }
+
+  for (unsigned i = h & (this->nslots - 1); this->children[i]; i = (i + 1) & (this->nslots - 1)) {
+    SSLNameNode * node = this->children[i];
+    if (node->hash == h && node->labellen == len && strncasecmp(node->edge, label, len) == 0) {
+      return node;
+    }
+  }
+
+  return NULL;
+}
+
+void
+SSLNameNode::adopt(SSLNameNode * node)
+{
+  // Keep the table at most half full.
+  if ((this->nchildren + 1) * 2 > this->nslots) {
+    SSLNameNode ** old = this->children;
+    unsigned oldslots = this->nslots;
+
+    this->nslots = oldslots ? oldslots * 2 : 2;
+    this->children = (SSLNameNode **)ats_calloc(this->nslots, sizeof(SSLNameNode *));
+    this->nchildren = 0;
+
+    for (unsigned i = 0; i < oldslots; ++i) {
+      if (old[i]) {
+        this->adopt(old[i]);
+      }
+    }
+
+    ats_free(old);
+  }
+
+  unsigned i = node->hash & (this->nslots - 1);
+  while (this->children[i]) {
+    i = (i + 1) & (this->nslots - 1);
+  }
+
+  this->children[i] = node;
+  ++this->nchildren;
+}
+
+void
+SSLNameNode::replace(SSLNameNode * node, SSLNameNode * with)
+{
+  for (unsigned i = node->hash & (this->nslots - 1); this->children[i]; i = (i + 1) & (this->nslots - 1)) {
+    if (this->children[i] == node) {
+      this->children[i] = with;
+      return;
+    }
+  }
+
+  ink_release_assert(!"replacing a node that isn't a child");
+}
+
 SSLContextStorage::SSLContextStorage()
-  :wildcards(), hostnames(ink_hash_table_create(InkHashTableKeyType_String))
+  : made(ink_hash_table_create(InkHashTableKeyType_Word)), specs(ink_hash_table_create(InkHashTableKeyType_String))
 {
 }
 
 SSLContextStorage::~SSLContextStorage()
 {
-  for (unsigned i = 0; i < this->references.count(); ++i) {
-    SSL_CTX_free(this->references[i]);
+  InkHashTableIteratorState state;
+  InkHashTableEntry * entry;
+
+  for (entry = ink_hash_table_iterator_first(this->made, &state); entry; entry = ink_hash_table_iterator_next(this->made, &state)) {
+    ssl_cert_context_release((SSLCertContext *)ink_hash_table_entry_value(this->made, entry));
   }
 
-  ink_hash_table_destroy(this->hostnames);
+  for (entry = ink_hash_table_iterator_first(this->specs, &state); entry; entry = ink_hash_table_iterator_next(this->specs, &state)) {
+    ssl_cert_context_release((SSLCertContext *)ink_hash_table_entry_value(this->specs, entry));
+  }
+
+  ink_hash_table_destroy(this->made);
+  ink_hash_table_destroy(this->specs);
 }
 
 bool
-SSLContextStorage::insert(SSL_CTX * ctx, const char * name)
-{
-  ats_wildcard_matcher wildcard;
-  bool inserted = true;
-
-  if (wildcard.match(name)) {
-    // We turn wildcards into the reverse DNS form, then insert them into the trie
-    // so that we can do a longest match lookup.
-    char namebuf[TS_MAX_HOST_NAME_LEN + 1];
-    char * reversed;
-    xptr<SSLEntry> entry;
-
-    reversed = reverse_dns_name(name + 2, namebuf);
-    if (!reversed) {
-      Error("wildcard name '%s' is too long", name);
-      return false;
+SSLContextStorage::insert(SSLCertContext * cc, const char * name)
+{
+  char namebuf[TS_MAX_HOST_NAME_LEN + 1];
+  bool wildcard = ssl_wildcard_name(name);
+  char * key;
+  unsigned keylen;
+  SSLNameNode * node = &this->root;
+
+  // A wildcard goes on the node for the name that it is a wildcard of.
+  key = reverse_dns_name(wildcard ? name + 2 : name, namebuf);
+  if (!key) {
+    Error("certificate name '%s' is too long", name);
+    return false;
+  }
+
+  keylen = strlen(key);
+  for (unsigned i = 0; i < keylen; ++i) {
+    key[i] = ParseRules::ink_tolower(key[i]);
+  }
+
+  Debug("ssl", "indexing %s'%s' as '%s' with certificate %p", wildcard ? "wildcard " : "", name, key, cc);
+
+  while (keylen > 0) {
+    unsigned len = ssl_label_length(key, keylen);
+    SSLNameNode * next = node->child(key, len, ssl_label_hash(key, len));
+
+    if (next == NULL) {
+      next = NEW(new SSLNameNode(key, keylen));
+      node->adopt(next);
+      node = next;
+      break;
     }
 
-    Debug("ssl", "indexed wildcard certificate for '%s' as '%s' with SSL_CTX %p", name, reversed, ctx);
-    entry = new SSLEntry(ctx);
-    inserted = this->wildcards.Insert(reversed, entry, 0 /* rank */, -1 /* keylen */);
-    if (inserted) {
-      entry.release();
+    // Match as many whole labels of the edge as we can. The first label always matches.
+    unsigned matched = next->labellen;
+    while (matched < next->edgelen && matched < keylen && key[matched] == '.') {
+      unsigned end = matched + 1 + ssl_label_length(key + matched + 1, keylen - matched - 1);
+
+      if (end > next->edgelen || memcmp(next->edge + matched, key + matched, end - matched) != 0 ||
+          (end < next->edgelen && next->edge[end] != '.')) {
+        break;
+      }
+
+      matched = end;
+    }
+
+    // If the key leaves the edge part way, split the edge there.
+    if (matched < next->edgelen) {
+      SSLNameNode * split = NEW(new SSLNameNode(next->edge, matched));
+
+      node->replace(next, split);
+      next->setEdge(next->edge + matched + 1, next->edgelen - matched - 1);
+      split->adopt(next);
+      next = split;
     }
-  } else {
-    Debug("ssl", "indexed '%s' with SSL_CTX %p", name, ctx);
-    ink_hash_table_insert(this->hostnames, name, (void *)ctx);
-  }
 
-  // Keep a unique reference to the SSL_CTX, so that we can free it later. Since we index by name, multiple
-  // certificates can be indexed for the same name. If this happens, we will overwrite the previous pointer
-  // and leak a context. So if we insert a certificate, keep an ownership reference to it.
-  if (inserted) {
-    if (this->references.in(ctx) == NULL) {
-      this->references.push_back(ctx);
+    node = next;
+    if (matched == keylen) {
+      break;
     }
+
+    key += matched + 1;
+    keylen -= matched + 1;
+  }
+
+  SSLCertContext ** slot = wildcard ? &node->wildcard : &node->exact;
+
+  // The first certificate for a name wins.
+  if (*slot) {
+    Debug("ssl", "'%s' already has certificate %p", name, *slot);
+    return false;
   }
 
-  return inserted;
+  cc->refcount_inc();
+  *slot = cc;
+  return true;
 }
 
-SSL_CTX *
+SSLCertContext *
 SSLContextStorage::lookup(const char * name) const
 {
-  InkHashTableValue value;
-
-  if (ink_hash_table_lookup(const_cast<InkHashTable *>(this->hostnames), name, &value)) {
-    return (SSL_CTX *)value;
+  char namebuf[TS_MAX_HOST_NAME_LEN + 1];
+  char * key;
+  unsigned keylen;
+  const SSLNameNode * node = &this->root;
+  SSLCertContext * wildcard = NULL;
+
+  key = reverse_dns_name(name, namebuf);
+  if (!key) {
+    Error("failed to reverse hostname name '%s' is too long", name);
+    return NULL;
   }
 
-  if (!this->wildcards.Empty()) {
-    char namebuf[TS_MAX_HOST_NAME_LEN + 1];
-    char * reversed;
-    SSLEntry * entry;
+  // Walk down the labels once. An exact name wins, then the wildcard of the name one label up.
+  // As a last resort a wildcard also stands for the bare name it is a wildcard of.
+  keylen = strlen(key);
+  while (keylen > 0) {
+    unsigned len = ssl_label_length(key, keylen);
+
+    node = node->child(key, len, ssl_label_hash(key, len));
+    if (node == NULL || node->edgelen > keylen || strncasecmp(node->edge, key, node->edgelen) != 0 ||
+        (node->edgelen < keylen && key[node->edgelen] != '.')) {
+      break;
+    }
 
-    reversed = reverse_dns_name(name, namebuf);
-    if (!reversed) {
-      Error("failed to reverse hostname name '%s' is too long", name);
-      return NULL;
+    if (node->edgelen == keylen) {
+      if (node->exact) {
+        return node->exact;
+      }
+      return wildcard ? wildcard : node->wildcard;
     }
 
-    Debug("ssl", "attempting wildcard match for %s", reversed);
-    entry = this->wildcards.Search(reversed);
-    if (entry) {
-      return entry->ctx;
+    key += node->edgelen + 1;
+    keylen -= node->edgelen + 1;
+
+    // A wildcard covers exactly one more label.
+    if (node->wildcard && ssl_label_length(key, keylen) == keylen) {
+      wildcard = node->wildcard;
     }
   }
 
-  return NULL;
+  return wildcard;
 }
 
 #if TS_HAS_TESTS
@@ -289,15 +572,16 @@ SSLContextStorage::lookup(const char * name) const
 REGRESSION_TEST(SSLWildcardMatch)(RegressionTest * t, int /* atype ATS_UNUSED */, int * pstatus)
 {
   TestBox box(t, pstatus);
-  ats_wildcard_matcher wildcard;
 
   box = REGRESSION_TEST_PASSED;
 
-  box.check(wildcard.match("foo.com") == false, "foo.com is not a wildcard");
-  box.check(wildcard.match("*.foo.com") == true, "*.foo.com not a wildcard");
-  box.check(wildcard.match("bar*.foo.com") == false, "bar*.foo.com not a wildcard");
-  box.check(wildcard.match("*") == false, "* is not a wildcard");
-  box.check(wildcard.match("") == false, "'' is not a wildcard");
+  box.check(ssl_wildcard_name("foo.com") == false, "foo.com is not a wildcard");
+  box.check(ssl_wildcard_name("*.foo.com") == true, "*.foo.com not a wildcard");
+  box.check(ssl_wildcard_name("bar*.foo.com") == false, "bar*.foo.com not a wildcard");
+  box.check(ssl_wildcard_name("*.f*o.com") == false, "*.f*o.com is not a wildcard");
+  box.check(ssl_wildcard_name("*.") == false, "*. is not a wildcard");
+  box.check(ssl_wildcard_name("*") == false, "* is not a wildcard");
+  box.check(ssl_wildcard_name("") == false, "'' is not a wildcard");
 }
 
 REGRESSION_TEST(SSLReverseHostname)(RegressionTest * t, int /* atype ATS_UNUSED */, int * pstatus)
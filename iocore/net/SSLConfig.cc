@@ -41,8 +41,13 @@
 
 int SSLConfig::configid = 0;
 int SSLCertificateConfig::configid = 0;
+int SSLTicketKeyConfig::configid = 0;
 
 static ConfigUpdateHandler<SSLCertificateConfig> * sslCertUpdate;
+static ConfigUpdateHandler<SSLTicketKeyConfig> * sslTicketKeyUpdate;
+
+// How often to look for a rewritten session ticket key file.
+#define SSL_TICKET_KEY_CHECK_INTERVAL HRTIME_SECONDS(60)
 
 SSLConfigParams::SSLConfigParams()
 {
@@ -63,6 +68,8 @@ SSLConfigParams::SSLConfigParams()
   ssl_ctx_options = 0;
   ssl_session_cache = SSL_SESSION_CACHE_MODE_SERVER;
   ssl_session_cache_size = 1024*20;
+  ssl_session_cache_num_buckets = 256;
+  multicert_load_on_demand = 0;
 }
 
 SSLConfigParams::~SSLConfigParams()
@@ -170,6 +177,7 @@ SSLConfigParams::initialize()
   REC_ReadConfigStringAlloc(multicert_config_file, "proxy.config.ssl.server.multicert.filename");
   set_paths_helper(Layout::get()->sysconfdir, multicert_config_file, NULL, &configFilePath);
   ats_free(multicert_config_file);
+  REC_ReadConfigInt32(multicert_load_on_demand, "proxy.config.ssl.server.multicert.load_on_demand");
 
   REC_ReadConfigStringAlloc(ssl_server_private_key_path, "proxy.config.ssl.server.private_key.path");
   set_paths_helper(ssl_server_private_key_path, NULL, &serverKeyPathOnly, NULL);
@@ -183,6 +191,7 @@ SSLConfigParams::initialize()
   // SSL session cache configurations
   REC_ReadConfigInteger(ssl_session_cache, "proxy.config.ssl.session_cache");
   REC_ReadConfigInteger(ssl_session_cache_size, "proxy.config.ssl.session_cache.size");
+  REC_ReadConfigInteger(ssl_session_cache_num_buckets, "proxy.config.ssl.session_cache.num_buckets");
 
   // ++++++++++++++++++++++++ Client part ++++++++++++++++++++
   client_verify_depth = 7;
@@ -253,12 +262,17 @@ SSLCertificateConfig::reconfigure()
 {
   SSLConfig::scoped_config params;
   SSLCertLookup * lookup = NEW(new SSLCertLookup());
+  SSLCertLookup * previous = configid ? acquire() : NULL;
 
-  if (SSLParseCertificateConfiguration(params, lookup)) {
+  if (SSLParseCertificateConfiguration(params, lookup, previous)) {
     configid = configProcessor.set(configid, lookup);
   } else {
     delete lookup;
   }
+
+  if (previous) {
+    release(previous);
+  }
 }
 
 SSLCertLookup *
@@ -273,3 +287,105 @@ SSLCertificateConfig::release(SSLCertLookup * lookup)
   configProcessor.release(configid, lookup);
 }
 
+// The ticket key file can be changed at run time, so it is read from
+// the record rather than kept with the rest of the SSL configuration.
+static char *
+ssl_ticket_key_path()
+{
+  SSLConfig::scoped_config params;
+  xptr<char> name(REC_ConfigReadString("proxy.config.ssl.server.ticket_key.filename"));
+
+  if (!name || *(const char *)name == '\0') {
+    return NULL;
+  }
+  return Layout::relative_to(params->serverCertPathOnly, name);
+}
+
+// Watch the key file for a rotation, which rewrites it in place.
+struct SSLTicketKeyWatcher : public Continuation
+{
+  time_t mtime;
+
+  SSLTicketKeyWatcher() : Continuation(new_ProxyMutex()), mtime(0) {
+    SET_HANDLER(&SSLTicketKeyWatcher::check);
+  }
+
+  int check(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */) {
+    xptr<char> path(ssl_ticket_key_path());
+    struct stat st;
+
+    if (path && stat(path, &st) == 0 && st.st_mtime != mtime) {
+      // The first look only notes the time of the keys loaded at startup.
+      if (mtime) {
+        SSLTicketKeyConfig::reconfigure();
+      }
+      mtime = st.st_mtime;
+    }
+    return EVENT_CONT;
+  }
+};
+
+static bool
+ssl_load_ticket_keys(const char * path, SSLTicketKeyBlock * block)
+{
+  int len = 0;
+  xptr<char> buf(readIntoBuffer(path, __func__, &len));
+
+  if (!buf) {
+    Error("failed to read SSL session ticket keys from %s", path);
+    return false;
+  }
+  if (len <= 0 || len % sizeof(SSLTicketKey) != 0) {
+    Error("SSL session ticket key file %s must hold a whole number of %u byte keys", path, (unsigned)sizeof(SSLTicketKey));
+    return false;
+  }
+
+  block->num_keys = len / sizeof(SSLTicketKey);
+  block->keys = (SSLTicketKey *)ats_malloc(len);
+  memcpy(block->keys, buf, len);
+  // Don't leave key material lying around in freed memory.
+  memset(buf, 0, len);
+  Note("loaded %u SSL session ticket keys from %s", block->num_keys, path);
+  return true;
+}
+
+void
+SSLTicketKeyConfig::startup()
+{
+  sslTicketKeyUpdate = NEW(new ConfigUpdateHandler<SSLTicketKeyConfig>());
+  sslTicketKeyUpdate->attach("proxy.config.ssl.server.ticket_key.filename");
+
+  reconfigure();
+
+  SSLTicketKeyWatcher * watcher = NEW(new SSLTicketKeyWatcher());
+  watcher->handleEvent(EVENT_NONE, NULL);
+  eventProcessor.schedule_every(watcher, SSL_TICKET_KEY_CHECK_INTERVAL, ET_CALL);
+}
+
+void
+SSLTicketKeyConfig::reconfigure()
+{
+  xptr<char> path(ssl_ticket_key_path());
+  SSLTicketKeyBlock * block = NEW(new SSLTicketKeyBlock());
+
+  // Keep the keys we have if the new ones can't be loaded.
+  if (path && ssl_load_ticket_keys(path, block)) {
+    configid = configProcessor.set(configid, block);
+  } else {
+    delete block;
+  }
+}
+
+SSLTicketKeyBlock *
+SSLTicketKeyConfig::acquire()
+{
+  // No keys until a key file has been loaded.
+  return configid ? (SSLTicketKeyBlock *)configProcessor.get(configid) : NULL;
+}
+
+void
+SSLTicketKeyConfig::release(SSLTicketKeyBlock * keys)
+{
+  if (keys)
+    configProcessor.release(configid, keys);
+}
@@ -69,16 +69,24 @@ SSLNetAccept::init_accept_per_thread()
   period = ACCEPT_PERIOD;
   NetAccept *a = this;
   n = eventProcessor.n_threads_for_type[SSLNetProcessor::ET_SSL];
+  // Without SSL threads these are the net threads, which share one block.
+  if (SSLNetProcessor::ET_SSL == ET_NET)
+    thread_stats = register_net_accept_thread_stats(ET_NET, "proxy.process.net.accepts_per_thread");
+  else
+    thread_stats = register_net_accept_thread_stats(SSLNetProcessor::ET_SSL, "proxy.process.net.accepts_per_thread.ssl");
   for (i = 0; i < n; i++) {
     if (i < n - 1) {
       a = NEW(new SSLNetAccept);
       *a = *this;
+      if (reuse_port)
+        listen_per_thread(a);
     } else
       a = this;
+    a->id = i;
     EThread *t = eventProcessor.eventthread[SSLNetProcessor::ET_SSL][i];
 
     PollDescriptor *pd = get_PollDescriptor(t);
-    if (ep.start(pd, this, EVENTIO_READ) < 0)
+    if (a->ep.start(pd, a, EVENTIO_READ) < 0)
       Debug("iocore_net", "error starting EventIO");
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period, etype);
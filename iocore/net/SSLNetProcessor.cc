@@ -33,6 +33,8 @@
 SSLNetProcessor   ssl_NetProcessor;
 NetProcessor&     sslNetProcessor = ssl_NetProcessor;
 EventType         SSLNetProcessor::ET_SSL;
+EventType         SSLNetProcessor::ET_SSL_HANDSHAKE;
+int               SSLNetProcessor::handshake_threads = 0;
 
 void
 SSLNetProcessor::cleanup(void)
@@ -51,6 +53,13 @@ SSLNetProcessor::start(int number_of_ssl_threads, size_t stacksize)
   SSLConfig::startup();
 
   if (HttpProxyPort::hasSSL()) {
+    SSLConfig::scoped_config params;
+
+    // The server contexts pick these up as they are made.
+    if (params->ssl_session_cache == SSLConfigParams::SSL_SESSION_CACHE_MODE_SERVER_ATS) {
+      ssl_session_cache = NEW(new SSLSessionCache(params->ssl_session_cache_size, params->ssl_session_cache_num_buckets));
+    }
+    SSLTicketKeyConfig::startup();
     SSLCertificateConfig::startup();
   }
 
@@ -70,6 +79,16 @@ SSLNetProcessor::start(int number_of_ssl_threads, size_t stacksize)
   }
 
   SSLNetProcessor::ET_SSL = eventProcessor.spawn_event_threads(number_of_ssl_threads, "ET_SSL", stacksize);
+
+  // The private key operations of the handshakes go to threads of their
+  // own, the ET_SSL threads only move the bytes.
+  if (HttpProxyPort::hasSSL()) {
+    REC_ReadConfigInteger(handshake_threads, "proxy.config.ssl.handshake.threads");
+    if (handshake_threads > 0) {
+      SSLNetProcessor::ET_SSL_HANDSHAKE = eventProcessor.spawn_event_threads(handshake_threads, "ET_SSL_HANDSHAKE", stacksize);
+      Debug("ssl", "running handshakes on %d threads", handshake_threads);
+    }
+  }
   return UnixNetProcessor::start(0, stacksize);
 }
 
@@ -147,6 +147,7 @@ ssl_read_from_net(UnixNetVConnection * vc, EThread * lthread, int64_t &ret)
       default:
         event = SSL_READ_ERROR;
         ret = errno;
+        sslvc->setSSLFatalError(true);
         SSLError("[SSL_NetVConnection::ssl_read_from_net]");
         break;
       }                         // switch
@@ -220,6 +221,10 @@ SSLNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
     if (ret == EVENT_ERROR) {
       this->read.triggered = 0;
       readSignalError(nh, err);
+    } else if (ret == SSL_HANDSHAKE_WANT_ASYNC) {
+      // Requeued when the handshake thread is done with the step.
+      nh->read_ready_list.remove(this);
+      nh->write_ready_list.remove(this);
     } else if (ret == SSL_HANDSHAKE_WANT_READ || ret == SSL_HANDSHAKE_WANT_ACCEPT) {
       read.triggered = 0;
       nh->read_ready_list.remove(this);
@@ -399,6 +404,7 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted, i
     case SSL_ERROR_SSL:
     default:
       r = -errno;
+      sslFatalError = true;
       Debug("ssl", "SSL_write-SSL_ERROR_SSL");
       SSLError("SSL_write");
       break;
@@ -410,6 +416,9 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted, i
 SSLNetVConnection::SSLNetVConnection():
   sslHandShakeComplete(false),
   sslClientConnection(false),
+  sslFatalError(false),
+  handShakeOffload(SSL_OFFLOAD_NONE),
+  sslHandShakeBegin(0),
   npnSet(NULL),
   npnEndpoint(NULL)
 {
@@ -433,13 +442,20 @@ SSLNetVConnection::free(EThread * t) {
   closed = 0;
   ink_assert(con.fd == NO_FD);
   if (ssl != NULL) {
-    /*if (sslHandShakeComplete)
-       SSL_set_shutdown(ssl, SSL_SENT_SHUTDOWN|SSL_RECEIVED_SHUTDOWN); */
+    // OpenSSL drops the session of a connection that was not shut down,
+    // which would leave no session to resume. We never send close_notify
+    // (the contexts are quiet), so mark it shut down once it is set up,
+    // unless it ended on a protocol error or alert.
+    if (sslHandShakeComplete && !sslFatalError)
+      SSL_set_shutdown(ssl, SSL_SENT_SHUTDOWN|SSL_RECEIVED_SHUTDOWN);
     SSL_free(ssl);
     ssl = NULL;
   }
   sslHandShakeComplete = false;
   sslClientConnection = false;
+  sslFatalError = false;
+  handShakeOffload = SSL_OFFLOAD_NONE;
+  offload.mutex.clear();
   npnSet = NULL;
 
   if (from_accept_thread) {
@@ -465,6 +481,7 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
         SSLError("SSL_StartHandShake");
         return EVENT_ERROR;
       }
+      sslHandShakeBegin = ink_get_hrtime();
     }
 
     return sslServerHandShakeEvent(err);
@@ -485,12 +502,26 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
   int ret;
   int ssl_error;
 
-  ret = SSL_accept(ssl);
+  if (SSLNetProcessor::handshake_threads > 0) {
+    switch (handShakeOffload) {
+    case SSL_OFFLOAD_NONE:
+      sslHandShakeOffload();
+      return SSL_HANDSHAKE_WANT_ASYNC;
+    case SSL_OFFLOAD_RUNNING:
+      return SSL_HANDSHAKE_WANT_ASYNC;
+    }
+    handShakeOffload = SSL_OFFLOAD_NONE;
+    ssl_error = offload.ssl_error;
+    if (ssl_error != SSL_ERROR_NONE)
+      err = offload.err;
+  } else {
+    ret = SSL_accept(ssl);
 
-  ssl_error = SSL_get_error(ssl, ret);
-  if (ssl_error != SSL_ERROR_NONE) {
-    err = errno;
-    SSLDebug("SSL handshake error: %s (%d), errno=%d", SSLErrorName(ssl_error), ssl_error, err);
+    ssl_error = SSL_get_error(ssl, ret);
+    if (ssl_error != SSL_ERROR_NONE) {
+      err = errno;
+      SSLDebug("SSL handshake error: %s (%d), errno=%d", SSLErrorName(ssl_error), ssl_error, err);
+    }
   }
 
   switch (ssl_error) {
@@ -512,6 +543,13 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
     }
     sslHandShakeComplete = 1;
 
+    if (SSL_session_reused(ssl)) {
+      NET_INCREMENT_DYN_STAT(ssl_resumed_handshake_stat);
+    } else {
+      NET_INCREMENT_DYN_STAT(ssl_full_handshake_stat);
+    }
+    NET_SUM_DYN_STAT(ssl_handshake_time_stat, (ink_get_hrtime() - sslHandShakeBegin) / HRTIME_USECOND);
+
 #if TS_USE_TLS_NPN
     {
       const unsigned char * proto = NULL;
@@ -554,6 +592,122 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
 
 }
 
+//
+// Hand the next step of the handshake to a handshake thread. The
+// connection stays off the ready lists until the step comes back.
+//
+void
+SSLNetVConnection::sslHandShakeOffload()
+{
+  EThread *t = eventProcessor.assign_thread(SSLNetProcessor::ET_SSL_HANDSHAKE);
+  SSLHandShakeOffload *o = &offload;
+
+  // The handshake thread reads whatever is there; a read that triggers
+  // from now on may have come in after it looked.
+  read.triggered = 0;
+  handShakeOffload = SSL_OFFLOAD_RUNNING;
+  o->vc = this;
+  o->queued_at = ink_get_hrtime_internal();
+  o->mutex = t->mutex;
+  SET_CONTINUATION_HANDLER(o, &SSLHandShakeOffload::runEvent);
+  t->schedule_imm(o);
+  NET_INCREMENT_DYN_STAT(ssl_handshake_offloaded_stat);
+}
+
+//
+// Back on the thread of the connection. A step that wants more to read
+// or room to write waits for the socket like an inline one would; any
+// other outcome is picked up by sslServerHandShakeEvent() on the side
+// that drives the handshake.
+//
+void
+SSLNetVConnection::sslHandShakeOffloadDone()
+{
+  handShakeOffload = SSL_OFFLOAD_DONE;
+  if (closed) {
+    close_UnixNetVConnection(this, thread);
+    return;
+  }
+
+  switch (offload.ssl_error) {
+  case SSL_ERROR_WANT_READ:
+    handShakeOffload = SSL_OFFLOAD_NONE;
+    if (read.triggered && read.enabled)
+      nh->read_ready_list.in_or_enqueue(this);
+    break;
+
+  case SSL_ERROR_WANT_WRITE:
+    {
+      // The socket may have drained between the handshake thread
+      // filling it and now, ask rather than wait for an edge that
+      // has come and gone.
+      struct pollfd pfd;
+
+      handShakeOffload = SSL_OFFLOAD_NONE;
+      pfd.fd = con.fd;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      write.triggered = (::poll(&pfd, 1, 0) > 0);
+      if (write.triggered && write.enabled)
+        nh->write_ready_list.in_or_enqueue(this);
+    }
+    break;
+
+  default:
+    if (read.enabled && read.vio.op == VIO::READ) {
+      read.triggered = 1;
+      nh->read_ready_list.in_or_enqueue(this);
+    } else {
+      write.triggered = 1;
+      if (write.enabled)
+        nh->write_ready_list.in_or_enqueue(this);
+    }
+    break;
+  }
+}
+
+int
+SSLHandShakeOffload::runEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  ink_hrtime start = ink_get_hrtime_internal();
+  EThread *t = vc->thread;
+  int ret;
+
+  NET_SUM_DYN_STAT(ssl_handshake_queue_time_stat, (start - queued_at) / HRTIME_USECOND);
+  // Another connection's step may have left errors on this thread.
+  ERR_clear_error();
+  ret = SSL_accept(vc->ssl);
+  // The error queue and errno are this thread's, so the error is reported
+  // here; the thread of the connection would find the queue empty.
+  ssl_error = SSL_get_error(vc->ssl, ret);
+  if (ssl_error != SSL_ERROR_NONE) {
+    unsigned long e = ERR_get_error();
+    char buf[256];
+
+    err = errno;
+    SSLDebug("SSL handshake error: %s (%d), errno=%d, %s", SSLErrorName(ssl_error), ssl_error, err,
+             e ? ERR_error_string(e, buf) : "no SSL error");
+  }
+  NET_SUM_DYN_STAT(ssl_handshake_run_time_stat, (ink_get_hrtime_internal() - start) / HRTIME_USECOND);
+
+  // The outcome touches the ready lists of the NetHandler.
+  mutex = vc->nh->mutex;
+  SET_HANDLER(&SSLHandShakeOffload::doneEvent);
+  t->schedule_imm_signal(this);
+  return EVENT_DONE;
+}
+
+int
+SSLHandShakeOffload::doneEvent(int /* event ATS_UNUSED */, Event * e)
+{
+  MUTEX_TRY_LOCK(lock, vc->mutex, e->ethread);
+  if (!lock) {
+    e->schedule_in(NET_RETRY_DELAY);
+    return EVENT_CONT;
+  }
+  vc->sslHandShakeOffloadDone();
+  return EVENT_DONE;
+}
 
 int
 SSLNetVConnection::sslClientHandShakeEvent(int &err)
@@ -91,6 +91,15 @@ struct SSLNextProtocolTrampoline : public Continuation
     netvc = dynamic_cast<SSLNetVConnection *>(vio->vc_server);
     ink_assert(netvc != NULL);
 
+    // The handshake failed or never finished, there is nothing to hand
+    // on. Passing the connection on would leave the session waiting on a
+    // socket that has already said all it will.
+    if (event != VC_EVENT_READ_COMPLETE) {
+      netvc->do_io(VIO::CLOSE);
+      delete this;
+      return EVENT_CONT;
+    }
+
     plugin = netvc->endpoint();
     if (plugin) {
       send_plugin_event(plugin, NET_EVENT_ACCEPT, netvc);
@@ -0,0 +1,266 @@
+/** @file
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "ink_config.h"
+#include "P_Net.h"
+
+SSLSessionCache * ssl_session_cache = NULL;
+
+SSLSessionStoreGetFunc SSLSessionCache::store_get = NULL;
+SSLSessionStorePutFunc SSLSessionCache::store_put = NULL;
+SSLSessionStoreRemoveFunc SSLSessionCache::store_remove = NULL;
+
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) // the session ID handed to the get callback became const
+typedef const unsigned char * ink_ssl_session_id_t;
+#else
+typedef unsigned char * ink_ssl_session_id_t;
+#endif
+
+struct SSLSessionEntry
+{
+  unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+  int id_len;
+  time_t expires;
+  int len;
+  unsigned char * der;
+
+  LINK(SSLSessionEntry, link);
+
+  bool matches(const unsigned char * _id, int _id_len) const {
+    return id_len == _id_len && memcmp(id, _id, id_len) == 0;
+  }
+};
+
+struct SSLSessionBucket
+{
+  ink_mutex lock;
+  Queue<SSLSessionEntry> lru;   // most recently used first
+  int count;
+
+  SSLSessionEntry * find(const unsigned char * id, int id_len) const {
+    for (SSLSessionEntry * e = lru.head; e; e = e->link.next) {
+      if (e->matches(id, id_len))
+        return e;
+    }
+    return NULL;
+  }
+
+  void free_entry(SSLSessionEntry * e) {
+    lru.remove(e);
+    --count;
+    ats_free(e);
+  }
+};
+
+SSLSessionCache::SSLSessionCache(int size, int _nbuckets)
+  : buckets(NULL), nbuckets(_nbuckets > 0 ? _nbuckets : 1), bucket_size(0)
+{
+  bucket_size = size / nbuckets;
+  if (bucket_size < 1)
+    bucket_size = 1;
+  buckets = new SSLSessionBucket[nbuckets];
+  for (int i = 0; i < nbuckets; i++) {
+    ink_mutex_init(&buckets[i].lock, "SSLSessionBucket");
+    buckets[i].count = 0;
+  }
+  Debug("ssl", "shared session cache of %d buckets of %d sessions", nbuckets, bucket_size);
+}
+
+SSLSessionCache::~SSLSessionCache()
+{
+  for (int i = 0; i < nbuckets; i++) {
+    SSLSessionEntry * e;
+    while ((e = buckets[i].lru.head) != NULL)
+      buckets[i].free_entry(e);
+    ink_mutex_destroy(&buckets[i].lock);
+  }
+  delete[] buckets;
+}
+
+void
+SSLSessionCache::set_store(SSLSessionStoreGetFunc get, SSLSessionStorePutFunc put, SSLSessionStoreRemoveFunc remove)
+{
+  store_get = get;
+  store_put = put;
+  store_remove = remove;
+}
+
+SSLSessionBucket *
+SSLSessionCache::bucket_for(const unsigned char * id, int id_len) const
+{
+  // FNV-1a; session IDs are random, but tickets and the external store
+  // let clients choose what they present.
+  uint32_t h = 2166136261U;
+  for (int i = 0; i < id_len; i++)
+    h = (h ^ id[i]) * 16777619U;
+  return &buckets[h % nbuckets];
+}
+
+void
+SSLSessionCache::insert_der(const unsigned char * id, int id_len, const unsigned char * der, int len, time_t expires)
+{
+  SSLSessionBucket * b = bucket_for(id, id_len);
+  SSLSessionEntry * e = (SSLSessionEntry *)ats_malloc(sizeof(SSLSessionEntry) + len);
+
+  memset(e, 0, sizeof(SSLSessionEntry));
+  memcpy(e->id, id, id_len);
+  e->id_len = id_len;
+  e->expires = expires;
+  e->len = len;
+  e->der = (unsigned char *)(e + 1);
+  memcpy(e->der, der, len);
+
+  ink_mutex_acquire(&b->lock);
+  SSLSessionEntry * old = b->find(id, id_len);
+  if (old)
+    b->free_entry(old);
+  while (b->count >= bucket_size) {
+    b->free_entry(b->lru.tail);
+    SSL_INCREMENT_DYN_STAT(ssl_session_cache_eviction_stat);
+  }
+  b->lru.push(e);
+  b->count++;
+  ink_mutex_release(&b->lock);
+}
+
+SSL_SESSION *
+SSLSessionCache::get(const unsigned char * id, int id_len)
+{
+  SSLSessionBucket * b = bucket_for(id, id_len);
+  unsigned char der[SSL_SESSION_MAX_DER];
+  const unsigned char * p = der;
+  time_t now = time(NULL);
+  int len = 0;
+  bool found = false;
+
+  if (id_len <= 0 || id_len > SSL_MAX_SSL_SESSION_ID_LENGTH)
+    return NULL;
+
+  ink_mutex_acquire(&b->lock);
+  SSLSessionEntry * e = b->find(id, id_len);
+  if (e && e->expires <= now) {
+    b->free_entry(e);
+    e = NULL;
+  }
+  if (e) {
+    // the DER goes out of the lock by copy, the entry may be evicted
+    b->lru.remove(e);
+    b->lru.push(e);
+    len = e->len;
+    memcpy(der, e->der, len);
+    found = true;
+  }
+  ink_mutex_release(&b->lock);
+
+  if (found) {
+    SSL_INCREMENT_DYN_STAT(ssl_session_cache_hit_stat);
+  } else if (store_get && (len = store_get(id, id_len, der, sizeof(der))) > 0 && len <= (int)sizeof(der)) {
+    SSL_INCREMENT_DYN_STAT(ssl_session_store_hit_stat);
+  } else {
+    SSL_INCREMENT_DYN_STAT(ssl_session_cache_miss_stat);
+    return NULL;
+  }
+
+  SSL_SESSION * session = d2i_SSL_SESSION(NULL, &p, len);
+  if (session && !found) {
+    // keep what the store gave us, it will be asked for again
+    insert_der(id, id_len, der, len, SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session));
+  }
+  return session;
+}
+
+void
+SSLSessionCache::insert(SSL_SESSION * session)
+{
+  unsigned id_len;
+  const unsigned char * id = SSL_SESSION_get_id(session, &id_len);
+  unsigned char der[SSL_SESSION_MAX_DER];
+  unsigned char * p = der;
+  int len = i2d_SSL_SESSION(session, NULL);
+  time_t expires = SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session);
+
+  if (id_len == 0 || len <= 0 || len > (int)sizeof(der)) {
+    Debug("ssl", "not caching a session of %d bytes", len);
+    return;
+  }
+  i2d_SSL_SESSION(session, &p);
+  insert_der(id, id_len, der, len, expires);
+  if (store_put)
+    store_put(id, id_len, der, len, expires);
+}
+
+void
+SSLSessionCache::remove(const unsigned char * id, int id_len)
+{
+  SSLSessionBucket * b = bucket_for(id, id_len);
+
+  ink_mutex_acquire(&b->lock);
+  SSLSessionEntry * e = b->find(id, id_len);
+  if (e)
+    b->free_entry(e);
+  ink_mutex_release(&b->lock);
+  if (store_remove)
+    store_remove(id, id_len);
+}
+
+static int
+ssl_new_cached_session(SSL * /* ssl ATS_UNUSED */, SSL_SESSION * session)
+{
+  ssl_session_cache->insert(session);
+  // We did not keep a reference to the session.
+  return 0;
+}
+
+static SSL_SESSION *
+ssl_get_cached_session(SSL * ssl, ink_ssl_session_id_t id, int len, int * copy)
+{
+  // The session is a new one we hand over, OpenSSL need not add a reference.
+  *copy = 0;
+
+  SSL_SESSION * session = ssl_session_cache->get(id, len);
+
+  // The cache is shared by all the certificates, only resume on the one the session was made for.
+  if (session && !SSLSessionMatchesContext(ssl, session)) {
+    Debug("ssl", "not resuming a session of another certificate on ssl=%p", ssl);
+    SSL_SESSION_free(session);
+    return NULL;
+  }
+  return session;
+}
+
+static void
+ssl_rm_cached_session(SSL_CTX * /* ctx ATS_UNUSED */, SSL_SESSION * session)
+{
+  unsigned len;
+  const unsigned char * id = SSL_SESSION_get_id(session, &len);
+
+  ssl_session_cache->remove(id, len);
+}
+
+void
+SSLSessionCacheEnable(SSL_CTX * ctx)
+{
+  ink_release_assert(ssl_session_cache != NULL);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+  SSL_CTX_sess_set_new_cb(ctx, ssl_new_cached_session);
+  SSL_CTX_sess_set_get_cb(ctx, ssl_get_cached_session);
+  SSL_CTX_sess_set_remove_cb(ctx, ssl_rm_cached_session);
+}
@@ -29,6 +29,8 @@
 #include <openssl/pem.h>
 #include <openssl/x509.h>
 #include <openssl/asn1.h>
+#include <openssl/rand.h>
+#include <openssl/hmac.h>
 
 #if HAVE_OPENSSL_TS_H
 #include <openssl/ts.h>
@@ -121,17 +123,70 @@ SSL_CTX_add_extra_chain_cert_file(SSL_CTX * ctx, const char * chainfile)
   return true;
 }
 
+// Every server context gets a session ID context made from the ssl_multicert.config line it was
+// made from, kept in the context's ex data, so a session only resumes with the certificate it was
+// negotiated for. The shared session cache and the ticket keys are common to all the contexts.
+#define SSL_SESSION_ID_CONTEXT_LEN 16 // MD5
+
+static int ssl_session_id_context_index = -1;
+
+static void
+ssl_free_session_id_context(void * /* parent ATS_UNUSED */, void * ptr, CRYPTO_EX_DATA * /* ad ATS_UNUSED */,
+                            int /* idx ATS_UNUSED */, long /* argl ATS_UNUSED */, void * /* argp ATS_UNUSED */)
+{
+  ats_free(ptr);
+}
+
+static void
+ssl_context_set_session_id_context(SSL_CTX * ctx, const SSLConfigParams * params, const char * cert, const char * ca,
+                                   const char * key)
+{
+  INK_DIGEST_CTX md5;
+  unsigned char * sid_ctx = (unsigned char *)ats_malloc(SSL_SESSION_ID_CONTEXT_LEN);
+
+  // The names keep their NULs, so that moving a name from one field to the next changes the digest.
+  ink_code_incr_md5_init(&md5);
+  ink_code_incr_md5_update(&md5, cert, strlen(cert) + 1);
+  ink_code_incr_md5_update(&md5, ca ? ca : "", ca ? strlen(ca) + 1 : 1);
+  ink_code_incr_md5_update(&md5, key ? key : "", key ? strlen(key) + 1 : 1);
+  ink_code_incr_md5_update(&md5, (const char *)&params->clientCertLevel, sizeof(params->clientCertLevel));
+  ink_code_incr_md5_final((char *)sid_ctx, &md5);
+
+  SSL_CTX_set_session_id_context(ctx, sid_ctx, SSL_SESSION_ID_CONTEXT_LEN);
+  SSL_CTX_set_ex_data(ctx, ssl_session_id_context_index, sid_ctx);
+}
+
+bool
+SSLSessionMatchesContext(SSL * ssl, SSL_SESSION * session)
+{
+  const unsigned char * want = (const unsigned char *)SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ssl_session_id_context_index);
+  unsigned int len;
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+  const unsigned char * have = SSL_SESSION_get0_id_context(session, &len);
+#else
+  const unsigned char * have = session->sid_ctx;
+  len = session->sid_ctx_length;
+#endif
+
+  if (want == NULL) {
+    return len == 0;
+  }
+  return len == SSL_SESSION_ID_CONTEXT_LEN && memcmp(have, want, len) == 0;
+}
+
 #if TS_USE_TLS_SNI
 
 static int
-ssl_servername_callback(SSL * ssl, int * ad, void * arg)
+ssl_servername_callback(SSL * ssl, int * ad, void * /* arg ATS_UNUSED */)
 {
   SSL_CTX *           ctx = NULL;
-  SSLCertLookup *     lookup = (SSLCertLookup *) arg;
+  // Contexts carry over from one certificate configuration to the next, so look in the current one
+  // rather than the one that made the context this handshake started with.
+  SSLCertificateConfig::scoped_config lookup;
   const char *        servername = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
   SSLNetVConnection * netvc = (SSLNetVConnection *)SSL_get_app_data(ssl);
 
-  Debug("ssl", "ssl=%p ad=%d lookup=%p server=%s", ssl, *ad, lookup, servername);
+  Debug("ssl", "ssl=%p ad=%d lookup=%p server=%s", ssl, *ad, (const SSLCertLookup *)lookup, servername);
 
   // The incoming SSL_CTX is either the one mapped from the inbound IP address or the default one. If we
   // don't find a name-based match at this point, we *do not* want to mess with the context because we've
@@ -150,7 +205,22 @@ ssl_servername_callback(SSL * ssl, int * ad, void * arg)
   }
 
   if (ctx != NULL) {
+    SSL_SESSION * session = SSL_get_session(ssl);
+
     SSL_set_SSL_CTX(ssl, ctx);
+
+    // Unless the ClientHello callback already switched, OpenSSL resumed or made the session before
+    // asking for the name, under the context the handshake started with. A new session belongs to
+    // this context, a resumed one has to have been made for it.
+    if (session && !SSL_session_reused(ssl)) {
+      const unsigned char * sid_ctx = (const unsigned char *)SSL_CTX_get_ex_data(ctx, ssl_session_id_context_index);
+
+      SSL_SESSION_set1_id_context(session, sid_ctx ? sid_ctx : (const unsigned char *)"", sid_ctx ? SSL_SESSION_ID_CONTEXT_LEN : 0);
+    } else if (session && !SSLSessionMatchesContext(ssl, session)) {
+      Debug("ssl", "ssl=%p resumed a session of another certificate for '%s'", ssl, servername);
+      *ad = SSL_AD_HANDSHAKE_FAILURE;
+      return SSL_TLSEXT_ERR_ALERT_FATAL;
+    }
   }
 
   ctx = SSL_get_SSL_CTX(ssl);
@@ -166,20 +236,123 @@ ssl_servername_callback(SSL * ssl, int * ad, void * arg)
   return SSL_TLSEXT_ERR_OK;
 }
 
+#ifdef SSL_CLIENT_HELLO_SUCCESS
+
+// OpenSSL looks for the session to resume before it calls the server name callback. Pick the
+// certificate from the ClientHello first, so the session is found, or made, under the context
+// that is going to serve it.
+static int
+ssl_client_hello_callback(SSL * ssl, int * /* al ATS_UNUSED */, void * /* arg ATS_UNUSED */)
+{
+  const unsigned char * p;
+  size_t len;
+  size_t namelen;
+  char servername[TLSEXT_MAXLEN_host_name + 1];
+
+  // A server name list holding a host name first (RFC 6066): list length, type, name length, name.
+  if (!SSL_client_hello_get0_ext(ssl, TLSEXT_TYPE_server_name, &p, &len) || len < 5 ||
+      (size_t)((p[0] << 8) | p[1]) != len - 2 || p[2] != TLSEXT_NAMETYPE_host_name) {
+    return SSL_CLIENT_HELLO_SUCCESS;
+  }
+
+  namelen = (p[3] << 8) | p[4];
+  if (namelen == 0 || namelen > len - 5 || namelen > TLSEXT_MAXLEN_host_name || memchr(p + 5, 0, namelen)) {
+    return SSL_CLIENT_HELLO_SUCCESS;
+  }
+  memcpy(servername, p + 5, namelen);
+  servername[namelen] = '\0';
+
+  SSLCertificateConfig::scoped_config lookup;
+  SSL_CTX * ctx = lookup->findInfoInHash(servername);
+
+  Debug("ssl", "ssl=%p ClientHello for '%s' picked SSL context %p", ssl, servername, ctx);
+  if (ctx != NULL) {
+    SSL_set_SSL_CTX(ssl, ctx);
+  }
+  return SSL_CLIENT_HELLO_SUCCESS;
+}
+
+#endif /* SSL_CLIENT_HELLO_SUCCESS */
+
 #endif /* TS_USE_TLS_SNI */
 
+#ifdef SSL_CTX_set_tlsext_ticket_key_cb
+
+// Seal and open session tickets with our own keys, so that a ticket is
+// good on any of our servers and across restarts rather than only with
+// the SSL context that issued it.
+static int
+ssl_callback_session_ticket(SSL * /* ssl ATS_UNUSED */, unsigned char * keyname, unsigned char * iv,
+                            EVP_CIPHER_CTX * cipher_ctx, HMAC_CTX * hctx, int enc)
+{
+  SSLTicketKeyConfig::scoped_config keys;
+
+  if (!keys) {
+    return 0;
+  }
+
+  if (enc == 1) {
+    const SSLTicketKey * key = &keys->keys[0];
+
+    if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) <= 0) {
+      return -1;
+    }
+    memcpy(keyname, key->name, sizeof(key->name));
+    EVP_EncryptInit_ex(cipher_ctx, EVP_aes_128_cbc(), NULL, key->aes_key, iv);
+    HMAC_Init_ex(hctx, key->hmac_secret, sizeof(key->hmac_secret), EVP_sha256(), NULL);
+    return 1;
+  }
+
+  for (unsigned i = 0; i < keys->num_keys; ++i) {
+    const SSLTicketKey * key = &keys->keys[i];
+
+    if (memcmp(keyname, key->name, sizeof(key->name)) == 0) {
+      EVP_DecryptInit_ex(cipher_ctx, EVP_aes_128_cbc(), NULL, key->aes_key, iv);
+      HMAC_Init_ex(hctx, key->hmac_secret, sizeof(key->hmac_secret), EVP_sha256(), NULL);
+      if (i == 0) {
+        return 1;
+      }
+      // Sealed with a key on its way out, issue a fresh ticket.
+      SSL_INCREMENT_DYN_STAT(ssl_session_ticket_old_key_stat);
+      return 2;
+    }
+  }
+
+  // A key we don't have (any more), fall back to a full handshake.
+  SSL_INCREMENT_DYN_STAT(ssl_session_ticket_unknown_key_stat);
+  return 0;
+}
+
+#endif /* SSL_CTX_set_tlsext_ticket_key_cb */
+
+static void
+ssl_context_enable_tickets(SSL_CTX * ctx)
+{
+#ifdef SSL_CTX_set_tlsext_ticket_key_cb
+  SSLTicketKeyConfig::scoped_config keys;
+
+  // Without a key file, leave OpenSSL to its own keys for each context.
+  if (keys) {
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx, ssl_callback_session_ticket);
+  }
+#else
+  (void)ctx;
+#endif /* SSL_CTX_set_tlsext_ticket_key_cb */
+}
+
 static SSL_CTX *
-ssl_context_enable_sni(SSL_CTX * ctx, SSLCertLookup * lookup)
+ssl_context_enable_sni(SSL_CTX * ctx)
 {
 #if TS_USE_TLS_SNI
   if (ctx) {
     Debug("ssl", "setting SNI callbacks with for ctx %p", ctx);
     SSL_CTX_set_tlsext_servername_callback(ctx, ssl_servername_callback);
-    SSL_CTX_set_tlsext_servername_arg(ctx, lookup);
+#ifdef SSL_CLIENT_HELLO_SUCCESS
+    SSL_CTX_set_client_hello_cb(ctx, ssl_client_hello_callback, NULL);
+#endif
   }
 #else
   (void)ctx;
-  (void)lookup;
 #endif /* TS_USE_TLS_SNI */
 
   return ctx;
@@ -202,6 +375,8 @@ SSLInitializeLibrary()
 
     CRYPTO_set_locking_callback(SSL_locking_callback);
     CRYPTO_set_id_callback(SSL_pthreads_thread_id);
+
+    ssl_session_id_context_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, ssl_free_session_id_context);
   }
 
   open_ssl_initialized = true;
@@ -295,7 +470,6 @@ SSLInitServerContext(
     const char * serverCaCertPtr,
     const char * serverKeyPtr)
 {
-  int         session_id_context;
   int         server_verify_client;
   xptr<char>  completeServerCertPath;
   SSL_CTX *   ctx = SSLDefaultServerContext();
@@ -311,8 +485,14 @@ SSLInitServerContext(
     SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
     SSL_CTX_sess_set_cache_size(ctx, params->ssl_session_cache_size);
     break;
+  case SSLConfigParams::SSL_SESSION_CACHE_MODE_SERVER_ATS:
+    SSLSessionCacheEnable(ctx);
+    break;
   }
 
+  ssl_context_enable_tickets(ctx);
+  ssl_context_set_session_id_context(ctx, params, serverCertPtr, serverCaCertPtr, serverKeyPtr);
+
   SSL_CTX_set_quiet_shutdown(ctx, 1);
 
   // XXX OpenSSL recommends that we should use SSL_CTX_use_certificate_chain_file() here. That API
@@ -383,11 +563,6 @@ SSLInitServerContext(
       Error("illegal client certification level %d in records.config", server_verify_client);
     }
 
-    // XXX I really don't think that this is a good idea. We should be setting this a some finer granularity,
-    // possibly per SSL CTX. httpd uses md5(host:port), which seems reasonable.
-    session_id_context = 1;
-    SSL_CTX_set_session_id_context(ctx, (const unsigned char *) &session_id_context, sizeof(session_id_context));
-
     SSL_CTX_set_verify(ctx, server_verify_client, NULL);
     SSL_CTX_set_verify_depth(ctx, params->verify_depth); // might want to make configurable at some point.
 
@@ -489,18 +664,22 @@ asn1_strdup(ASN1_STRING * s)
     return ats_strndup((const char *)ASN1_STRING_data(s), ASN1_STRING_length(s));
 }
 
-// Given a certificate and it's corresponding SSL_CTX context, insert hash
-// table aliases for all of the subject and subjectAltNames. Note that we don't
-// deal with wildcards (yet).
-static void
-ssl_index_certificate(SSLCertLookup * lookup, SSL_CTX * ctx, const char * certfile)
+// Read the subject CN and subjectAltNames of a certificate, which are the names to index it by. Note
+// that this doesn't need the certificate's SSL_CTX, so that it can be made later.
+static bool
+ssl_certificate_names(const char * certfile, Vec<char *>& names)
 {
   X509_NAME * subject = NULL;
 
   ats_file_bio bio(certfile, "r");
-  X509* cert = PEM_read_bio_X509_AUX(bio.bio, NULL, NULL, NULL);
+  X509* cert = bio ? PEM_read_bio_X509_AUX(bio.bio, NULL, NULL, NULL) : NULL;
 
-  // Insert a key for the subject CN.
+  if (cert == NULL) {
+    SSLError("failed to load certificate from %s", certfile);
+    return false;
+  }
+
+  // The subject CN.
   subject = X509_get_subject_name(cert);
   if (subject) {
     int pos = -1;
@@ -512,79 +691,214 @@ ssl_index_certificate(SSLCertLookup * lookup, SSL_CTX * ctx, const char * certfi
 
       X509_NAME_ENTRY * e = X509_NAME_get_entry(subject, pos);
       ASN1_STRING * cn = X509_NAME_ENTRY_get_data(e);
-      xptr<char> name(asn1_strdup(cn));
-
-      Debug("ssl", "mapping '%s' to certificate %s", (const char *)name, certfile);
-      lookup->insert(ctx, name);
+      names.push_back(asn1_strdup(cn));
     }
   }
 
 #if HAVE_OPENSSL_TS_H
-  // Traverse the subjectAltNames (if any) and insert additional keys for the SSL context.
-  GENERAL_NAMES * names = (GENERAL_NAMES *)X509_get_ext_d2i(cert, NID_subject_alt_name, NULL, NULL);
-  if (names) {
-    unsigned count = sk_GENERAL_NAME_num(names);
+  // Traverse the subjectAltNames (if any) for additional names.
+  GENERAL_NAMES * altnames = (GENERAL_NAMES *)X509_get_ext_d2i(cert, NID_subject_alt_name, NULL, NULL);
+  if (altnames) {
+    unsigned count = sk_GENERAL_NAME_num(altnames);
     for (unsigned i = 0; i < count; ++i) {
       GENERAL_NAME * name;
 
-      name = sk_GENERAL_NAME_value(names, i);
+      name = sk_GENERAL_NAME_value(altnames, i);
       if (name->type == GEN_DNS) {
-        xptr<char> dns(asn1_strdup(name->d.dNSName));
-        Debug("ssl", "mapping '%s' to certificate %s", (const char *)dns, certfile);
-        lookup->insert(ctx, dns);
+        names.push_back(asn1_strdup(name->d.dNSName));
       }
     }
 
-    GENERAL_NAMES_free(names);
+    GENERAL_NAMES_free(altnames);
   }
 #endif // HAVE_OPENSSL_TS_H
   X509_free(cert);
+  return true;
+}
+
+// Make the server context for a certificate from ssl_multicert.config.
+static SSL_CTX *
+ssl_make_server_context(const SSLConfigParams * params, const char * cert, const char * ca, const char * key)
+{
+  SSL_CTX * ctx = ssl_context_enable_sni(SSLInitServerContext(params, cert, ca, key));
+
+#if TS_USE_TLS_NPN
+  if (ctx) {
+    SSL_CTX_set_next_protos_advertised_cb(ctx, SSLNetVConnection::advertise_next_protocol, NULL);
+  }
+#endif /* TS_USE_TLS_NPN */
+
+  return ctx;
+}
+
+// Enough of a file's state to tell whether it was rewritten.
+struct ssl_file_stamp
+{
+  time_t  mtime;
+  off_t   size;
+  ino_t   ino;
+};
+
+// Stamp the files that a certificate's context is made from, the same ones SSLInitServerContext loads.
+static void
+ssl_certificate_stamp(const SSLConfigParams * params, const char * cert, const char * ca, const char * key,
+                      ssl_file_stamp (&stamp)[4])
+{
+  xptr<char> paths[4];
+
+  paths[0] = Layout::relative_to(params->serverCertPathOnly, cert);
+  if (params->serverCertChainFilename) {
+    paths[1] = Layout::relative_to(params->serverCertPathOnly, params->serverCertChainFilename);
+  }
+  if (ca) {
+    paths[2] = Layout::relative_to(params->serverCertPathOnly, ca);
+  }
+  if (key && params->serverKeyPathOnly) {
+    paths[3] = Layout::relative_to(params->serverKeyPathOnly, key);
+  }
+
+  memset(stamp, 0, sizeof(stamp));
+  for (unsigned i = 0; i < countof(paths); ++i) {
+    struct stat st;
+
+    if (paths[i] && stat(paths[i], &st) == 0) {
+      stamp[i].mtime = st.st_mtime;
+      stamp[i].size = st.st_size;
+      stamp[i].ino = st.st_ino;
+    }
+  }
+}
+
+// A certificate from ssl_multicert.config. Loading the configuration only reads its names, the
+// SSL_CTX is made when a handshake first asks for one of them. A reload keeps the certificate as long
+// as its files don't change.
+struct SSLMultiCertContext : public SSLCertContext
+{
+  SSLMultiCertContext(const SSLConfigParams * params, const char * c, const char * a, const char * k)
+    : cert(ats_strdup(c)), ca(ats_strdup(a)), key(ats_strdup(k))
+  {
+    ssl_certificate_stamp(params, c, a, k, this->stamp);
+  }
+
+  ~SSLMultiCertContext()
+  {
+    for (unsigned i = 0; i < this->names.count(); ++i) {
+      ats_free(this->names[i]);
+    }
+  }
+
+  // Whether the files are the ones that this was loaded from.
+  bool current(const SSLConfigParams * params) const
+  {
+    ssl_file_stamp now[4];
+
+    ssl_certificate_stamp(params, this->cert, this->ca, this->key, now);
+    return memcmp(now, this->stamp, sizeof(now)) == 0;
+  }
+
+  xptr<char>      cert;
+  xptr<char>      ca;
+  xptr<char>      key;
+  ssl_file_stamp  stamp[4];
+  Vec<char *>     names;
+
+protected:
+  SSL_CTX * make()
+  {
+    SSLConfig::scoped_config params;
+    SSL_CTX * ctx = ssl_make_server_context(params, this->cert, this->ca, this->key);
+
+    // This is only called once per certificate, so the error is only logged once.
+    if (ctx == NULL) {
+      Error("failed to make SSL context for certificate %s, its names will use the default certificate",
+            (const char *)this->cert);
+    } else {
+      Debug("ssl", "made SSL context %p for certificate %s", ctx, (const char *)this->cert);
+    }
+    return ctx;
+  }
+};
+
+// The key of a certificate across configurations; the files it is loaded from.
+static char *
+ssl_certificate_spec(const char * cert, const char * ca, const char * key)
+{
+  size_t len = strlen(cert) + (ca ? strlen(ca) : 0) + (key ? strlen(key) : 0) + 3;
+  char * spec = (char *)ats_malloc(len);
+
+  snprintf(spec, len, "%s\n%s\n%s", cert, ca ? (const char *)ca : "", key ? (const char *)key : "");
+  return spec;
 }
 
 static bool
 ssl_store_ssl_context(
     const SSLConfigParams * params,
     SSLCertLookup *         lookup,
+    const SSLCertLookup *   previous,
     xptr<char>& addr,
     xptr<char>& cert,
     xptr<char>& ca,
     xptr<char>& key)
 {
-  SSL_CTX *   ctx;
-  xptr<char>  certpath;
+  SSLMultiCertContext * cc;
+  xptr<char>  certpath(Layout::relative_to(params->serverCertPathOnly, cert));
+  xptr<char>  spec(ssl_certificate_spec(cert, ca, key));
+  bool        is_default = addr && strcmp(addr, "*") == 0;
+
+  // The same certificate may be on another line of this configuration, or unchanged since the last one.
+  cc = (SSLMultiCertContext *)lookup->recall(spec);
+  if (cc == NULL && previous) {
+    cc = (SSLMultiCertContext *)previous->recall(spec);
+    if (cc && (cc->failed() || !cc->current(params))) {
+      cc = NULL;
+    }
 
-  ctx = ssl_context_enable_sni(SSLInitServerContext(params, cert, ca, key), lookup);
-  if (!ctx) {
-    return false;
+    if (cc) {
+      Debug("ssl", "keeping certificate %s from the previous configuration", (const char *)certpath);
+    }
   }
 
-#if TS_USE_TLS_NPN
-  SSL_CTX_set_next_protos_advertised_cb(ctx, SSLNetVConnection::advertise_next_protocol, NULL);
-#endif /* TS_USE_TLS_NPN */
+  if (cc == NULL) {
+    cc = NEW(new SSLMultiCertContext(params, cert, ca, key));
+    if (!ssl_certificate_names(certpath, cc->names)) {
+      delete cc;
+      return false;
+    }
+  }
+
+  // Every handshake starts with the default context, so make it now. Unless they are made on demand, so
+  // are the others.
+  if ((is_default || !params->multicert_load_on_demand) && cc->get() == NULL) {
+    if (cc->refcount() == 0) {
+      delete cc;
+    }
+    return false;
+  }
 
-  certpath = Layout::relative_to(params->serverCertPathOnly, cert);
+  lookup->remember(spec, cc);
 
   // Index this certificate by the specified IP(v6) address. If the address is "*", make it the default context.
   if (addr) {
-    if (strcmp(addr, "*") == 0) {
-      lookup->ssl_default = ctx;
-      lookup->insert(ctx, addr);
+    if (is_default) {
+      lookup->ssl_default = cc->get();
+      lookup->insert(cc, addr);
     } else {
       IpEndpoint ep;
 
       if (ats_ip_pton(addr, &ep) == 0) {
         Debug("ssl", "mapping '%s' to certificate %s", (const char *)addr, (const char *)certpath);
-        lookup->insert(ctx, ep);
+        lookup->insert(cc, ep);
       } else {
         Error("'%s' is not a valid IPv4 or IPv6 address", (const char *)addr);
       }
     }
   }
 
-  // Insert additional mappings. Note that this maps multiple keys to the same value, so when
-  // this code is updated to reconfigure the SSL certificates, it will need some sort of
-  // refcounting or alternate way of avoiding double frees.
-  ssl_index_certificate(lookup, ctx, certpath);
+  for (unsigned i = 0; i < cc->names.count(); ++i) {
+    Debug("ssl", "mapping '%s' to certificate %s", cc->names[i], (const char *)certpath);
+    lookup->insert(cc, cc->names[i]);
+  }
+
   return true;
 }
 
@@ -635,7 +949,8 @@ ssl_extract_certificate(
 bool
 SSLParseCertificateConfiguration(
     const SSLConfigParams * params,
-    SSLCertLookup *         lookup)
+    SSLCertLookup *         lookup,
+    const SSLCertLookup *   previous)
 {
   char *      tok_state = NULL;
   char *      line = NULL;
@@ -686,7 +1001,7 @@ SSLParseCertificateConfiguration(
         REC_SignalError(errBuf, alarmAlready);
       } else {
         if (ssl_extract_certificate(&line_info, addr, cert, ca, key)) {
-          if (!ssl_store_ssl_context(params, lookup, addr, cert, ca, key)) {
+          if (!ssl_store_ssl_context(params, lookup, previous, addr, cert, ca, key)) {
             Error("failed to load SSL certificate specification from %s line %u",
                 params->configFilePath, line_num);
           }
@@ -706,7 +1021,7 @@ SSLParseCertificateConfiguration(
   // bootstrap the SSL handshake so that we can subsequently do the SNI lookup to switch to the real
   // context.
   if (lookup->ssl_default == NULL) {
-    lookup->ssl_default = ssl_context_enable_sni(SSLDefaultServerContext(), lookup);
+    lookup->ssl_default = ssl_context_enable_sni(SSLDefaultServerContext());
     lookup->insert(lookup->ssl_default, "*");
   }
 
@@ -35,9 +35,62 @@ extern "C" void fd_reify(struct ev_loop *);
 
 
 #ifndef INACTIVITY_TIMEOUT
+void
+NetTimeoutWheel::place(UnixNetVConnection *vc)
+{
+  int64_t delta = vc->timeout_tick - cur_tick;
+  int64_t tick = vc->timeout_tick;
+  int level = 0;
+
+  while (level < NET_TIMEOUT_WHEEL_LEVELS - 1 && delta >= ((int64_t) 1 << (NET_TIMEOUT_WHEEL_BITS * (level + 1))))
+    level++;
+  // Past the end of the wheel, wait in the furthest slot
+  if (delta >= ((int64_t) 1 << (NET_TIMEOUT_WHEEL_BITS * NET_TIMEOUT_WHEEL_LEVELS)))
+    tick = cur_tick + ((int64_t) 1 << (NET_TIMEOUT_WHEEL_BITS * NET_TIMEOUT_WHEEL_LEVELS)) - 1;
+
+  int slot = (tick >> (NET_TIMEOUT_WHEEL_BITS * level)) & NET_TIMEOUT_WHEEL_MASK;
+  vc->timeout_slot = (level << NET_TIMEOUT_WHEEL_BITS) | slot;
+  slots[level][slot].push(vc);
+}
+
+// Spread the slot of the level that has come around over the levels below
+void
+NetTimeoutWheel::cascade(int level)
+{
+  DList(UnixNetVConnection, timeout_link) &s = slots[level][(cur_tick >> (NET_TIMEOUT_WHEEL_BITS * level)) & NET_TIMEOUT_WHEEL_MASK];
+  DList(UnixNetVConnection, timeout_link) l = s;
+  UnixNetVConnection *vc;
+
+  s.clear();
+  while ((vc = l.pop()))
+    place(vc);
+}
+
+// Move the VCs due by now to the due list
+void
+NetTimeoutWheel::advance(ink_hrtime now, DList(UnixNetVConnection, cop_link) &due)
+{
+  int64_t now_tick = now / NET_TIMEOUT_WHEEL_TICK;
+  UnixNetVConnection *vc;
+
+  while (cur_tick < now_tick) {
+    ++cur_tick;
+    for (int level = NET_TIMEOUT_WHEEL_LEVELS - 1; level > 0; level--) {
+      if (!(cur_tick & (((int64_t) 1 << (NET_TIMEOUT_WHEEL_BITS * level)) - 1)))
+        cascade(level);
+    }
+    DList(UnixNetVConnection, timeout_link) &s = slots[0][cur_tick & NET_TIMEOUT_WHEEL_MASK];
+    while ((vc = s.pop())) {
+      vc->timeout_slot = -1;
+      due.push(vc);
+    }
+  }
+}
+
 // INKqa10496
 // One Inactivity cop runs on each thread once every second and
-// loops through the list of NetVCs and calls the timeouts
+// calls the timeouts of the NetVCs its NetHandler's timeout wheel
+// has due, and closes the ones closed off the NetHandler.
 struct InactivityCop : public Continuation {
   InactivityCop(ProxyMutex *m):Continuation(m) {
     SET_HANDLER(&InactivityCop::check_inactivity);
@@ -46,16 +99,24 @@ struct InactivityCop : public Continuation {
     (void) event;
     ink_hrtime now = ink_get_hrtime();
     NetHandler *nh = get_NetHandler(this_ethread());
-    // Copy the list and use pop() to catch any closes caused by callbacks.
-    forl_LL(UnixNetVConnection, vc, nh->open_list) {
-      if (vc->thread == this_ethread())
-        nh->cop_list.push(vc);
+    UnixNetVConnection *vc;
+
+    // VCs changed on other threads are looked at on the next round, which
+    // also covers a close that is still on its way from the other thread.
+    SList(UnixNetVConnection, timeout_enable_link) tq(nh->timeout_enable_list.popall());
+    while ((vc = tq.pop())) {
+      vc->in_timeout_enable_list = 0;
+      nh->timeout_wheel.schedule(vc, now);
     }
-    while (UnixNetVConnection *vc = nh->cop_list.pop()) {
+    // Move the due VCs to a list and use pop() to catch any closes caused
+    // by callbacks.
+    nh->timeout_wheel.advance(now, nh->cop_list);
+    while ((vc = nh->cop_list.pop())) {
       // If we cannot ge tthe lock don't stop just keep cleaning
       MUTEX_TRY_LOCK(lock, vc->mutex, this_ethread());
       if (!lock.lock_acquired) {
        NET_INCREMENT_DYN_STAT(inactivity_cop_lock_acquire_failure_stat);
+       nh->timeout_wheel.schedule(vc, now);
        continue;
       }
 
@@ -63,8 +124,12 @@ struct InactivityCop : public Continuation {
         close_UnixNetVConnection(vc, e->ethread);
         continue;
       } 
-      if (vc->next_inactivity_timeout_at && vc->next_inactivity_timeout_at < now)
+      if (vc->next_inactivity_timeout_at && vc->next_inactivity_timeout_at < now) {
+        // Back next round in case the vc can't take the timeout now
+        nh->timeout_wheel.schedule(vc, now);
         vc->handleEvent(EVENT_IMMEDIATE, e);
+      } else if (vc->next_inactivity_timeout_at)
+        nh->timeout_wheel.schedule(vc, vc->next_inactivity_timeout_at);
     }
     return 0;
   }
@@ -263,6 +328,37 @@ NetHandler::process_enabled_list(NetHandler *nh)
   }
 }
 
+//
+// Close the sockets left behind by closed NetVConnections once the kernel
+// has finished their zero copy sends, releasing the blocks it sent from.
+//
+void
+NetHandler::process_zero_copy_linger_list()
+{
+  ink_hrtime now = ink_get_hrtime();
+  NetZeroCopy *zc = zero_copy_linger_list.head;
+
+  while (zc) {
+    NetZeroCopy *next = zc->link.next;
+    bool done = zc->reap(zc->fd);
+    if (!done && zc->linger_until < now) {
+      // The peer is not acknowledging, reset the connection so the kernel
+      // drops the unsent data and its references to our blocks.
+      struct linger l;
+      l.l_onoff = 1;
+      l.l_linger = 0;
+      safe_setsockopt(zc->fd, SOL_SOCKET, SO_LINGER, (char *) &l, sizeof(l));
+      done = true;
+    }
+    if (done) {
+      zero_copy_linger_list.remove(zc);
+      socketManager.close(zc->fd);
+      delete zc;
+    }
+    zc = next;
+  }
+}
+
 
 //
 // The main event for NetHandler
@@ -281,6 +377,8 @@ NetHandler::mainNetEvent(int event, Event *e)
   NET_INCREMENT_DYN_STAT(net_handler_run_stat);
 
   process_enabled_list(this);
+  if (unlikely(!zero_copy_linger_list.empty()))
+    process_zero_copy_linger_list();
   if (likely(!read_ready_list.empty() || !write_ready_list.empty() || !read_enable_list.empty() || !write_enable_list.empty()))
     poll_timeout = 0; // poll immediately returns -- we have triggered stuff to process right now
   else
@@ -222,12 +222,20 @@ NetAccept::init_accept_per_thread()
 
   NetAccept *a;
   n = eventProcessor.n_threads_for_type[ET_NET];
+  thread_stats = register_net_accept_thread_stats(ET_NET, "proxy.process.net.accepts_per_thread");
   for (i = 0; i < n; i++) {
     if (i < n - 1) {
       a = NEW(new NetAccept);
       *a = *this;
-    } else
+      if (reuse_port)
+        listen_per_thread(a);
+    } else {
+      // the last thread polls the original socket, which stays owned
+      // by the action
       a = this;
+      reuse_port = false;
+    }
+    a->id = i;
     EThread *t = eventProcessor.eventthread[ET_NET][i];
     PollDescriptor *pd = get_PollDescriptor(t);
     if (a->ep.start(pd, a, EVENTIO_READ) < 0)
@@ -238,6 +246,60 @@ NetAccept::init_accept_per_thread()
 }
 
 
+//
+// Give the per thread copy @a a of this NetAccept its own SO_REUSEPORT
+// listen socket, so the kernel spreads new connections across the threads
+// and each thread only polls its own socket. If the socket cannot be
+// opened (e.g. the shared socket was bound by another user without
+// SO_REUSEPORT), @a a falls back to polling the shared socket.
+//
+void
+NetAccept::listen_per_thread(NetAccept *a)
+{
+  a->server.fd = NO_FD;
+  if (a->server.listen(NON_BLOCKING, recv_bufsize, send_bufsize, server.f_inbound_transparent) == 0) {
+    net_listen_sockopts(a->server.fd);
+    Debug("iocore_net_accept", "opened SO_REUSEPORT listen socket %d for port %d",
+          a->server.fd, ats_ip_port_host_order(&server.accept_addr));
+  } else {
+    Warning("unable to open a SO_REUSEPORT listen socket for port %d, sharing the accept socket",
+            ats_ip_port_host_order(&server.accept_addr));
+    a->server.fd = server.fd;
+    a->reuse_port = false;
+  }
+}
+
+
+//
+// Set the listen socket options which are not part of
+// Server::setup_fd_for_listen.
+//
+void
+net_listen_sockopts(int fd)
+{
+#ifdef TCP_DEFER_ACCEPT
+  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
+  // data on the socket ready to be read
+  int should_filter_int = 0;
+  REC_ReadConfigInteger(should_filter_int, "proxy.config.net.defer_accept");
+  if (should_filter_int > 0) {
+    setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
+  }
+#endif
+#ifdef TCP_INIT_CWND
+  int tcp_init_cwnd = 0;
+  REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
+  if (tcp_init_cwnd > 0) {
+    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
+    if (setsockopt(fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
+      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
+    }
+  }
+#endif
+  (void) fd;
+}
+
+
 int
 NetAccept::do_listen(bool non_blocking, bool transparent)
 {
@@ -388,6 +450,16 @@ NetAccept::acceptFastEvent(int event, void *ep)
   UnixNetVConnection *vc = NULL;
   int loop = accept_till_done;
 
+  // Cancelling the action only closes the original socket, the per thread
+  // SO_REUSEPORT sockets opened by listen_per_thread are closed here.
+  if (reuse_port && action_->cancelled) {
+    this->ep.stop();
+    server.close();
+    e->cancel();
+    delete this;
+    return EVENT_DONE;
+  }
+
   do {
     if (!backdoor && check_net_throttle(ACCEPT, ink_get_hrtime())) {
       ifd = -1;
@@ -487,6 +559,8 @@ NetAccept::acceptFastEvent(int event, void *ep)
     }
 
     vc->nh->open_list.enqueue(vc);
+    if (id >= 0)
+      NET_INCREMENT_ACCEPT_THREAD_STAT(thread_stats, e->ethread, id);
 
 #ifdef USE_EDGE_TRIGGER
     // Set the vc as triggered and place it in the read ready queue in case there is already data on the socket.
@@ -548,7 +622,10 @@ NetAccept::NetAccept()
     sockopt_flags(0),
     packet_mark(0),
     packet_tos(0),
-    etype(0)
+    etype(0),
+    reuse_port(false),
+    id(-1),
+    thread_stats(NULL)
 { }
 
 
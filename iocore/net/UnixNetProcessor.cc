@@ -142,6 +142,16 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
   na->backdoor = opt.backdoor;
   if (na->callback_on_open)
     na->mutex = cont->mutex;
+  if (opt.frequent_accept && accept_threads <= 0) {
+    int reuse_port = 0;
+    REC_ReadConfigInteger(reuse_port, "proxy.config.net.accept_reuseport");
+#ifdef SO_REUSEPORT
+    na->reuse_port = na->server.f_reuse_port = (reuse_port > 0);
+#else
+    if (reuse_port > 0)
+      Warning("proxy.config.net.accept_reuseport is set but SO_REUSEPORT is not supported on this platform");
+#endif
+  }
   if (opt.frequent_accept) { // true
     if (accept_threads > 0)  {
       if (0 == na->do_listen(BLOCKING, opt.f_inbound_transparent)) {
@@ -163,23 +173,7 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
   } else
     na->init_accept();
 
-#ifdef TCP_DEFER_ACCEPT
-  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
-  // data on the socket ready to be read
-  if (should_filter_int > 0) {
-    setsockopt(na->server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
-  }
-#endif
-#ifdef TCP_INIT_CWND
- int tcp_init_cwnd = 0;
- REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
- if(tcp_init_cwnd > 0) {
-    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
-    if(setsockopt(na->server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
-      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
-    }
- }
-#endif
+  net_listen_sockopts(na->server.fd);
   return na->action_;
 }
 
@@ -23,6 +23,10 @@
 
 #include "P_Net.h"
 
+#if TS_HAS_ZERO_COPY_SEND
+#include <linux/errqueue.h>
+#endif
+
 #define STATE_VIO_OFFSET ((uintptr_t)&((NetState*)0)->vio)
 #define STATE_FROM_VIO(_x) ((NetState*)(((char*)(_x)) - STATE_VIO_OFFSET))
 
@@ -38,8 +42,16 @@ typedef struct iovec IOVec;
 #define NET_MAX_IOV UIO_MAXIOV
 #endif
 
+// Writes smaller than this are copied even when zero copy is on, pinning
+// the pages and reaping the completion costs more than the copy.
+#define NET_ZERO_COPY_MIN_WRITE (16 * 1024)
+// How long a closed connection may keep its socket and blocks waiting for
+// the peer to acknowledge the last zero copy sends.
+#define NET_ZERO_COPY_LINGER HRTIME_SECONDS(60)
+
 // Global
 ClassAllocator<UnixNetVConnection> netVCAllocator("netVCAllocator");
+ClassAllocator<ZeroCopySend> zeroCopySendAllocator("zeroCopySendAllocator");
 
 //
 // Reschedule a UnixNetVConnection by moving it
@@ -81,14 +93,36 @@ net_activity(UnixNetVConnection *vc, EThread *thread)
       vc->inactivity_timeout = 0;
   }
 #else
-  if (vc->inactivity_timeout_in)
+  if (vc->inactivity_timeout_in) {
     vc->next_inactivity_timeout_at = ink_get_hrtime() + vc->inactivity_timeout_in;
-  else
+    if (vc->timeout_slot < 0)
+      net_check_timeout_at(vc, vc->next_inactivity_timeout_at);
+  } else
     vc->next_inactivity_timeout_at = 0;
 #endif
 
 }
 
+#ifndef INACTIVITY_TIMEOUT
+//
+// Make sure the inactivity cop looks at the vc no later than at, to time
+// it out or to close it. Off its thread, the vc is handed to the cop for
+// its next round instead.
+//
+void
+net_check_timeout_at(UnixNetVConnection *vc, ink_hrtime at)
+{
+  NetHandler *nh = vc->nh;
+
+  if (!nh)
+    return;
+  if (vc->thread == this_ethread())
+    nh->timeout_wheel.schedule(vc, at);
+  else if (!ink_atomic_swap(&vc->in_timeout_enable_list, 1))
+    nh->timeout_enable_list.push(vc);
+}
+#endif
+
 //
 // Function used to close a UnixNetVConnection and free the vc
 //
@@ -96,8 +130,35 @@ void
 close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
 {
   NetHandler *nh = vc->nh;
+  if (vc->getSSLHandShakeOffloaded()) {
+    // A handshake thread is using the socket, the vc is closed when
+    // the handshake step comes back. Until then nothing may pick it up.
+    if (!vc->closed)
+      vc->closed = 1;
+    nh->read_ready_list.remove(vc);
+    nh->write_ready_list.remove(vc);
+#ifndef INACTIVITY_TIMEOUT
+    nh->timeout_wheel.remove(vc);
+#endif
+    return;
+  }
   vc->cancel_OOB();
   vc->ep.stop();
+  if (vc->zero_copy) {
+    NetZeroCopy *zc = vc->zero_copy;
+    vc->zero_copy = NULL;
+    if (zc->reap(vc->con.fd)) {
+      delete zc;
+    } else {
+      // The kernel is still sending from our blocks. Hand the socket to the
+      // NetHandler, which closes it once the completions are in.
+      zc->fd = vc->con.fd;
+      zc->linger_until = ink_get_hrtime() + NET_ZERO_COPY_LINGER;
+      vc->con.fd = NO_FD;
+      socketManager.shutdown(zc->fd, SHUT_WR);
+      nh->zero_copy_linger_list.enqueue(zc);
+    }
+  }
   vc->con.close();
 #ifdef INACTIVITY_TIMEOUT
   if (vc->inactivity_timeout) {
@@ -106,6 +167,11 @@ close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
   }
 #else
   vc->next_inactivity_timeout_at = 0;
+  nh->timeout_wheel.remove(vc);
+  if (vc->in_timeout_enable_list) {
+    nh->timeout_enable_list.remove(vc);
+    vc->in_timeout_enable_list = 0;
+  }
 #endif
   vc->inactivity_timeout_in = 0;
   if (vc->active_timeout) {
@@ -378,6 +444,10 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     if (ret == EVENT_ERROR) {
       vc->write.triggered = 0;
       write_signal_error(nh, vc, err);
+    } else if (ret == SSL_HANDSHAKE_WANT_ASYNC) {
+      // Requeued when the handshake thread is done with the step.
+      nh->read_ready_list.remove(vc);
+      nh->write_ready_list.remove(vc);
     } else if (ret == SSL_HANDSHAKE_WANT_READ || ret == SSL_HANDSHAKE_WANT_ACCEPT || ret == SSL_HANDSHAKE_WANT_CONNECT
                || ret == SSL_HANDSHAKE_WANT_WRITE) {
       vc->read.triggered = 0;
@@ -577,6 +647,11 @@ UnixNetVConnection::do_io_close(int alerrno /* = -1 */ )
   EThread *t = this_ethread();
   bool close_inline = !recursion && nh->mutex->thread_holding == t;
 
+#ifndef INACTIVITY_TIMEOUT
+  // The inactivity cop closes it on its next round
+  if (!close_inline)
+    net_check_timeout_at(this, 0);
+#endif
   INK_WRITE_MEMORY_BARRIER;
   if (alerrno && alerrno != -1)
     this->lerrno = alerrno;
@@ -780,11 +855,11 @@ UnixNetVConnection::UnixNetVConnection()
 #ifdef INACTIVITY_TIMEOUT
     inactivity_timeout(NULL),
 #else
-    next_inactivity_timeout_at(0),
+    next_inactivity_timeout_at(0), timeout_tick(0), timeout_slot(-1), in_timeout_enable_list(0),
 #endif
     active_timeout(NULL), nh(NULL),
     id(0), flags(0), recursion(0), submit_time(0), oob_ptr(0),
-    from_accept_thread(false)
+    from_accept_thread(false), zero_copy(NULL)
 {
   memset(&local_addr, 0, sizeof local_addr);
   memset(&server_addr, 0, sizeof server_addr);
@@ -807,8 +882,10 @@ UnixNetVConnection::set_enabled(VIO *vio)
       inactivity_timeout = thread->schedule_in(this, inactivity_timeout_in);
   }
 #else
-  if (!next_inactivity_timeout_at && inactivity_timeout_in)
+  if (!next_inactivity_timeout_at && inactivity_timeout_in) {
     next_inactivity_timeout_at = ink_get_hrtime() + inactivity_timeout_in;
+    net_check_timeout_at(this, next_inactivity_timeout_at);
+  }
 #endif
 }
 
@@ -835,6 +912,8 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
     IOVec tiovec[NET_MAX_IOV];
     int niov = 0;
     int64_t total_wrote_last = total_wrote;
+    IOBufferBlock *send_block = b;
+    int64_t send_offset = offset;
     while (b && niov < NET_MAX_IOV) {
       // check if we have done this block
       int64_t l = b->read_avail();
@@ -860,11 +939,32 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
       b = b->next;
     }
     wattempted = total_wrote - total_wrote_last;
+    ProxyMutex *mutex = thread->mutex;
+#if TS_HAS_ZERO_COPY_SEND
+    if (zero_copy && !zero_copy->enabled && zero_copy->reap(con.fd)) {
+      delete zero_copy;
+      zero_copy = NULL;
+    }
+    if (zero_copy && zero_copy->enabled && wattempted >= NET_ZERO_COPY_MIN_WRITE) {
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = &tiovec[0];
+      msg.msg_iovlen = niov;
+      zero_copy->reap(con.fd);
+      r = socketManager.sendmsg(con.fd, &msg, MSG_ZEROCOPY);
+      if (r > 0) {
+        zero_copy->add(send_block, send_offset, r);
+        NET_INCREMENT_DYN_STAT(net_zero_copy_writes_stat);
+      } else if (r == -ENOBUFS) {
+        // Out of socket memory to track the pinned pages, copy this one.
+        r = socketManager.writev(con.fd, &tiovec[0], niov);
+      }
+    } else
+#endif
     if (niov == 1)
       r = socketManager.write(con.fd, tiovec[0].iov_base, tiovec[0].iov_len);
     else
       r = socketManager.writev(con.fd, &tiovec[0], niov);
-    ProxyMutex *mutex = thread->mutex;
     NET_DEBUG_COUNT_DYN_STAT(net_calls_to_write_stat, 1);
   } while (r == wattempted && total_wrote < towrite);
 
@@ -1142,12 +1242,19 @@ UnixNetVConnection::free(EThread *t)
   write.triggered = 0;
   options.reset();
   closed = 0;
+  if (zero_copy) {
+    delete zero_copy;
+    zero_copy = NULL;
+  }
   ink_assert(!read.ready_link.prev && !read.ready_link.next);
   ink_assert(!read.enable_link.next);
   ink_assert(!write.ready_link.prev && !write.ready_link.next);
   ink_assert(!write.enable_link.next);
   ink_assert(!link.next && !link.prev);
   ink_assert(!active_timeout);
+#ifndef INACTIVITY_TIMEOUT
+  ink_assert(timeout_slot < 0 && !timeout_link.prev && !timeout_link.next);
+#endif
   ink_assert(con.fd == NO_FD);
   ink_assert(t == this_ethread());
 
@@ -1163,3 +1270,103 @@ UnixNetVConnection::apply_options()
 {
   con.apply_options(options);
 }
+
+bool
+UnixNetVConnection::set_zero_copy(bool enable)
+{
+#if TS_HAS_ZERO_COPY_SEND
+  if (enable && !zero_copy) {
+    if (safe_setsockopt(con.fd, SOL_SOCKET, SO_ZEROCOPY, SOCKOPT_ON, sizeof(int)) < 0) {
+      Debug("socket", "Setting SO_ZEROCOPY on fd %d failed: %s", con.fd, strerror(errno));
+      return false;
+    }
+    zero_copy = NEW(new NetZeroCopy);
+  }
+  if (zero_copy) {
+    zero_copy->enabled = enable;
+    // Release what the kernel is done with. Sends still in flight are
+    // reaped by the next writes, or when the connection is closed.
+    if (!enable && zero_copy->reap(con.fd)) {
+      delete zero_copy;
+      zero_copy = NULL;
+    }
+  }
+  return enable;
+#else
+  (void) enable;
+  return false;
+#endif
+}
+
+//
+// Zero copy send bookkeeping
+//
+static void
+free_zero_copy_send(ZeroCopySend *s)
+{
+  s->blocks = NULL;
+  zeroCopySendAllocator.free(s);
+}
+
+void
+NetZeroCopy::add(IOBufferBlock *b, int64_t offset, int64_t len)
+{
+  ZeroCopySend *s = zeroCopySendAllocator.alloc();
+  s->seq = next_seq++;
+  s->blocks = iobufferblock_clone(b, offset, len);
+  pending.enqueue(s);
+}
+
+// Read the completions posted to the socket error queue and release the
+// blocks of the sends they cover. Returns true when nothing is pending.
+bool
+NetZeroCopy::reap(int sock)
+{
+#if TS_HAS_ZERO_COPY_SEND
+  char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+  ProxyMutex *mutex = this_ethread()->mutex;
+
+  while (!pending.empty()) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (socketManager.recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+      break;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+          !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+        continue;
+      struct sock_extended_err *serr = (struct sock_extended_err *) CMSG_DATA(cm);
+      if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0)
+        continue;
+      // The kernel fell back to copying (e.g. loopback or no scatter-gather).
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        NET_INCREMENT_DYN_STAT(net_zero_copy_copied_stat);
+      // Sends [ee_info, ee_data] are done, the range may wrap.
+      uint32_t lo = serr->ee_info;
+      uint32_t span = serr->ee_data - lo;
+      ZeroCopySend *s = pending.head;
+      while (s) {
+        ZeroCopySend *next = s->link.next;
+        if ((uint32_t) (s->seq - lo) <= span) {
+          pending.remove(s);
+          free_zero_copy_send(s);
+        }
+        s = next;
+      }
+    }
+  }
+#else
+  (void) sock;
+#endif
+  return pending.empty();
+}
+
+void
+NetZeroCopy::release_all()
+{
+  ZeroCopySend *s;
+  while ((s = pending.dequeue()))
+    free_zero_copy_send(s);
+}
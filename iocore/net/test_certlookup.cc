@@ -56,12 +56,11 @@ REGRESSION_TEST(SSLCertificateLookup)(RegressionTest* t, int /* atype ATS_UNUSED
   box.check(lookup.insert(notwild, "*.notwild.com"), "insert wildcard context");
   box.check(lookup.insert(b_notwild, "*.b.notwild.com"), "insert wildcard context");
 
-  // XXX inserting the same certificate multiple times ought to always fail, but it doesn't
-  // when we store a hash value.
-  lookup.insert(foo, "www.foo.com");
-  lookup.insert(wild, "*.wild.com");
-  lookup.insert(notwild, "*.notwild.com");
-  lookup.insert(b_notwild, "*.b.notwild.com");
+  // The first certificate for a name wins.
+  box.check(!lookup.insert(foo, "www.foo.com"), "reinsert host context");
+  box.check(!lookup.insert(wild, "*.wild.com"), "reinsert wildcard context");
+  box.check(!lookup.insert(notwild, "*.notwild.com"), "reinsert wildcard context");
+  box.check(!lookup.insert(b_notwild, "*.b.notwild.com"), "reinsert wildcard context");
 
   // Basic wildcard cases.
   box.check(lookup.findInfoInHash("a.wild.com") == wild, "wildcard lookup for a.wild.com");
@@ -76,6 +75,67 @@ REGRESSION_TEST(SSLCertificateLookup)(RegressionTest* t, int /* atype ATS_UNUSED
   // Basic hostname cases.
   box.check(lookup.findInfoInHash("www.foo.com") == foo, "host lookup for www.foo.com");
   box.check(lookup.findInfoInHash("www.bar.com") == NULL, "host lookup for www.bar.com");
+  box.check(lookup.findInfoInHash("WWW.Foo.COM") == foo, "host lookup for WWW.Foo.COM");
+  box.check(lookup.findInfoInHash("www.foo.com.") == foo, "host lookup for www.foo.com.");
+  box.check(lookup.findInfoInHash("a.www.foo.com") == NULL, "host lookup for a.www.foo.com");
+
+  // Wildcards only match whole labels.
+  box.check(lookup.findInfoInHash("foowild.com") == NULL, "wildcard lookup for foowild.com");
+  box.check(lookup.findInfoInHash("a.foowild.com") == NULL, "wildcard lookup for a.foowild.com");
+  box.check(lookup.findInfoInHash("wild.co") == NULL, "wildcard lookup for wild.co");
+  box.check(lookup.findInfoInHash("A.Wild.Com") == wild, "wildcard lookup for A.Wild.Com");
+
+  // An exact name beats a wildcard, wherever it is in the trie.
+  box.check(lookup.insert(foo, "x.b.notwild.com"), "insert host context under a wildcard");
+  box.check(lookup.findInfoInHash("x.b.notwild.com") == foo, "host lookup for x.b.notwild.com");
+  box.check(lookup.findInfoInHash("y.b.notwild.com") == b_notwild, "wildcard lookup for y.b.notwild.com");
+
+  // A wildcard covers one label. The bare name it is a wildcard of only falls back on it.
+  box.check(lookup.findInfoInHash("b.notwild.com") == notwild, "wildcard lookup for b.notwild.com");
+  box.check(lookup.findInfoInHash("a.c.b.notwild.com") == NULL, "wildcard lookup for a.c.b.notwild.com");
+  box.check(lookup.findInfoInHash("a.b.wild.com") == NULL, "wildcard lookup for a.b.wild.com");
+}
+
+// A certificate context that counts how often it is made.
+struct TestCertContext : public SSLCertContext
+{
+  TestCertContext() : made(0) {}
+
+  int made;
+
+protected:
+  SSL_CTX * make() {
+    ++made;
+    return SSL_CTX_new(SSLv23_server_method());
+  }
+};
+
+REGRESSION_TEST(SSLLazyCertificateLookup)(RegressionTest* t, int /* atype ATS_UNUSED */, int * pstatus)
+{
+  TestBox       box(t, pstatus);
+  SSLCertLookup * lookup = new SSLCertLookup();
+  SSLCertLookup * next = new SSLCertLookup();
+  TestCertContext * cc = new TestCertContext();
+
+  box = REGRESSION_TEST_PASSED;
+
+  box.check(lookup->insert(cc, "lazy.com"), "insert lazy context");
+  box.check(lookup->insert(cc, "*.lazy.com"), "insert lazy wildcard context");
+  lookup->remember("lazy", cc);
+  box.check(cc->made == 0, "context made before use");
+
+  SSL_CTX * ctx = lookup->findInfoInHash("a.lazy.com");
+  box.check(ctx != NULL && cc->made == 1, "context made on first use");
+  box.check(lookup->findInfoInHash("lazy.com") == ctx && cc->made == 1, "context made once");
+
+  // Carry the certificate over to the next configuration, then let go of the first one.
+  box.check(next->recall("lazy") == NULL, "recall from an empty lookup");
+  box.check(lookup->recall("lazy") == cc, "recall lazy context");
+  box.check(next->insert(lookup->recall("lazy"), "lazy.com"), "reinsert lazy context");
+  delete lookup;
+
+  box.check(next->findInfoInHash("lazy.com") == ctx && cc->made == 1, "context carried over");
+  delete next;
 }
 
 REGRESSION_TEST(SSLAddressLookup)(RegressionTest* t, int /* atype ATS_UNUSED */, int * pstatus)
@@ -24,6 +24,129 @@
 #include "libts.h"
 #include "Regex.h"
 
+// Patterns per set, and the size of a set's source; PCRE limits the
+// size of a compiled pattern, and a set that fails to compile falls back
+// to its patterns one at a time
+static const int DFA_SET_MAX_PATTERNS = 256;
+static const size_t DFA_SET_MAX_LENGTH = 16 * 1024;
+
+#ifdef PCRE_CONFIG_JIT
+// JIT compiled patterns run on a stack of their own, one per thread
+static ink_thread_key jit_stack_key;
+static pthread_once_t jit_stack_key_once = PTHREAD_ONCE_INIT;
+
+static void
+jit_stack_key_init()
+{
+  ink_thread_key_create(&jit_stack_key, (void (*)(void *)) &pcre_jit_stack_free);
+}
+
+static pcre_jit_stack *
+get_jit_stack(void * /* data ATS_UNUSED */)
+{
+  pcre_jit_stack *jit_stack = (pcre_jit_stack *) ink_thread_getspecific(jit_stack_key);
+
+  if (jit_stack == NULL) {
+    jit_stack = pcre_jit_stack_alloc(ats_pagesize(), 1024 * 1024);
+    ink_thread_setspecific(jit_stack_key, (void *) jit_stack);
+  }
+  return jit_stack;
+}
+#endif
+
+pcre_extra *
+ink_pcre_study(const pcre *re, const char **error)
+{
+#ifdef PCRE_CONFIG_JIT
+  pcre_extra *pe = pcre_study(re, PCRE_STUDY_JIT_COMPILE, error);
+
+  if (pe) {
+    pthread_once(&jit_stack_key_once, jit_stack_key_init);
+    pcre_assign_jit_stack(pe, &get_jit_stack, NULL);
+  }
+  return pe;
+#else
+  return pcre_study(re, 0, error);
+#endif
+}
+
+void
+ink_pcre_free_study(pcre_extra *extra)
+{
+#ifdef PCRE_CONFIG_JIT
+  pcre_free_study(extra);
+#else
+  pcre_free(extra);
+#endif
+}
+
+// Whether a pattern means the same inside a set as on its own: it must
+// not refer to groups by number or name (the set renumbers them), start
+// with a (*VERB), or use quoting or extended mode that could swallow the
+// parenthesis closing its alternative.
+static bool
+dfa_pattern_combinable(const char *pattern)
+{
+  for (const char *s = pattern; *s; ++s) {
+    if (s[0] == '\\') {
+      if (ParseRules::is_digit(s[1]) || s[1] == 'g' || s[1] == 'k' || s[1] == 'Q')
+        return false;
+      if (s[1])
+        ++s;
+    } else if (s[0] == '(') {
+      if (s[1] == '*')
+        return false;
+      if (s[1] == '?') {
+        const char *o = s + 2;
+
+        if (*o == 'P' || *o == 'R' || *o == '&' || *o == '|' || *o == '\'' || *o == '+' || *o == '-' ||
+            ParseRules::is_digit(*o) || (*o == '<' && o[1] != '=' && o[1] != '!'))
+          return false;
+        while (ParseRules::is_alpha(*o) || *o == '-') {
+          if (*o == 'x')
+            return false;
+          ++o;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Whether every branch of the pattern starts with '^', so it can only
+// match at the start of the string and needs no lookahead in a set.
+static bool
+dfa_pattern_leading_caret(const char *pattern)
+{
+  int depth = 0;
+  bool in_class = false;
+
+  if (pattern[0] != '^')
+    return false;
+  for (const char *s = pattern; *s; ++s) {
+    if (s[0] == '\\') {
+      if (s[1])
+        ++s;
+    } else if (in_class) {
+      if (s[0] == ']')
+        in_class = false;
+    } else if (s[0] == '[') {
+      in_class = true;
+      if (s[1] == '^')
+        ++s;
+      if (s[1] == ']')
+        ++s;
+    } else if (s[0] == '(') {
+      ++depth;
+    } else if (s[0] == ')') {
+      --depth;
+    } else if (s[0] == '|' && depth == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 DFA::~DFA()
 {
   dfa_pattern * p = _my_patterns;
@@ -31,7 +154,7 @@ DFA::~DFA()
   
   while(p) {
     if (p->_pe)
-      pcre_free(p->_pe);
+      ink_pcre_free_study(p->_pe);
     if (p->_re)
       pcre_free(p->_re);
     if(p->_p)
@@ -47,24 +170,27 @@ DFA::build(const char *pattern, REFlags flags)
 {
   const char *error;
   int erroffset;
+  int options = PCRE_ANCHORED;
   dfa_pattern* ret;
   
   ret = (dfa_pattern*)ats_malloc(sizeof(dfa_pattern));
   ret->_p = NULL;
   
   if (flags & RE_CASE_INSENSITIVE)
-    ret->_re = pcre_compile(pattern, PCRE_CASELESS|PCRE_ANCHORED, &error, &erroffset, NULL);
-  else 
-    ret->_re = pcre_compile(pattern, PCRE_ANCHORED, &error, &erroffset, NULL);
+    options |= PCRE_CASELESS;
+  if (flags & RE_UNANCHORED)
+    options &= ~PCRE_ANCHORED;
+  ret->_re = pcre_compile(pattern, options, &error, &erroffset, NULL);
   
   if (error) {
     ats_free(ret);
     return NULL;
   }
   
-  ret->_pe = pcre_study(ret->_re, 0, &error);
+  ret->_pe = ink_pcre_study(ret->_re, &error);
   
   if (error) {
+    pcre_free(ret->_re);
     ats_free(ret);
     return NULL;
   }
@@ -75,6 +201,50 @@ DFA::build(const char *pattern, REFlags flags)
   return ret;
 }
 
+// Compile patterns into one pattern whose alternatives are tried in
+// order, each marked with the pattern's index. The whole
+// set is anchored, so the first alternative to match is the first pattern
+// that would have matched on its own; unanchored patterns are looked for
+// anywhere in the string from a lookahead, unless they begin with '^'.
+dfa_pattern *
+DFA::build_set(const char **patterns, const int *indexes, int npatterns, REFlags flags)
+{
+  const char *error;
+  int erroffset;
+  int options = PCRE_ANCHORED;
+  size_t len = 0;
+  char *source, *s;
+  dfa_pattern *ret;
+
+  for (int i = 0; i < npatterns; i++)
+    len += strlen(patterns[i]) + 32;
+  s = source = (char *)ats_malloc(len + 1);
+
+  for (int i = 0; i < npatterns; i++) {
+    if ((flags & RE_UNANCHORED) && !dfa_pattern_leading_caret(patterns[i]))
+      s += snprintf(s, len + 1 - (s - source), "%s(*MARK:%d)(?=(?s:.*?)(?:%s))", i ? "|" : "", indexes[i], patterns[i]);
+    else
+      s += snprintf(s, len + 1 - (s - source), "%s(*MARK:%d)(?:%s)", i ? "|" : "", indexes[i], patterns[i]);
+  }
+
+  if (flags & RE_CASE_INSENSITIVE)
+    options |= PCRE_CASELESS;
+
+  ret = (dfa_pattern*)ats_malloc(sizeof(dfa_pattern));
+  ret->_re = pcre_compile(source, options, &error, &erroffset, NULL);
+  if (ret->_re == NULL) {
+    ats_free(source);
+    ats_free(ret);
+    return NULL;
+  }
+
+  ret->_pe = ink_pcre_study(ret->_re, &error);
+  ret->_idx = -1;
+  ret->_p = source;
+  ret->_next = NULL;
+  return ret;
+}
+
 int DFA::compile(const char *pattern, REFlags flags) {
   ink_assert(_my_patterns == NULL);
   _my_patterns = build(pattern,flags);
@@ -84,39 +254,82 @@ int DFA::compile(const char *pattern, REFlags flags) {
     return -1;
 }
 
+static void
+dfa_append(dfa_pattern **head, dfa_pattern **tail, dfa_pattern *p)
+{
+  if (*tail)
+    (*tail)->_next = p;
+  else
+    *head = p;
+  *tail = p;
+}
+
+static bool
+dfa_pattern_compiles(const char *pattern, REFlags flags)
+{
+  const char *error;
+  int erroffset;
+  pcre *re = pcre_compile(pattern, (flags & RE_CASE_INSENSITIVE) ? PCRE_CASELESS : 0, &error, &erroffset, NULL);
+
+  if (re == NULL)
+    return false;
+  pcre_free(re);
+  return true;
+}
+
 int
 DFA::compile(const char **patterns, int npatterns, REFlags flags)
 {
-  const char *pattern;
   dfa_pattern *ret = NULL;
   dfa_pattern *end = NULL;
-  int i;
-  //char buf[128];
-  
-  for (i = 0; i < npatterns; i++) {
-    pattern = patterns[i];
-    //snprintf(buf,128,"%s",pattern);
-    ret = build(pattern,flags);
-    if (!ret) {
+  const char **run;
+  int *run_idx;
+  int i, n;
+  size_t len;
+
+  for (end = _my_patterns; end && end->_next; end = end->_next)
+    ;
+
+  run = (const char **)ats_malloc(npatterns * sizeof(const char *));
+  run_idx = (int *)ats_malloc(npatterns * sizeof(int));
+
+  for (i = 0; i < npatterns; ) {
+    if (!dfa_pattern_combinable(patterns[i])) {
+      if ((ret = build(patterns[i], flags)) != NULL) {
+        ret->_idx = i;
+        dfa_append(&_my_patterns, &end, ret);
+      }
+      i++;
       continue;
     }
-    
-    if (!_my_patterns) {
-      _my_patterns = ret;
-      _my_patterns->_next = NULL;
-      _my_patterns->_idx = i;
+
+    // Gather a run of patterns that can share a set. Patterns that
+    // don't compile are skipped, as they always were.
+    for (n = 0, len = 0; i < npatterns && n < DFA_SET_MAX_PATTERNS && len < DFA_SET_MAX_LENGTH; i++) {
+      if (!dfa_pattern_combinable(patterns[i]))
+        break;
+      if (dfa_pattern_compiles(patterns[i], flags)) {
+        run[n] = patterns[i];
+        run_idx[n] = i;
+        len += strlen(patterns[i]);
+        n++;
+      }
     }
-    else { 
-      end = _my_patterns;
-      while( end->_next ) {
-        end = end->_next;
+
+    if (n > 1 && (ret = build_set(run, run_idx, n, flags)) != NULL) {
+      dfa_append(&_my_patterns, &end, ret);
+    } else {
+      for (int k = 0; k < n; k++) {
+        if ((ret = build(run[k], flags)) != NULL) {
+          ret->_idx = run_idx[k];
+          dfa_append(&_my_patterns, &end, ret);
+        }
       }
-      end->_next = ret; //add to end
-      ret->_idx = i;
     }
-    
   }
-  
+
+  ats_free(run);
+  ats_free(run_idx);
   return 0;
 }
 
@@ -135,13 +348,35 @@ DFA::match(const char *str, int length) const
   dfa_pattern * p = _my_patterns;
   
   while(p) {
-    rc = pcre_exec(p->_re, p->_pe, str, length , 0, 0, ovector, 30/*,wspace,20*/);
-    if (rc > 0) {
-      return p->_idx;
+    if (p->_idx >= 0) {
+      rc = pcre_exec(p->_re, p->_pe, str, length , 0, 0, ovector, 30/*,wspace,20*/);
+      if (rc > 0) {
+        return p->_idx;
+      } else if (rc < PCRE_ERROR_NOMATCH) {
+        return DFA_MATCH_ERROR;
+      }
+    } else {
+      // The mark of the alternative that matched is the pattern's index;
+      // the study data is shared, so the mark goes in a private copy
+      pcre_extra extra;
+      unsigned char *mark = NULL;
+
+      if (p->_pe)
+        extra = *p->_pe;
+      else
+        memset(&extra, 0, sizeof(extra));
+      extra.flags |= PCRE_EXTRA_MARK;
+      extra.mark = &mark;
+
+      rc = pcre_exec(p->_re, &extra, str, length, 0, 0, ovector, 30);
+      if (rc >= 0 && mark) {
+        return atoi((const char *)mark);
+      } else if (rc < PCRE_ERROR_NOMATCH) {
+        return DFA_MATCH_ERROR;
+      }
     }
     p = p->_next;
   }
 
   return -1;
 }
-
@@ -33,9 +33,19 @@
 
 enum REFlags
 {
-  RE_CASE_INSENSITIVE = 1
+  RE_CASE_INSENSITIVE = 1,
+  RE_UNANCHORED = 2
 };
 
+/// Study a compiled pattern, JIT compiling it when PCRE supports that.
+/// The result must be released with ink_pcre_free_study().
+pcre_extra *ink_pcre_study(const pcre *re, const char **error);
+void ink_pcre_free_study(pcre_extra *extra);
+
+/// DFA::match() result when PCRE failed on a pattern, e.g. on its match
+/// limit, so it is not known which pattern, if any, matches.
+#define DFA_MATCH_ERROR -2
+
 typedef struct __pat {
   int _idx;
   pcre *_re;
@@ -60,6 +70,10 @@ public:
   int match(const char *str, int length) const;
 
 private:
+  dfa_pattern * build_set(const char **patterns, const int *indexes, int npatterns, REFlags flags);
+
+  // Consecutive patterns are compiled into sets of alternatives, one
+  // pcre_exec() per set; these entries have an _idx of -1.
   dfa_pattern * _my_patterns;
 };
 
@@ -51,6 +51,148 @@ ink_code_incr_md5_final(char *sixteen_byte_hash_pointer, INK_DIGEST_CTX * contex
   return MD5_Final((unsigned char*)sixteen_byte_hash_pointer, context);
 }
 
+#define MURMUR3_C1 0x87c37b91114253d5ULL
+#define MURMUR3_C2 0x4cf5ad432745937fULL
+
+static inline uint64_t
+murmur3_rotl(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+murmur3_fmix(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static inline void
+murmur3_block(INK_MURMUR3_CTX * context, const unsigned char *block)
+{
+  uint64_t k1, k2;
+
+  memcpy(&k1, block, sizeof(k1));
+  memcpy(&k2, block + 8, sizeof(k2));
+
+  k1 *= MURMUR3_C1;
+  k1 = murmur3_rotl(k1, 31);
+  k1 *= MURMUR3_C2;
+  context->h1 ^= k1;
+  context->h1 = murmur3_rotl(context->h1, 27);
+  context->h1 += context->h2;
+  context->h1 = context->h1 * 5 + 0x52dce729;
+
+  k2 *= MURMUR3_C2;
+  k2 = murmur3_rotl(k2, 33);
+  k2 *= MURMUR3_C1;
+  context->h2 ^= k2;
+  context->h2 = murmur3_rotl(context->h2, 31);
+  context->h2 += context->h1;
+  context->h2 = context->h2 * 5 + 0x38495ab5;
+}
+
+/**
+  @brief Starts an incremental MurmurHash3 (x64, 128 bit, seed 0)
+*/
+int
+ink_code_incr_murmur3_init(INK_MURMUR3_CTX * context)
+{
+  memset(context, 0, sizeof(INK_MURMUR3_CTX));
+  return 1;
+}
+
+/**
+  @brief Adds input to a MurmurHash3, the result doesn't depend on how the input is split
+*/
+int
+ink_code_incr_murmur3_update(INK_MURMUR3_CTX * context, const char *input, int input_length)
+{
+  const unsigned char *p = (const unsigned char *) input;
+  const unsigned char *e = p + input_length;
+
+  context->length += input_length;
+
+  if (context->tail_length) {
+    int n = 16 - context->tail_length;
+
+    if (n > input_length)
+      n = input_length;
+    memcpy(context->tail + context->tail_length, p, n);
+    context->tail_length += n;
+    p += n;
+    if (context->tail_length < 16)
+      return 1;
+    murmur3_block(context, context->tail);
+    context->tail_length = 0;
+  }
+
+  for (; e - p >= 16; p += 16)
+    murmur3_block(context, p);
+
+  memcpy(context->tail, p, e - p);
+  context->tail_length = e - p;
+  return 1;
+}
+
+/**
+  @brief Finishes a MurmurHash3, h1 then h2 in host byte order
+*/
+int
+ink_code_incr_murmur3_final(char *sixteen_byte_hash_pointer, INK_MURMUR3_CTX * context)
+{
+  const unsigned char *tail = context->tail;
+  uint64_t h1 = context->h1;
+  uint64_t h2 = context->h2;
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+
+  switch (context->tail_length) {
+  case 15: k2 ^= ((uint64_t) tail[14]) << 48;
+  case 14: k2 ^= ((uint64_t) tail[13]) << 40;
+  case 13: k2 ^= ((uint64_t) tail[12]) << 32;
+  case 12: k2 ^= ((uint64_t) tail[11]) << 24;
+  case 11: k2 ^= ((uint64_t) tail[10]) << 16;
+  case 10: k2 ^= ((uint64_t) tail[9]) << 8;
+  case 9:
+    k2 ^= ((uint64_t) tail[8]);
+    k2 *= MURMUR3_C2;
+    k2 = murmur3_rotl(k2, 33);
+    k2 *= MURMUR3_C1;
+    h2 ^= k2;
+  case 8: k1 ^= ((uint64_t) tail[7]) << 56;
+  case 7: k1 ^= ((uint64_t) tail[6]) << 48;
+  case 6: k1 ^= ((uint64_t) tail[5]) << 40;
+  case 5: k1 ^= ((uint64_t) tail[4]) << 32;
+  case 4: k1 ^= ((uint64_t) tail[3]) << 24;
+  case 3: k1 ^= ((uint64_t) tail[2]) << 16;
+  case 2: k1 ^= ((uint64_t) tail[1]) << 8;
+  case 1:
+    k1 ^= ((uint64_t) tail[0]);
+    k1 *= MURMUR3_C1;
+    k1 = murmur3_rotl(k1, 31);
+    k1 *= MURMUR3_C2;
+    h1 ^= k1;
+  }
+
+  h1 ^= context->length;
+  h2 ^= context->length;
+  h1 += h2;
+  h2 += h1;
+  h1 = murmur3_fmix(h1);
+  h2 = murmur3_fmix(h2);
+  h1 += h2;
+  h2 += h1;
+
+  memcpy(sixteen_byte_hash_pointer, &h1, sizeof(h1));
+  memcpy(sixteen_byte_hash_pointer + 8, &h2, sizeof(h2));
+  return 1;
+}
+
 /**
   @brief Helper that will init, update, and create a final MD5
 
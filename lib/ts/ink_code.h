@@ -25,6 +25,7 @@
 #define	_ink_code_h_
 
 #include "ink_apidefs.h"
+#include <stdint.h>
 #include <openssl/md5.h>
 
 /* INK_MD5 context. */
@@ -41,4 +42,18 @@ inkcoreapi char *ink_code_md5_stringify_fast(char *dest33, const char *md5);
 inkcoreapi int ink_code_incr_md5_init(INK_DIGEST_CTX * context);
 inkcoreapi int ink_code_incr_md5_update(INK_DIGEST_CTX * context, const char *input, int input_length);
 inkcoreapi int ink_code_incr_md5_final(char *sixteen_byte_hash_pointer, INK_DIGEST_CTX * context);
+
+/* MurmurHash3 x64 128 bit context, a fast non cryptographic 16 byte hash. */
+typedef struct
+{
+  uint64_t h1;
+  uint64_t h2;
+  uint64_t length;
+  unsigned char tail[16];
+  int tail_length;
+} INK_MURMUR3_CTX;
+
+inkcoreapi int ink_code_incr_murmur3_init(INK_MURMUR3_CTX * context);
+inkcoreapi int ink_code_incr_murmur3_update(INK_MURMUR3_CTX * context, const char *input, int input_length);
+inkcoreapi int ink_code_incr_murmur3_final(char *sixteen_byte_hash_pointer, INK_MURMUR3_CTX * context);
 #endif
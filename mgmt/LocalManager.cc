@@ -1201,6 +1201,18 @@ LocalManager::bindProxyPort(HttpProxyPort& port)
     _exit(1);
   }
 
+#ifdef SO_REUSEPORT
+  {
+    // traffic_server opens a socket per net thread on the same port, which
+    // requires SO_REUSEPORT on this socket before it is bound.
+    bool found;
+    RecInt reuse_port = REC_readInteger("proxy.config.net.accept_reuseport", &found);
+    if (found && reuse_port > 0 && setsockopt(port.m_fd, SOL_SOCKET, SO_REUSEPORT, (char *) &one, sizeof(int)) < 0) {
+      mgmt_elog(stderr, "[bindProxyPort] Unable to set SO_REUSEPORT: %d : %s\n", port.m_port, strerror(errno));
+    }
+  }
+#endif
+
   if (port.m_inbound_transparent_p) {
 #if TS_USE_TPROXY
     Debug("http_tproxy", "Listen port %d inbound transparency enabled.\n", port.m_port);
@@ -100,7 +100,11 @@ RegexAcl::compile(const std::string& str, const char* filename, int lineno)
   _rex = pcre_compile(_regex_s.c_str(), 0, &error, &erroffset, NULL);
 
   if (NULL != _rex) {
+#ifdef PCRE_CONFIG_JIT
+    _extra = pcre_study(_rex, PCRE_STUDY_JIT_COMPILE, &error);
+#else
     _extra = pcre_study(_rex, 0, &error);
+#endif
     if ((NULL == _extra) && error && (*error != 0)) {
       TSError("Failed to study regular expression in %s:line %d at offset %d: %s\n", filename, lineno, erroffset, error);
       return false;
@@ -23,6 +23,7 @@
 #define __CONDITION_H__ 1
 
 #include <string>
+#include <map>
 #include <ts/ts.h>
 
 #include "resources.h"
@@ -31,6 +32,10 @@
 #include "parser.h"
 
 
+// Cache slots handed out to header names when a rule program is compiled
+typedef std::map<std::string, int> HeaderSlots;
+
+
 // Condition modifiers
 enum CondModifiers {
   COND_NONE = 0,
@@ -92,9 +97,17 @@ public:
   const MatcherOps get_cond_op() const { return _cond_op; }
   const std::string get_qualifier() const { return _qualifier; }
 
+  // Called once for this condition and the ones chained after it, when
+  // the rule they belong to is compiled into a program
+  void compile_all(HeaderSlots& slots) {
+    for (Condition* c = this; c; c = static_cast<Condition*>(c->_next))
+      c->compile(slots);
+  }
+
   // Virtual methods, has to be implemented by each conditional;
   virtual void initialize(Parser& p);
   virtual void append_value(std::string& s, const Resources& res) = 0;
+  virtual void compile(HeaderSlots& /* slots ATS_UNUSED */) { }
 
 protected:
   // Evaluate the condition
@@ -173,8 +173,16 @@ ConditionHeader::append_value(std::string& s, const Resources& res)
   TSMBuffer bufp;
   TSMLoc hdr_loc;
   TSMLoc field_loc;
-  const char* value;
-  int len;
+  const char* value = NULL;
+  int len = 0;
+
+  // Rules testing the same header share one lookup per hook
+  if (_slot >= 0 && res.cached_header(_slot, &value, &len)) {
+    TSDebug(PLUGIN_NAME, "Appending cached HEADER(%s) to evaluation value -> %.*s", _qualifier.c_str(), len, value);
+    if (value)
+      s.append(value, len);
+    return;
+  }
 
   if (_client) {
     bufp = res.client_bufp;
@@ -188,12 +196,37 @@ ConditionHeader::append_value(std::string& s, const Resources& res)
     field_loc = TSMimeHdrFieldFind(bufp, hdr_loc, _qualifier.c_str(), _qualifier.size());
     TSDebug(PLUGIN_NAME, "Getting Header: %s, field_loc: %p", _qualifier.c_str(), field_loc);
     if (field_loc != NULL) {
-      value = TSMimeHdrFieldValueStringGet(res.bufp, res.hdr_loc, field_loc, 0, &len);
+      value = TSMimeHdrFieldValueStringGet(bufp, hdr_loc, field_loc, 0, &len);
       TSDebug(PLUGIN_NAME, "Appending HEADER(%s) to evaluation value -> %.*s", _qualifier.c_str(), len, value);
       s.append(value, len);
-      TSHandleMLocRelease(res.bufp, res.hdr_loc, field_loc);
+      TSHandleMLocRelease(bufp, hdr_loc, field_loc);
     }
   }
+
+  if (_slot >= 0)
+    res.cache_header(_slot, value, len);
+}
+
+
+// Header names are case insensitive, and the client request is a
+// different header than the hook's own one on every hook but the first.
+void
+ConditionHeader::compile(HeaderSlots& slots)
+{
+  std::string key(_client ? "C:" : "H:");
+
+  for (std::string::size_type i = 0; i < _qualifier.size(); ++i)
+    key += tolower(_qualifier[i]);
+
+  HeaderSlots::const_iterator it = slots.find(key);
+
+  if (it != slots.end()) {
+    _slot = it->second;
+  } else if (slots.size() < static_cast<size_t>(Resources::MAX_HEADER_SLOTS)) {
+    _slot = slots.size();
+    slots[key] = _slot;
+  }
+  TSDebug(PLUGIN_NAME, "HEADER(%s) uses cache slot %d", _qualifier.c_str(), _slot);
 }
 
 
@@ -151,13 +151,14 @@ class ConditionHeader : public Condition
 {
 public:
   explicit ConditionHeader(bool client = false)
-    : _client(client)
+    : _client(client), _slot(-1)
   {
     TSDebug(PLUGIN_NAME_DBG, "Calling CTOR for ConditionHeader, client %d", client);
   };
 
   void initialize(Parser& p);
   void append_value(std::string& s, const Resources& res);
+  void compile(HeaderSlots& slots);
 
 protected:
   bool eval(const Resources& res);
@@ -166,6 +167,7 @@ private:
   DISALLOW_COPY_AND_ASSIGN(ConditionHeader);
 
   bool _client;
+  int _slot;
 };
 
 // path 
@@ -22,6 +22,7 @@
 //
 #include <fstream>
 #include <string>
+#include <time.h>
 #include <boost/algorithm/string.hpp>
 
 #include <ts/ts.h>
@@ -34,13 +35,18 @@
 // "Defines"
 const char* PLUGIN_NAME = "header_rewrite";
 const char* PLUGIN_NAME_DBG = "header_rewrite_dbg";
+static const char* PLUGIN_NAME_BENCH = "header_rewrite_bench";
 
 static const char* DEFAULT_CONF_PATH = "/usr/local/etc/header_rewrite/";
 
 
-// Global holding the rulesets and resource IDs
+// Global holding the rulesets while parsing, and the programs compiled from them
 static RuleSet* all_rules[TS_HTTP_LAST_HOOK+1];
-static ResourceIDs all_resids[TS_HTTP_LAST_HOOK+1];
+static RuleProgram* all_programs[TS_HTTP_LAST_HOOK+1];
+
+// Evaluation cost, only measured while the bench debug tag is on
+static int bench_calls_stat = -1;
+static int bench_nsecs_stat = -1;
 
 // Helper function to add a rule to the rulesets
 static bool
@@ -141,15 +147,52 @@ parse_config(const std::string fname, TSHttpHookID default_hook)
   // Add the last rule (possibly the only rule)
   add_rule(rule);
 
-  // Collect all resource IDs that we need
-  for (int i=TS_HTTP_READ_REQUEST_HDR_HOOK; i<TS_HTTP_LAST_HOOK; ++i)
-    if (all_rules[i])
-      all_resids[i] = all_rules[i]->get_all_resource_ids();
-
   return true;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Helpers for the bench stats. Replaying a sample of transactions with the
+// header_rewrite_bench debug tag on gives the average cost per hook call.
+//
+static void
+init_bench_stats()
+{
+  if (bench_calls_stat >= 0)
+    return;
+
+  if (TS_SUCCESS != TSStatFindName("plugin.header_rewrite.bench.calls", &bench_calls_stat))
+    bench_calls_stat = TSStatCreate("plugin.header_rewrite.bench.calls", TS_RECORDDATATYPE_INT,
+                                    TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_SUM);
+  if (TS_SUCCESS != TSStatFindName("plugin.header_rewrite.bench.nsecs", &bench_nsecs_stat))
+    bench_nsecs_stat = TSStatCreate("plugin.header_rewrite.bench.nsecs", TS_RECORDDATATYPE_INT,
+                                    TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_SUM);
+}
+
+static inline int64_t
+bench_now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void
+run_program(const RuleProgram* program, const Resources& res)
+{
+  if (TSIsDebugTagSet(PLUGIN_NAME_BENCH) && bench_calls_stat >= 0) {
+    int64_t start = bench_now();
+
+    program->run(res);
+    TSStatIntIncrement(bench_calls_stat, 1);
+    TSStatIntIncrement(bench_nsecs_stat, bench_now() - start);
+  } else {
+    program->run(res);
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Continuation
 //
@@ -160,7 +203,6 @@ cont_rewrite_headers(TSCont contp, TSEvent event, void *edata)
 
   TSHttpTxn txnp = (TSHttpTxn) edata;
   Resources res(txnp, contp);
-  const RuleSet* rule = NULL;
   TSHttpHookID hook = TS_HTTP_LAST_HOOK;
 
   // Get the resources necessary to process this event
@@ -186,21 +228,9 @@ cont_rewrite_headers(TSCont contp, TSEvent event, void *edata)
     break;
   }
 
-  if (hook != TS_HTTP_LAST_HOOK) {
-    res.gather(all_resids[hook], hook);
-    rule = all_rules[hook];
-
-    // Evaluation
-    while (rule) {
-      if (rule->eval(res)) {
-        OperModifiers rt = rule->exec(res);
-
-        if (rule->last() || (rt & OPER_LAST)) {
-          break; // Conditional break, force a break with [L]
-        }
-      }
-      rule = rule->next;
-    }
+  if (hook != TS_HTTP_LAST_HOOK && all_programs[hook]) {
+    res.gather(all_programs[hook]->get_all_resource_ids(), hook);
+    run_program(all_programs[hook], res);
   }
 
   TSHttpTxnReenable(txnp, TS_EVENT_HTTP_CONTINUE);
@@ -233,13 +263,18 @@ TSPluginInit(int argc, const char *argv[])
   // Initialize the globals
   for (int i=TS_HTTP_READ_REQUEST_HDR_HOOK; i<TS_HTTP_LAST_HOOK; ++i) {
     all_rules[i] = NULL;
-    all_resids[i] = RSRC_NONE;
+    all_programs[i] = NULL;
   }
+  init_bench_stats();
 
   // Parse the config file
   if (parse_config(argv[1], TS_HTTP_READ_RESPONSE_HDR_HOOK)) {
     for (int i=TS_HTTP_READ_REQUEST_HDR_HOOK; i<TS_HTTP_LAST_HOOK; ++i) {
       if (all_rules[i]) {
+        all_programs[i] = new RuleProgram();
+        all_programs[i]->compile(all_rules[i]);
+        all_rules[i] = NULL;
+
         TSDebug(PLUGIN_NAME, "adding hook: %d", i);
         TSHttpHookAdd(static_cast<TSHttpHookID>(i), TSContCreate(cont_rewrite_headers, NULL));
       }
@@ -295,8 +330,13 @@ TSRemapNewInstance(int argc, char *argv[], void **ih, char * /* errbuf ATS_UNUSE
     return TS_ERROR;
   }
 
-  *ih = all_rules[TS_REMAP_PSEUDO_HOOK];
+  RuleProgram* program = new RuleProgram();
+
+  program->compile(all_rules[TS_REMAP_PSEUDO_HOOK]);
   all_rules[TS_REMAP_PSEUDO_HOOK] = NULL;
+  init_bench_stats();
+
+  *ih = program;
 
   TSDebug(PLUGIN_NAME, "successfully initialize the header_rewrite plugin");
   return TS_SUCCESS;
@@ -305,9 +345,9 @@ TSRemapNewInstance(int argc, char *argv[], void **ih, char * /* errbuf ATS_UNUSE
 void
 TSRemapDeleteInstance(void *ih)
 {
-  RuleSet* rule = static_cast<RuleSet*>(ih);
+  RuleProgram* program = static_cast<RuleProgram*>(ih);
 
-  delete rule;
+  delete program;
 }
 
 
@@ -319,31 +359,20 @@ TSRemapDoRemap(void *ih, TSHttpTxn rh, TSRemapRequestInfo *rri)
 {
   TSRemapStatus rval = TSREMAP_NO_REMAP;
 
-  if (NULL == ih) {
+  if (NULL == ih || static_cast<RuleProgram*>(ih)->empty()) {
     TSDebug(PLUGIN_NAME, "No Rules configured, falling back to default");
     return rval;
   } else {
-    RuleSet* rule = (RuleSet*)ih;
+    RuleProgram* program = static_cast<RuleProgram*>(ih);
     Resources res((TSHttpTxn)rh, rri);
 
-    // TODO: This might be suboptimal, do we always need the client request
-    // headers in a remap plugin?
-    res.gather(RSRC_CLIENT_REQUEST_HEADERS, TS_REMAP_PSEUDO_HOOK);
-
-    // Evaluation
-    while (rule) {
-      if (rule->eval(res)) {
-        OperModifiers rt = rule->exec(res);
-        if (res.changed_url == true)
-          rval = TSREMAP_DID_REMAP;
-
-        if (rule->last() || (rt & OPER_LAST)) {
-          break; // Conditional break, force a break with [L]
-        }
-      }
-      rule = rule->next;
-    }
-
+    // Remap rules work on the client request even when they don't ask for it,
+    // e.g. set-redirect, or a %{CLIENT-HEADER} inside an operator's value.
+    res.gather(static_cast<ResourceIDs>(program->get_all_resource_ids() | RSRC_CLIENT_REQUEST_HEADERS),
+               TS_REMAP_PSEUDO_HOOK);
+    run_program(program, res);
+    if (res.changed_url == true)
+      rval = TSREMAP_DID_REMAP;
   }
 
   TSDebug(PLUGIN_NAME, "returing with status: %d", rval);
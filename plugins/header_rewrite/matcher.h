@@ -101,7 +101,7 @@ public:
 
   // Evaluate this matcher
   bool
-  test(const T t) const {
+  test(const T& t) const {
     switch (_op) {
     case MATCH_EQUAL:
       return test_eq(t);
@@ -124,15 +124,15 @@ public:
 
 private:
   // For basic types
-  bool test_eq(const T t) const {
+  bool test_eq(const T& t) const {
     // std::cout << "Testing: " << t << " == " << _data << std::endl;
     return t == _data;
   }
-  bool test_lt(const T t) const {
+  bool test_lt(const T& t) const {
     // std::cout << "Testing: " << t << " < " << _data << std::endl;
     return t < _data;
   }
-  bool test_gt(const T t) const {
+  bool test_gt(const T& t) const {
     // std::cout << "Testing: " << t << " > " << _data << std::endl;
     return t > _data;
   }
@@ -147,7 +147,7 @@ private:
    return false;
  }
   
-  bool test_reg(const std::string t) const {
+  bool test_reg(const std::string& t) const {
       TSDebug(PLUGIN_NAME, "Test regular expression %s : %s", _data.c_str(), t.c_str());
           int ovector[OVECCOUNT];
           if (helper.regexMatch(t.c_str(), t.length(), ovector) > 0) {
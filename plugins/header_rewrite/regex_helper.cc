@@ -32,7 +32,7 @@ regexHelper::setRegexMatch(const std::string& s)
     {
         return false;
     }
-    regexExtra = pcre_study(regex, 0, &errorStudy);
+    regexExtra = pcre_study(regex, PCRE_STUDY_OPTIONS, &errorStudy);
     if ((regexExtra == NULL) && (errorStudy != 0)) 
     {
         return false;
@@ -22,6 +22,14 @@
 
 #include <string>
 
+#ifdef PCRE_CONFIG_JIT
+#define PCRE_STUDY_OPTIONS PCRE_STUDY_JIT_COMPILE
+#define PCRE_FREE_STUDY pcre_free_study
+#else
+#define PCRE_STUDY_OPTIONS 0
+#define PCRE_FREE_STUDY pcre_free
+#endif
+
 
 const int OVECCOUNT = 30; // We support $1 - $9 only, and this needs to be 3x that
 
@@ -39,7 +47,7 @@ public:
           pcre_free(regex);
 
       if (regexExtra)
-          pcre_free(regexExtra);
+          PCRE_FREE_STUDY(regexExtra);
   }
 
 
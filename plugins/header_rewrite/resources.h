@@ -47,9 +47,12 @@ enum ResourceIDs {
 class Resources
 {
 public:
+  // Number of distinct headers the rule compiler hands out cache slots for
+  static const int MAX_HEADER_SLOTS = 32;
+
   explicit Resources(TSHttpTxn txnptr, TSCont contptr)
     : txnp(txnptr), contp(contptr), bufp(NULL), hdr_loc(NULL), client_bufp(NULL), client_hdr_loc(NULL),
-      resp_status(TS_HTTP_STATUS_NONE), _rri(NULL), changed_url(false), _ready(false)
+      resp_status(TS_HTTP_STATUS_NONE), _rri(NULL), changed_url(false), _ready(false), _header_cached(0)
   {
     TSDebug(PLUGIN_NAME_DBG, "Calling CTOR for Resources (InkAPI)");
   }
@@ -57,7 +60,7 @@ public:
   Resources(TSHttpTxn txnptr, TSRemapRequestInfo *rri) :
     txnp(txnptr), contp(NULL),
     bufp(NULL), hdr_loc(NULL), client_bufp(NULL), client_hdr_loc(NULL), resp_status(TS_HTTP_STATUS_NONE),
-    _rri(rri), _ready(false)
+    _rri(rri), changed_url(false), _ready(false), _header_cached(0)
   {
     TSDebug(PLUGIN_NAME_DBG, "Calling CTOR for Resources (RemapAPI)");
     TSDebug(PLUGIN_NAME, "rri: %p", _rri);
@@ -68,6 +71,26 @@ public:
   void gather(const ResourceIDs ids, TSHttpHookID hook);
   bool ready() const { return _ready; }
 
+  // Header values looked up by conditions, cached by the slot the rule
+  // compiler assigned to the header name (see RuleProgram::compile()).
+  // A NULL value means the header is not present.
+  bool cached_header(int slot, const char** value, int* len) const {
+    if (!(_header_cached & (1U << slot)))
+      return false;
+    *value = _header_values[slot].value;
+    *len = _header_values[slot].len;
+    return true;
+  }
+
+  void cache_header(int slot, const char* value, int len) const {
+    _header_values[slot].value = value;
+    _header_values[slot].len = len;
+    _header_cached |= (1U << slot);
+  }
+
+  // Operators can change the headers, so they drop the cache
+  void clear_header_cache() const { _header_cached = 0; }
+
   TSHttpTxn txnp;
   TSCont contp;
   TSMBuffer bufp;
@@ -83,6 +106,15 @@ private:
   DISALLOW_COPY_AND_ASSIGN(Resources);
 
   bool _ready;
+
+  struct HeaderValue
+  {
+    const char* value;
+    int len;
+  };
+
+  mutable uint32_t _header_cached;
+  mutable HeaderValue _header_values[MAX_HEADER_SLOTS];
 };
 
 
@@ -87,3 +87,41 @@ RuleSet::add_operator(Parser& p) {
     _ids = static_cast<ResourceIDs>(_ids | _oper->get_resource_ids());
   }
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RuleProgram
+//
+RuleProgram::~RuleProgram()
+{
+  for (int i = 0; i < _count; ++i)
+    delete _rules[i];
+  delete [] _rules;
+}
+
+
+void
+RuleProgram::compile(RuleSet* rules)
+{
+  HeaderSlots slots;
+  int count = 0;
+
+  TSReleaseAssert(NULL == _rules);
+
+  for (RuleSet* rule = rules; rule; rule = rule->next)
+    ++count;
+
+  _rules = new RuleSet*[count];
+  _count = count;
+  _ids = RSRC_NONE;
+
+  for (int i = 0; i < count; ++i) {
+    _rules[i] = rules;
+    rules = rules->next;
+    _rules[i]->next = NULL;
+    _rules[i]->compile(slots);
+    _ids = static_cast<ResourceIDs>(_ids | _rules[i]->get_all_resource_ids());
+  }
+
+  TSDebug(PLUGIN_NAME, "Compiled %d rules, resources %d, %d cached headers", _count, _ids, static_cast<int>(slots.size()));
+}
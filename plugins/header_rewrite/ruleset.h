@@ -70,6 +70,11 @@ public:
     return _last;
   }
 
+  void compile(HeaderSlots& slots) {
+    if (_cond)
+      _cond->compile_all(slots);
+  }
+
   OperModifiers exec(const Resources& res) const {
     _oper->do_exec(res);
     return _opermods;
@@ -91,4 +96,51 @@ private:
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// A RuleProgram is the list of rulesets for one hook (or remap instance),
+// flattened at load time into an array. It carries the union of resources
+// the rules need, so only those are gathered, and gives each header the
+// conditions test a slot in the per-transaction header cache.
+//
+class RuleProgram
+{
+public:
+  RuleProgram()
+    : _rules(NULL), _count(0), _ids(RSRC_NONE)
+  { };
+
+  ~RuleProgram();
+
+  // Takes ownership of the ruleset list
+  void compile(RuleSet* rules);
+
+  bool empty() const { return 0 == _count; }
+  int size() const { return _count; }
+  const ResourceIDs get_all_resource_ids() const { return _ids; }
+
+  // Evaluate all rules, in order, until one says it's the last
+  void run(const Resources& res) const {
+    for (int i = 0; i < _count; ++i) {
+      const RuleSet* rule = _rules[i];
+
+      if (rule->eval(res)) {
+        OperModifiers rt = rule->exec(res);
+
+        res.clear_header_cache();
+        if (rule->last() || (rt & OPER_LAST)) {
+          break; // Conditional break, force a break with [L]
+        }
+      }
+    }
+  }
+
+private:
+  DISALLOW_COPY_AND_ASSIGN(RuleProgram);
+
+  RuleSet** _rules;
+  int _count;
+  ResourceIDs _ids;
+};
+
+
 #endif // __RULESET_H
@@ -0,0 +1,219 @@
+/** @file
+
+  Remap instance tests for the header_rewrite plugin, run against stubs
+  of the few Traffic Server APIs the plugin calls.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ts/ts.h>
+#include <ts/remap.h>
+
+using std::cout;
+using std::endl;
+using std::string;
+
+// The one transaction the stubs below act on. Only a single client
+// request header is supported, which is all the tests need.
+static int txn_dummy, buf_dummy, hdr_dummy, field_dummy, url_dummy;
+static string client_header_name;
+static string client_header_value;
+static bool client_req_fetched;
+static TSHttpStatus ret_status;
+static string parsed_url;
+
+static void
+reset_txn(const char* name, const char* value)
+{
+  client_header_name = name;
+  client_header_value = value;
+  client_req_fetched = false;
+  ret_status = TS_HTTP_STATUS_NONE;
+  parsed_url.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Traffic Server API stubs
+//
+tsapi const TSMLoc TS_NULL_MLOC = (TSMLoc) NULL;
+
+void TSDebug(const char* /* tag */, const char* /* fmt */, ...) { }
+void TSError(const char* /* fmt */, ...) { }
+int TSIsDebugTagSet(const char* /* t */) { return 0; }
+
+void
+_TSReleaseAssert(const char* txt, const char* f, int l)
+{
+  fprintf(stderr, "%s:%d: failed assert `%s`\n", f, l, txt);
+  abort();
+}
+
+void _TSfree(void* ptr) { free(ptr); }
+
+TSReturnCode TSPluginRegister(TSSDKVersion /* v */, TSPluginRegistrationInfo* /* info */) { return TS_SUCCESS; }
+TSMutex TSMutexCreate(void) { return NULL; }
+void TSMutexLock(TSMutex /* m */) { }
+void TSMutexUnlock(TSMutex /* m */) { }
+TSCont TSContCreate(TSEventFunc /* f */, TSMutex /* m */) { return NULL; }
+void TSHttpHookAdd(TSHttpHookID /* id */, TSCont /* contp */) { }
+void TSHttpTxnReenable(TSHttpTxn /* txnp */, TSEvent /* event */) { }
+
+int TSStatCreate(const char* /* name */, TSRecordDataType /* t */, TSStatPersistence /* p */, TSStatSync /* s */) { return 0; }
+TSReturnCode TSStatFindName(const char* /* name */, int* /* idp */) { return TS_ERROR; }
+void TSStatIntIncrement(int /* stat */, TSMgmtInt /* amount */) { }
+
+TSReturnCode
+TSHttpTxnClientReqGet(TSHttpTxn txnp, TSMBuffer* bufp, TSMLoc* offset)
+{
+  assert(txnp == (TSHttpTxn) &txn_dummy);
+  client_req_fetched = true;
+  *bufp = (TSMBuffer) &buf_dummy;
+  *offset = (TSMLoc) &hdr_dummy;
+  return TS_SUCCESS;
+}
+
+TSReturnCode TSHttpTxnClientRespGet(TSHttpTxn /* txnp */, TSMBuffer* /* bufp */, TSMLoc* /* offset */) { return TS_ERROR; }
+TSReturnCode TSHttpTxnServerReqGet(TSHttpTxn /* txnp */, TSMBuffer* /* bufp */, TSMLoc* /* offset */) { return TS_ERROR; }
+TSReturnCode TSHttpTxnServerRespGet(TSHttpTxn /* txnp */, TSMBuffer* /* bufp */, TSMLoc* /* offset */) { return TS_ERROR; }
+TSReturnCode TSHandleMLocRelease(TSMBuffer /* bufp */, TSMLoc /* parent */, TSMLoc /* mloc */) { return TS_SUCCESS; }
+
+void TSHttpTxnSetHttpRetStatus(TSHttpTxn /* txnp */, TSHttpStatus status) { ret_status = status; }
+void TSHttpTxnActiveTimeoutSet(TSHttpTxn /* txnp */, int /* timeout */) { }
+void TSHttpTxnConnectTimeoutSet(TSHttpTxn /* txnp */, int /* timeout */) { }
+void TSHttpTxnDNSTimeoutSet(TSHttpTxn /* txnp */, int /* timeout */) { }
+void TSHttpTxnNoActivityTimeoutSet(TSHttpTxn /* txnp */, int /* timeout */) { }
+
+TSHttpStatus TSHttpHdrStatusGet(TSMBuffer /* bufp */, TSMLoc /* offset */) { return TS_HTTP_STATUS_NONE; }
+TSReturnCode TSHttpHdrStatusSet(TSMBuffer /* bufp */, TSMLoc /* offset */, TSHttpStatus /* status */) { return TS_SUCCESS; }
+TSReturnCode TSHttpHdrReasonSet(TSMBuffer /* bufp */, TSMLoc /* offset */, const char* /* value */, int /* len */) { return TS_SUCCESS; }
+const char* TSHttpHdrReasonLookup(TSHttpStatus /* status */) { return ""; }
+
+TSMLoc
+TSMimeHdrFieldFind(TSMBuffer bufp, TSMLoc hdr, const char* name, int length)
+{
+  if (bufp == (TSMBuffer) &buf_dummy && hdr == (TSMLoc) &hdr_dummy &&
+      client_header_name.size() == (size_t) length && !strncasecmp(client_header_name.c_str(), name, length))
+    return (TSMLoc) &field_dummy;
+  return TS_NULL_MLOC;
+}
+
+const char*
+TSMimeHdrFieldValueStringGet(TSMBuffer /* bufp */, TSMLoc /* hdr */, TSMLoc field, int /* idx */, int* value_len_ptr)
+{
+  assert(field == (TSMLoc) &field_dummy);
+  *value_len_ptr = client_header_value.size();
+  return client_header_value.data();
+}
+
+TSMLoc TSMimeHdrFieldNextDup(TSMBuffer /* bufp */, TSMLoc /* hdr */, TSMLoc /* field */) { return TS_NULL_MLOC; }
+TSReturnCode TSMimeHdrFieldDestroy(TSMBuffer /* bufp */, TSMLoc /* hdr */, TSMLoc /* field */) { return TS_SUCCESS; }
+TSReturnCode TSMimeHdrFieldAppend(TSMBuffer /* bufp */, TSMLoc /* hdr */, TSMLoc /* field */) { return TS_SUCCESS; }
+TSReturnCode TSMimeHdrFieldCreateNamed(TSMBuffer /* bufp */, TSMLoc /* hdr */, const char* /* name */, int /* len */, TSMLoc* /* locp */) { return TS_ERROR; }
+TSReturnCode TSMimeHdrFieldValueStringInsert(TSMBuffer /* bufp */, TSMLoc /* hdr */, TSMLoc /* field */, int /* idx */, const char* /* value */, int /* len */) { return TS_SUCCESS; }
+
+const char* TSUrlPathGet(TSMBuffer /* bufp */, TSMLoc /* offset */, int* length) { *length = 0; return ""; }
+const char* TSUrlHttpQueryGet(TSMBuffer /* bufp */, TSMLoc /* offset */, int* length) { *length = 0; return ""; }
+TSReturnCode TSUrlHostSet(TSMBuffer /* bufp */, TSMLoc /* offset */, const char* /* value */, int /* len */) { return TS_SUCCESS; }
+TSReturnCode TSUrlPortSet(TSMBuffer /* bufp */, TSMLoc /* offset */, int /* port */) { return TS_SUCCESS; }
+TSReturnCode TSUrlPathSet(TSMBuffer /* bufp */, TSMLoc /* offset */, const char* /* value */, int /* len */) { return TS_SUCCESS; }
+TSReturnCode TSUrlHttpQuerySet(TSMBuffer /* bufp */, TSMLoc /* offset */, const char* /* value */, int /* len */) { return TS_SUCCESS; }
+
+TSParseResult
+TSUrlParse(TSMBuffer /* bufp */, TSMLoc offset, const char** start, const char* end)
+{
+  assert(offset == (TSMLoc) &url_dummy);
+  parsed_url.assign(*start, end - *start);
+  *start = end;
+  return TS_PARSE_DONE;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Load a one rule config as a remap instance and run it on the transaction.
+//
+static void
+run_remap(const char* config)
+{
+  char fname[] = "/tmp/test_remap.XXXXXX";
+  int fd = mkstemp(fname);
+  assert(fd >= 0);
+  close(fd);
+
+  std::ofstream f(fname);
+  f << config << endl;
+  f.close();
+
+  char from[] = "http://from/";
+  char to[] = "http://to/";
+  char* argv[] = { from, to, fname };
+  char errbuf[256];
+  void* ih = NULL;
+
+  assert(TSRemapNewInstance(3, argv, &ih, errbuf, sizeof(errbuf)) == TS_SUCCESS);
+  unlink(fname);
+
+  TSRemapRequestInfo rri;
+
+  memset(&rri, 0, sizeof(rri));
+  rri.requestBufp = (TSMBuffer) &buf_dummy;
+  rri.requestHdrp = (TSMLoc) &hdr_dummy;
+  rri.requestUrl = (TSMLoc) &url_dummy;
+  TSRemapDoRemap(ih, (TSHttpTxn) &txn_dummy, &rri);
+  TSRemapDeleteInstance(ih);
+}
+
+int
+main()
+{
+  cout << "==================== Test 1: set-redirect in a remap rule" << endl;
+  reset_txn("X-Foo", "bar");
+  run_remap("set-redirect 302 http://example.com/");
+  assert(client_req_fetched);
+  assert(ret_status == TS_HTTP_STATUS_MOVED_TEMPORARILY);
+  assert(parsed_url == "http://example.com/");
+
+  cout << "==================== Test 2: set-redirect to a client header value" << endl;
+  reset_txn("X-Redirect", "http://elsewhere.example.com/a");
+  run_remap("set-redirect 301 %{CLIENT-HEADER:X-Redirect}");
+  assert(ret_status == TS_HTTP_STATUS_MOVED_PERMANENTLY);
+  assert(parsed_url == "http://elsewhere.example.com/a");
+
+  cout << "==================== Test 3: conditional set-redirect" << endl;
+  reset_txn("X-Mobile", "yes");
+  run_remap("cond %{CLIENT-HEADER:X-Mobile} =yes\nset-redirect 302 http://m.example.com/");
+  assert(ret_status == TS_HTTP_STATUS_MOVED_TEMPORARILY);
+  assert(parsed_url == "http://m.example.com/");
+
+  reset_txn("X-Mobile", "no");
+  run_remap("cond %{CLIENT-HEADER:X-Mobile} =yes\nset-redirect 302 http://m.example.com/");
+  assert(ret_status == TS_HTTP_STATUS_NONE);
+  assert(parsed_url.empty());
+
+  cout << endl << "All tests passed!" << endl;
+  return 0;
+}
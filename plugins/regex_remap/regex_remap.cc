@@ -35,6 +35,15 @@
 #include <pcre.h>
 #endif
 
+// Have PCRE JIT compile the regexes, when it can
+#ifdef PCRE_CONFIG_JIT
+#define PCRE_STUDY_OPTIONS PCRE_STUDY_JIT_COMPILE
+#define PCRE_FREE_STUDY pcre_free_study
+#else
+#define PCRE_STUDY_OPTIONS 0
+#define PCRE_FREE_STUDY pcre_free
+#endif
+
 #include <ctype.h>
 #include <unistd.h>
 
@@ -200,7 +209,7 @@ class RemapRegex
     if (_rex)
       pcre_free(_rex);
     if (_extra)
-      pcre_free(_extra);
+      PCRE_FREE_STUDY(_extra);
   };
 
   // For profiling information
@@ -232,7 +241,7 @@ class RemapRegex
     if (NULL == _rex)
       return -1;
 
-    _extra = pcre_study(_rex, 0, error);
+    _extra = pcre_study(_rex, PCRE_STUDY_OPTIONS, error);
     if ((_extra == NULL) && (*error != 0))
       return -1;
 
@@ -567,7 +567,8 @@ CoreUtils::test_HdrHeap(void *arg)
 
   if (read_from_core((intptr_t) magic_ptr, sizeof(uint32_t), (char *) &magic) != 0) {
     if (magic == HDR_BUF_MAGIC_ALIVE ||
-        magic == HDR_BUF_MAGIC_DEAD || magic == HDR_BUF_MAGIC_CORRUPT || magic == HDR_BUF_MAGIC_MARSHALED) {
+        magic == HDR_BUF_MAGIC_DEAD || magic == HDR_BUF_MAGIC_CORRUPT || magic == HDR_BUF_MAGIC_MARSHALED ||
+        magic == HDR_BUF_MAGIC_MARSHALED_PACKED) {
       // This is not 64-bit correct ... /leif
       printf("Found Hdr Heap @ 0x%p\n", arg);
     }
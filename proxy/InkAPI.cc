@@ -6980,6 +6980,12 @@ TSICPFreshnessFuncSet(TSPluginFreshnessCalcFunc funcp)
   pluginFreshnessCalcFunc = (PluginFreshnessCalcFunc) funcp;
 }
 
+void
+TSSslSessionStoreSet(TSSslSessionStoreGetFunc get, TSSslSessionStorePutFunc put, TSSslSessionStoreRemoveFunc remove)
+{
+  SSLSessionCache::set_store((SSLSessionStoreGetFunc) get, (SSLSessionStorePutFunc) put, (SSLSessionStoreRemoveFunc) remove);
+}
+
 TSReturnCode
 TSICPCachedReqGet(TSCont contp, TSMBuffer *bufp, TSMLoc *obj)
 {
@@ -7272,7 +7278,7 @@ TSAIOWrite(int fd, off_t offset, char* buf, const size_t bufSize, TSCont contp)
 TSReturnCode
 TSAIOThreadNumSet(int thread_num)
 {
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   (void)thread_num;
   return TS_SUCCESS;
 #else
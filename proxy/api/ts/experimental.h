@@ -187,6 +187,23 @@ extern "C"
   tsapi TSReturnCode TSHttpTxnShutDown(TSHttpTxn txnp, TSEvent event);
   tsapi TSReturnCode TSHttpTxnCloseAfterResponse(TSHttpTxn txnp, int should_close);
 
+  /****************************************************************************
+   *  External TLS session store, used with proxy.config.ssl.session_cache 2
+   *  so that servers behind a load balancer and restarted servers can
+   *  resume each others' sessions. Sessions are DER encoded. The functions
+   *  are called on the network threads in the middle of a handshake and
+   *  must not block for long; a miss only costs a full handshake.
+   *
+   *  get copies the session into buf and returns its length, or 0 if there
+   *  is none or it does not fit. Call this from TSPluginInit.
+   ****************************************************************************/
+  typedef int (*TSSslSessionStoreGetFunc) (const unsigned char *id, int id_len, unsigned char *buf, int buf_len);
+  typedef void (*TSSslSessionStorePutFunc) (const unsigned char *id, int id_len, const unsigned char *data, int len,
+                                            time_t expires);
+  typedef void (*TSSslSessionStoreRemoveFunc) (const unsigned char *id, int id_len);
+  tsapi void TSSslSessionStoreSet(TSSslSessionStoreGetFunc get, TSSslSessionStorePutFunc put,
+                                  TSSslSessionStoreRemoveFunc remove);
+
   // TS-2195: TSHttpTxnCacheLookupSkip() is deprecated, because TSHttpTxnConfigIntSet(txn, TS_CONFIG_HTTP_CACHE_HTTP, 0)
   // does the same thing, but better. TSHttpTxnCacheLookupSkip will be removed in TrafficServer 5.0.
   tsapi TS_DEPRECATED TSReturnCode TSHttpTxnCacheLookupSkip(TSHttpTxn txnp);
@@ -29,6 +29,7 @@
 #include "HTTP.h"
 #include "HdrToken.h"
 #include "Diags.h"
+#include "I_EventSystem.h"
 
 
 /***********************************************************************
@@ -303,6 +304,49 @@ http_hdr_create(HdrHeap *heap, HTTPType polarity)
   return (hh);
 }
 
+/*-------------------------------------------------------------------------
+  String heap sizes learned per polarity, so that when requests or
+  responses are typically larger than the default string heap they
+  start out with one that fits instead of demoting and coalescing
+  their way up. Each event thread learns its own, other threads get no
+  hint.
+  -------------------------------------------------------------------------*/
+
+static inline int *
+http_hdr_str_heap_hint()
+{
+  EThread *t = this_ethread();
+
+  if (!t)
+    return NULL;
+  if (unlikely(t->hdrStrHeapHint == NULL)) {
+    t->hdrStrHeapHint = new int[HTTP_TYPE_RESPONSE + 1];
+    memset(t->hdrStrHeapHint, 0, (HTTP_TYPE_RESPONSE + 1) * sizeof(int));
+  }
+  return t->hdrStrHeapHint;
+}
+
+void
+http_hdr_str_heap_presize(HdrHeap *heap, HTTPType polarity)
+{
+  int *hint = http_hdr_str_heap_hint();
+
+  if (hint && hint[polarity] > (int) (HDR_STR_HEAP_DEFAULT_SIZE - STR_HEAP_HDR_SIZE)) {
+    heap->presize_str_heap(hint[polarity]);
+  }
+}
+
+void
+http_hdr_str_heap_learn(HdrHeap *heap, HTTPType polarity)
+{
+  int *hint;
+
+  if (heap->m_writeable && (hint = http_hdr_str_heap_hint())) {
+    // moving average over about the last eight headers
+    hint[polarity] += (heap->str_heap_used() - hint[polarity]) / 8;
+  }
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -1673,6 +1717,19 @@ HTTPHdrImpl::move_strings(HdrStrHeap *new_heap)
   }
 }
 
+int
+HTTPHdrImpl::strings_length()
+{
+  if (m_polarity == HTTP_TYPE_REQUEST) {
+    return HDR_STR_LENGTH(u.req.m_ptr_method, u.req.m_len_method);
+  } else if (m_polarity == HTTP_TYPE_RESPONSE) {
+    return HDR_STR_LENGTH(u.resp.m_ptr_reason, u.resp.m_len_reason);
+  } else {
+    ink_release_assert(!"unknown m_polarity");
+  }
+  return 0;
+}
+
 void
 HTTPHdrImpl::check_strings(HeapCheck *heaps, int num_heaps)
 {
@@ -268,6 +268,7 @@ struct HTTPHdrImpl:public HdrHeapObjImpl
   int marshal(MarshalXlate *ptr_xlate, int num_ptr, MarshalXlate *str_xlate, int num_str);
   void unmarshal(intptr_t offset);
   void move_strings(HdrStrHeap *new_heap);
+  int strings_length();
 
   // Sanity Check Functions
   void check_strings(HeapCheck *heaps, int num_heaps);
@@ -454,6 +455,9 @@ inkcoreapi void http_hdr_method_set(HdrHeap *heap, HTTPHdrImpl *hh,
 
 void http_hdr_url_set(HdrHeap *heap, HTTPHdrImpl *hh, URLImpl *url);
 
+void http_hdr_str_heap_presize(HdrHeap *heap, HTTPType polarity);
+void http_hdr_str_heap_learn(HdrHeap *heap, HTTPType polarity);
+
 // HTTPStatus             http_hdr_status_get (HTTPHdrImpl *hh);
 void http_hdr_status_set(HTTPHdrImpl *hh, HTTPStatus status);
 const char *http_hdr_reason_get(HTTPHdrImpl *hh, int *length);
@@ -825,6 +829,7 @@ HTTPHdr::create(HTTPType polarity, HdrHeap *heap)
     m_heap = heap;
   } else if (!m_heap) {
     m_heap = new_HdrHeap();
+    http_hdr_str_heap_presize(m_heap, polarity);
   }
 
   m_http = http_hdr_create(m_heap, polarity);
@@ -39,12 +39,61 @@
 
 #define MAX_LOST_STR_SPACE 1024
 
-Allocator hdrHeapAllocator("hdrHeap", HDR_HEAP_DEFAULT_SIZE);
+// Heaps of the default size doubled up to HDR_HEAP_SIZE_CLASSES
+//   times come from per thread free lists, larger ones from malloc
+Allocator hdrHeapAllocator[HDR_HEAP_SIZE_CLASSES] = {
+  Allocator("hdrHeap", HDR_HEAP_DEFAULT_SIZE),
+  Allocator("hdrHeap4K", HDR_HEAP_DEFAULT_SIZE * 2),
+  Allocator("hdrHeap8K", HDR_HEAP_DEFAULT_SIZE * 4),
+  Allocator("hdrHeap16K", HDR_HEAP_DEFAULT_SIZE * 8)
+};
 static HdrHeap proto_heap;
 
-Allocator strHeapAllocator("hdrStrHeap", HDR_STR_HEAP_DEFAULT_SIZE);
+Allocator strHeapAllocator[HDR_HEAP_SIZE_CLASSES] = {
+  Allocator("hdrStrHeap", HDR_STR_HEAP_DEFAULT_SIZE),
+  Allocator("hdrStrHeap4K", HDR_STR_HEAP_DEFAULT_SIZE * 2),
+  Allocator("hdrStrHeap8K", HDR_STR_HEAP_DEFAULT_SIZE * 4),
+  Allocator("hdrStrHeap16K", HDR_STR_HEAP_DEFAULT_SIZE * 8)
+};
 static HdrStrHeap str_proto_heap;
 
+RecRawStatBlock *hdr_heap_rsb = NULL;
+
+// Smallest size class that holds size bytes, -1 if none does
+static inline int
+hdr_heap_fit_class(int size, int default_size)
+{
+  for (int i = 0; i < HDR_HEAP_SIZE_CLASSES; i++) {
+    if (size <= (default_size << i))
+      return i;
+  }
+  return -1;
+}
+
+// Size class of a heap of exactly size bytes, -1 if it was malloc'ed
+static inline int
+hdr_heap_size_class(int size, int default_size)
+{
+  for (int i = 0; i < HDR_HEAP_SIZE_CLASSES; i++) {
+    if (size == (default_size << i))
+      return i;
+  }
+  return -1;
+}
+
+// The calling thread, with its free lists for the size classes
+static inline EThread *
+hdr_heap_thread()
+{
+  EThread *t = this_ethread();
+
+  if (t && unlikely(t->hdrHeapAllocator == NULL)) {
+    t->hdrHeapAllocator = new ProxyAllocator[HDR_HEAP_SIZE_CLASSES];
+    t->strHeapAllocator = new ProxyAllocator[HDR_HEAP_SIZE_CLASSES];
+  }
+  return t;
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -116,9 +165,11 @@ HdrHeap *
 new_HdrHeap(int size)
 {
   HdrHeap *h;
-  if (size <= HDR_HEAP_DEFAULT_SIZE) {
-    size = HDR_HEAP_DEFAULT_SIZE;
-    h = (HdrHeap *)(THREAD_ALLOC(hdrHeapAllocator, this_ethread()));
+  int size_class = hdr_heap_fit_class(size, HDR_HEAP_DEFAULT_SIZE);
+
+  if (size_class >= 0) {
+    size = HDR_HEAP_DEFAULT_SIZE << size_class;
+    h = (HdrHeap *)(THREAD_ALLOC(hdrHeapAllocator[size_class], hdr_heap_thread()));
   } else {
     h = (HdrHeap *)ats_malloc(size);
   }
@@ -146,9 +197,11 @@ new_HdrStrHeap(int requested_size)
   int alloc_size = requested_size + sizeof(HdrStrHeap);
 
   HdrStrHeap *sh;
-  if (alloc_size <= HDR_STR_HEAP_DEFAULT_SIZE) {
-    alloc_size = HDR_STR_HEAP_DEFAULT_SIZE;
-    sh = (HdrStrHeap *)(THREAD_ALLOC(strHeapAllocator, this_ethread()));
+  int size_class = hdr_heap_fit_class(alloc_size, HDR_STR_HEAP_DEFAULT_SIZE);
+
+  if (size_class >= 0) {
+    alloc_size = HDR_STR_HEAP_DEFAULT_SIZE << size_class;
+    sh = (HdrStrHeap *)(THREAD_ALLOC(strHeapAllocator[size_class], hdr_heap_thread()));
   } else {
     alloc_size = ROUND(alloc_size, HDR_STR_HEAP_DEFAULT_SIZE*2);
     sh = (HdrStrHeap *)ats_malloc(alloc_size);
@@ -172,6 +225,15 @@ new_HdrStrHeap(int requested_size)
 void
 HdrHeap::destroy()
 {
+  // Learn the string heap size of the HTTP header this heap was made for,
+  // whichever handle it is destroyed through.
+  if (m_writeable && m_free_start > m_data_start) {
+    HdrHeapObjImpl *obj = (HdrHeapObjImpl *) m_data_start;
+
+    if (obj->m_type == HDR_HEAP_OBJ_HTTP_HEADER)
+      http_hdr_str_heap_learn(this, (HTTPType) ((HTTPHdrImpl *) obj)->m_polarity);
+  }
+
   if (m_next) {
     m_next->destroy();
   }
@@ -180,8 +242,10 @@ HdrHeap::destroy()
   for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++)
     m_ronly_heap[i].m_ref_count_ptr = NULL;
 
-  if (m_size == HDR_HEAP_DEFAULT_SIZE) {
-    THREAD_FREE(this, hdrHeapAllocator, this_ethread());
+  int size_class = hdr_heap_size_class(m_size, HDR_HEAP_DEFAULT_SIZE);
+
+  if (size_class >= 0) {
+    THREAD_FREE(this, hdrHeapAllocator[size_class], hdr_heap_thread());
   } else {
     ats_free(this);
   }
@@ -291,6 +355,32 @@ FAILED:
 
 }
 
+// void HdrHeap::presize_str_heap(int nbytes)
+//
+//   Starts the read/write string heap with room for nbytes
+//     so a header known to be large doesn't have to demote
+//     and coalesce its way up to that size
+//
+void
+HdrHeap::presize_str_heap(int nbytes)
+{
+  ink_assert(m_writeable);
+
+  if (!m_read_write_heap) {
+    m_read_write_heap = new_HdrStrHeap(nbytes);
+  }
+}
+
+// int HdrHeap::str_heap_used()
+//
+//   Bytes used in the read/write string heap
+//
+int
+HdrHeap::str_heap_used()
+{
+  return m_read_write_heap ? m_read_write_heap->used() : 0;
+}
+
 // char* HdrHeap::expand_str(const char* old_str, int old_len, int new_len)
 //
 //   Attempt to grow an already allocated string.  For this to work,
@@ -383,6 +473,12 @@ HdrHeap::coalesce_str_heaps(int incoming_size)
   evacuate_from_str_heaps(new_heap);
   m_lost_string_space = 0;
 
+  EThread *t = this_ethread();
+  if (hdr_heap_rsb && t) {
+    RecIncrRawStat(hdr_heap_rsb, t, hdr_heap_coalesce_count_stat, 1);
+    RecIncrRawStat(hdr_heap_rsb, t, hdr_heap_coalesce_bytes_stat, new_heap->used());
+  }
+
   // At this point none of the currently used string
   //  heaps are needed since everything is in the
   //  new string heap.  So deallocate all the old heaps
@@ -513,6 +609,49 @@ HdrHeap::sanity_check_strs()
 }
 
 
+// int HdrHeap::marshal_strings_length()
+//
+//  Adds up the live strings of the objects in the heap,
+//   which is all that marshal packs into the string heap
+//
+int
+HdrHeap::marshal_strings_length()
+{
+  int len = 0;
+  HdrHeap *h = this;
+
+  while (h) {
+    char *data = h->m_data_start;
+
+    while (data < h->m_free_start) {
+      HdrHeapObjImpl *obj = (HdrHeapObjImpl *) data;
+
+      switch (obj->m_type) {
+      case HDR_HEAP_OBJ_URL:
+        len += ((URLImpl *) obj)->strings_length();
+        break;
+      case HDR_HEAP_OBJ_HTTP_HEADER:
+        len += ((HTTPHdrImpl *) obj)->strings_length();
+        break;
+      case HDR_HEAP_OBJ_MIME_HEADER:
+        len += ((MIMEHdrImpl *) obj)->strings_length();
+        break;
+      case HDR_HEAP_OBJ_FIELD_BLOCK:
+        len += ((MIMEFieldBlockImpl *) obj)->strings_length();
+        break;
+      default:
+        break;
+      }
+
+      data = data + obj->m_length;
+    }
+
+    h = h->m_next;
+  }
+
+  return len;
+}
+
 // int HdrHeap::marshal_length()
 //
 //  Determines what the length of a buffer needs to
@@ -534,18 +673,10 @@ HdrHeap::marshal_length()
     h = h->m_next;
   }
 
-  // Since when we unmarshal, we won't have a writable string
-  //  heap, we can drop the header on the read/write
-  //  string heap
-  if (m_read_write_heap) {
-    len += m_read_write_heap->m_heap_size - (sizeof(HdrStrHeap) + m_read_write_heap->m_free_size);
-  }
-
-  for (int j = 0; j < HDR_BUF_RONLY_HEAPS; j++) {
-    if (m_ronly_heap[j].m_heap_start != NULL) {
-      len += m_ronly_heap[j].m_heap_len;
-    }
-  }
+  // Only the live strings get marshalled, so neither
+  //  lost string space nor the unused parts of read only
+  //  heaps (the raw header text) count
+  len += marshal_strings_length();
 
   len = ROUND(len, HDR_PTR_SIZE);
   return len;
@@ -608,7 +739,6 @@ HdrHeap::marshal(char *buf, int len)
   // Variables used later on.  Sunpro doesn't like
   //   bypassing initializations with gotos
   int used;
-  int i;
 
   HdrHeap *unmarshal_hdr = this;
 
@@ -645,13 +775,13 @@ HdrHeap::marshal(char *buf, int len)
   //  we can fill in the header on marshalled block
   marshal_hdr->m_free_start = NULL;
   marshal_hdr->m_data_start = (char *) HDR_HEAP_HDR_SIZE;       // offset
-  marshal_hdr->m_magic = HDR_BUF_MAGIC_MARSHALED;
+  marshal_hdr->m_magic = HDR_BUF_MAGIC_MARSHALED_PACKED;
   marshal_hdr->m_writeable = false;
   marshal_hdr->m_size = ptr_heap_size + HDR_HEAP_HDR_SIZE;
   marshal_hdr->m_next = NULL;
   marshal_hdr->m_free_size = 0;
   marshal_hdr->m_read_write_heap.m_ptr = NULL;
-  marshal_hdr->m_lost_string_space = this->m_lost_string_space;
+  marshal_hdr->m_lost_string_space = 0;
 
   // We'have one read-only string heap after marshalling
   marshal_hdr->m_ronly_heap[0].m_heap_start = (char *)(intptr_t)marshal_hdr->m_size;     // offset
@@ -660,60 +790,64 @@ HdrHeap::marshal(char *buf, int len)
   for (int i = 1; i < HDR_BUF_RONLY_HEAPS; i++)
     marshal_hdr->m_ronly_heap[i].m_heap_start = NULL;
 
-  // Next order of business is to copy over string heaps
-  //   As we are copying over the string heaps, build
-  //   translation table for string marshaling in the heap
-  //   objects
-  //
-  // FIX ME - really ought to check to see if lost_string_space
-  //   is too big and only copy over live strings if it is.  May
-  //   not be too much of a problem since I've prevented too much
-  //   lost string space both in string alloc and inherit
-  MarshalXlate str_xlation[HDR_BUF_RONLY_HEAPS + 1];
-
-  if (m_read_write_heap) {
-    char *copy_start = ((char *) m_read_write_heap.m_ptr) + sizeof(HdrStrHeap);
-    int nto_copy = m_read_write_heap->m_heap_size - (sizeof(HdrStrHeap) + m_read_write_heap->m_free_size);
-
-    if (nto_copy > len) {
-      goto Failed;
-    }
+  // Next order of business is the strings.  Rather than copying
+  //   the string heaps, which hold lost string space and, for
+  //   parsed headers, the whole raw header text, pack just the
+  //   live strings of the objects we copied above behind them.
+  //   Well-known field names are left out altogether.  Then
+  //   one translation table entry covers all the strings
+  MarshalXlate str_xlation[1];
+
+  str_size = marshal_strings_length();
+  if (str_size > len) {
+    goto Failed;
+  }
 
-    memcpy(b, copy_start, nto_copy);
+  {
+    HdrStrHeap str_heap;
+    char *obj_data = ((char *) marshal_hdr) + HDR_HEAP_HDR_SIZE;
+    char *mheap_end = ((char *) marshal_hdr) + marshal_hdr->m_size;
 
-    // FIX ME - possible offset overflow issues?
-    str_xlation[str_heaps].start = copy_start;
-    str_xlation[str_heaps].end = copy_start + nto_copy;
-    str_xlation[str_heaps].offset = copy_start - (b - buf);
+    str_heap.m_heap_size = str_size;
+    str_heap.m_free_start = b;
+    str_heap.m_free_size = str_size;
 
-    b += nto_copy;
-    len -= nto_copy;
-    str_size += nto_copy;
-    str_heaps++;
-  }
+    while (obj_data < mheap_end) {
+      HdrHeapObjImpl *obj = (HdrHeapObjImpl *) obj_data;
 
-  for (i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
-    if (m_ronly_heap[i].m_heap_start != NULL) {
-      if (m_ronly_heap[i].m_heap_len > len) {
-        goto Failed;
+      switch (obj->m_type) {
+      case HDR_HEAP_OBJ_URL:
+        ((URLImpl *) obj)->move_strings(&str_heap);
+        break;
+      case HDR_HEAP_OBJ_HTTP_HEADER:
+        ((HTTPHdrImpl *) obj)->move_strings(&str_heap);
+        break;
+      case HDR_HEAP_OBJ_MIME_HEADER:
+        ((MIMEHdrImpl *) obj)->marshal_strings(&str_heap);
+        break;
+      case HDR_HEAP_OBJ_FIELD_BLOCK:
+        ((MIMEFieldBlockImpl *) obj)->marshal_strings(&str_heap);
+        break;
+      default:
+        if (obj->m_length <= 0) {
+          ink_assert(0);
+          goto Failed;
+        }
+        break;
       }
 
-      memcpy(b, m_ronly_heap[i].m_heap_start, m_ronly_heap[i].m_heap_len);
-
-      // Add translation table entry for string heaps
-      //   FIX ME - possible offset overflow issues?
-      str_xlation[str_heaps].start = m_ronly_heap[i].m_heap_start;
-      str_xlation[str_heaps].end = m_ronly_heap[i].m_heap_start + m_ronly_heap[i].m_heap_len;
-      str_xlation[str_heaps].offset = str_xlation[str_heaps].start - (b - buf);
-      ink_assert(str_xlation[str_heaps].start <= str_xlation[str_heaps].end);
-
-      str_heaps++;
-      b += m_ronly_heap[i].m_heap_len;
-      len -= m_ronly_heap[i].m_heap_len;
-      str_size += m_ronly_heap[i].m_heap_len;
+      obj_data = obj_data + obj->m_length;
     }
+    ink_assert(str_heap.m_free_size == 0);
   }
 
+  str_xlation[0].start = b;
+  str_xlation[0].end = b + str_size;
+  str_xlation[0].offset = buf;
+  str_heaps = 1;
+  b += str_size;
+  len -= str_size;
+
   // Patch the str heap len
   marshal_hdr->m_ronly_heap[0].m_heap_len = str_size;
 
@@ -794,7 +928,7 @@ Failed:
 bool
 HdrHeap::check_marshalled(uint32_t buf_length)
 {
-  if (this->m_magic != HDR_BUF_MAGIC_MARSHALED) {
+  if (this->m_magic != HDR_BUF_MAGIC_MARSHALED && this->m_magic != HDR_BUF_MAGIC_MARSHALED_PACKED) {
     return false;
   }
 
@@ -843,8 +977,9 @@ HdrHeap::unmarshal(int buf_length, int obj_type, HdrHeapObjImpl ** found_obj, Re
 {
   bool obj_found = false;
 
-  // Check out this heap and make sure it is OK
-  if (m_magic != HDR_BUF_MAGIC_MARSHALED) {
+  // Check out this heap and make sure it is OK.  Heaps marshalled
+  //   before strings were packed are still fine as they are
+  if (m_magic != HDR_BUF_MAGIC_MARSHALED && m_magic != HDR_BUF_MAGIC_MARSHALED_PACKED) {
     ink_assert(!"HdrHeap::unmarshal bad magic");
     return -1;
   }
@@ -1104,8 +1239,10 @@ HdrHeap::dump_heap(int len)
 void
 HdrStrHeap::free()
 {
-  if (m_heap_size == HDR_STR_HEAP_DEFAULT_SIZE) {
-    THREAD_FREE(this, strHeapAllocator, this_ethread());
+  int size_class = hdr_heap_size_class(m_heap_size, HDR_STR_HEAP_DEFAULT_SIZE);
+
+  if (size_class >= 0) {
+    THREAD_FREE(this, strHeapAllocator[size_class], hdr_heap_thread());
   } else {
     ats_free(this);
   }
@@ -57,6 +57,10 @@
 #define HDR_HEAP_DEFAULT_SIZE   2048
 #define HDR_STR_HEAP_DEFAULT_SIZE   2048
 
+// Heaps of the default sizes doubled up to this many times come from per
+//   thread free lists, one for each size class.
+#define HDR_HEAP_SIZE_CLASSES 4
+
 #define HDR_MAX_ALLOC_SIZE (HDR_HEAP_DEFAULT_SIZE - sizeof(HdrHeap))
 #define HDR_HEAP_HDR_SIZE ROUND(sizeof(HdrHeap), HDR_PTR_SIZE)
 #define STR_HEAP_HDR_SIZE sizeof(HdrStrHeap)
@@ -135,6 +139,7 @@ enum
 {
   HDR_BUF_MAGIC_ALIVE = 0xabcdfeed,
   HDR_BUF_MAGIC_MARSHALED = 0xdcbafeed,
+  HDR_BUF_MAGIC_MARSHALED_PACKED = 0xdcbafeee, // live strings only, WKS field names by index
   HDR_BUF_MAGIC_DEAD = 0xabcddead,
   HDR_BUF_MAGIC_CORRUPT = 0xbadbadcc
 };
@@ -174,6 +179,11 @@ public:
   {
     return (str >= ((const char*)this + STR_HEAP_HDR_SIZE) && str < ((const char*)this + m_heap_size));
   }
+
+  int used() const
+  {
+    return m_heap_size - m_free_size - STR_HEAP_HDR_SIZE;
+  }
 };
 
 class CoreUtils;
@@ -194,11 +204,14 @@ public:
   char *expand_str(const char *old_str, int old_len, int new_len);
   char *duplicate_str(const char *str, int nbytes);
   void free_string(const char *s, int len);
+  void presize_str_heap(int nbytes);
+  int str_heap_used();
 
   // Marshalling
   inkcoreapi int marshal_length();
   inkcoreapi int marshal(char *buf, int length);
   int unmarshal(int buf_length, int obj_type, HdrHeapObjImpl ** found_obj, RefCountObj * block_ref);
+  int marshal_strings_length();
 
   void inherit_string_heaps(const HdrHeap * inherit_from);
   int attach_block(IOBufferBlock * b, const char *use_start);
@@ -414,11 +427,14 @@ if (ptr) { \
    } \
 }
 
+// Length of a string once marshalled
+#define HDR_STR_LENGTH(str, len) ((str) ? (int) (len) : 0)
+
 // Nasty macro to do verify all strings it
 //   in attached heaps
 #define CHECK_STR(str, len, _heaps, _num_heaps) \
 { \
-   if (str) { \
+   if (str && !hdrtoken_is_wks(str)) { \
      int found = 0; \
      for (int i = 0; i < _num_heaps; i++) { \
         if (str >= _heaps[i].start && \
@@ -490,5 +506,17 @@ HdrHeapSDKHandle::set(const HdrHeapSDKHandle * from)
 
 inkcoreapi HdrHeap *new_HdrHeap(int size = HDR_HEAP_DEFAULT_SIZE);
 
+// String heap coalesces, and the bytes they copied. The block is
+// registered by the HTTP stats, it stays NULL outside traffic_server.
+enum HdrHeapStats
+{
+  hdr_heap_coalesce_count_stat,
+  hdr_heap_coalesce_bytes_stat,
+  hdr_heap_stat_count
+};
+
+struct RecRawStatBlock;
+extern RecRawStatBlock *hdr_heap_rsb;
+
 void hdr_heap_test();
 #endif
@@ -44,6 +44,19 @@
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
+// If the header ends in a partial line and the rest of it will be
+//   read into the same block, leave the partial line in the reader
+//   rather than letting the scanner copy it.  The next parse then
+//   finds the whole line in the block and references it there.
+//
+static inline int
+http_parser_rewind(HTTPParser * parser, IOBufferReader * r, int64_t b_avail)
+{
+  if (b_avail != r->read_avail() || r->get_current_block()->write_avail() <= 0)
+    return 0;
+  return mime_scanner_rewind(&parser->m_mime_parser.m_scanner);
+}
+
 MIMEParseResult
 HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bool eof)
 {
@@ -52,6 +65,7 @@ HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, boo
   const char *tmp;
   const char *end;
   int used;
+  int rewound;
 
   ink_assert(valid());
   ink_assert(m_http->m_polarity == HTTP_TYPE_REQUEST);
@@ -74,6 +88,8 @@ HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, boo
 
     m_heap->lock_ronly_str_heap(heap_slot);
     state = http_parser_parse_req(parser, m_heap, m_http, &tmp, end, false, eof);
+    rewound = (state == PARSE_CONT) ? http_parser_rewind(parser, r, b_avail) : 0;
+    tmp -= rewound;
     m_heap->set_ronly_str_heap_end(heap_slot, tmp);
     m_heap->unlock_ronly_str_heap(heap_slot);
 
@@ -81,7 +97,7 @@ HTTPHdr::parse_req(HTTPParser * parser, IOBufferReader * r, int *bytes_used, boo
     r->consume(used);
     *bytes_used += used;
 
-  } while (state == PARSE_CONT);
+  } while (state == PARSE_CONT && rewound == 0);
 
   return state;
 }
@@ -93,6 +109,7 @@ HTTPHdr::parse_resp(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bo
   const char *tmp;
   const char *end;
   int used;
+  int rewound;
 
   ink_assert(valid());
   ink_assert(m_http->m_polarity == HTTP_TYPE_RESPONSE);
@@ -114,6 +131,8 @@ HTTPHdr::parse_resp(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bo
 
     m_heap->lock_ronly_str_heap(heap_slot);
     state = http_parser_parse_resp(parser, m_heap, m_http, &tmp, end, false, eof);
+    rewound = (state == PARSE_CONT) ? http_parser_rewind(parser, r, b_avail) : 0;
+    tmp -= rewound;
     m_heap->set_ronly_str_heap_end(heap_slot, tmp);
     m_heap->unlock_ronly_str_heap(heap_slot);
 
@@ -121,7 +140,7 @@ HTTPHdr::parse_resp(HTTPParser * parser, IOBufferReader * r, int *bytes_used, bo
     r->consume(used);
     *bytes_used += used;
 
-  } while (state == PARSE_CONT);
+  } while (state == PARSE_CONT && rewound == 0);
 
   return state;
 }
@@ -190,6 +209,14 @@ RETRY:
 //                 m_ronly_heap[i].m_heap_len,
 //                 i);
       return i;
+    } else if (m_ronly_heap[i].m_ref_count_ptr.m_ptr == b->data.m_ptr &&
+               m_ronly_heap[i].m_heap_start <= use_start &&
+               use_start <= m_ronly_heap[i].m_heap_start + m_ronly_heap[i].m_heap_len) {
+      // A later read into the same data picks up where the last
+      //   parse stopped, so extend the range instead of using
+      //   another slot (and coalescing once they run out)
+      m_ronly_heap[i].m_heap_len = (int) (b->end() - m_ronly_heap[i].m_heap_start);
+      return i;
     }
   }
 
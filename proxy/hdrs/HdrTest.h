@@ -56,9 +56,15 @@ private:
   int test_parse_date();
   int test_format_date();
   int test_url();
+  int test_url_key_hash();
+  int test_url_key_hash_benchmark();
   int test_http_parser_eos_boundary_cases();
+  int test_http_parse_in_place();
+  int test_marshal_packed();
+  int test_str_heap_presize();
   int test_arena();
   int test_regex();
+  int test_regex_benchmark();
   int test_accept_language_match();
   int test_accept_charset_match();
   int test_comma_vals();
@@ -68,6 +74,9 @@ private:
   int test_insert_comma_vals();
   int test_parse_comma_list();
   int test_mime();
+  int test_mime_boundaries();
+  int test_hdrtoken();
+  int test_hdrtoken_benchmark();
   int test_http();
   int test_http_mutation();
 
@@ -330,44 +330,108 @@ DFA *hdrtoken_strs_dfa = NULL;
  *                                                                     *
  ***********************************************************************/
 
-#define	HDRTOKEN_HASH_TABLE_SIZE	65536
-#define	HDRTOKEN_HASH_TABLE_MASK	HDRTOKEN_HASH_TABLE_SIZE-1
+/*
+  The commonly tokenized strings are looked up through a perfect hash
+  built at init time (hash and displace): the key hash picks one of
+  HDRTOKEN_PH_BUCKETS displacements, and the displaced hash picks the
+  slot.  Every slot holds at most one string, so a lookup is a single
+  probe followed by a compare.
+
+  Both the hash and the compare work on 8 byte words rather than
+  bytes.  Strings shorter than a word are packed into one word from
+  overlapping 4 byte loads, longer ones are covered by overlapping 8
+  byte loads, so nothing is read past the end of the string.  Case is
+  folded by or'ing in 0x20 at the letter positions of the well-known
+  string, which is exact for letters and leaves every other byte alone.
+*/
+
+#define HDRTOKEN_PH_TABLE_BITS    8
+#define HDRTOKEN_PH_TABLE_SIZE    (1 << HDRTOKEN_PH_TABLE_BITS)
+#define HDRTOKEN_PH_BUCKET_BITS   6
+#define HDRTOKEN_PH_BUCKETS       (1 << HDRTOKEN_PH_BUCKET_BITS)
+#define HDRTOKEN_PH_MAX_WORDS     3
+#define HDRTOKEN_PH_MAX_LENGTH    (HDRTOKEN_PH_MAX_WORDS * 8)
+#define HDRTOKEN_PH_FOLD          0x2020202020202020ULL
 
 struct HdrTokenHashBucket
 {
+  uint64_t words[HDRTOKEN_PH_MAX_WORDS];        // wks words, letters lowered
+  uint64_t fold[HDRTOKEN_PH_MAX_WORDS];         // 0x20 at letter positions
   const char *wks;
-  uint32_t hash;
+  int length;
 };
 
-HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
+// one cache line per slot
+HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_PH_TABLE_SIZE] __attribute__((aligned(64)));
+uint16_t hdrtoken_hash_displacements[HDRTOKEN_PH_BUCKETS];
 
-/**
-  basic FNV hash
-**/
-#define TINY_MASK(x) (((u_int32_t)1<<(x))-1)
+static inline uint64_t
+hdrtoken_load64(const unsigned char *s)
+{
+  uint64_t w;
+  memcpy(&w, s, sizeof(w));
+  return w;
+}
 
-inline uint32_t
-hash_to_slot(uint32_t hash)
+static inline uint64_t
+hdrtoken_load32(const unsigned char *s)
 {
-  return ((hash>>15) ^ hash) & TINY_MASK(15);
+  uint32_t w;
+  memcpy(&w, s, sizeof(w));
+  return w;
 }
 
-inline uint32_t
-hdrtoken_hash(const unsigned char *string, unsigned int length)
+/**
+  Word i of a string of the given length, 1 <= length.  Words overlap
+  so that the last one ends on the last byte of the string.
+*/
+static inline uint64_t
+hdrtoken_word(const unsigned char *s, int length, int i)
 {
-  static const uint32_t InitialFNV = 2166136261U;
-  static const int32_t FNVMultiple = 16777619;
+  if (length >= 8) {
+    int offset = i * 8;
+    return hdrtoken_load64(s + (offset < length - 8 ? offset : length - 8));
+  } else if (length >= 4) {
+    return hdrtoken_load32(s) | (hdrtoken_load32(s + length - 4) << 32);
+  } else {
+    return s[0] | (s[length >> 1] << 8) | (s[length - 1] << 16);
+  }
+}
 
-  uint32_t hash = InitialFNV;
+static inline int
+hdrtoken_num_words(int length)
+{
+  return (length + 7) >> 3;
+}
 
-  for (size_t i = 0; i < length; i++)  {
-      hash = hash ^ (toupper(string[i])); 
-      hash = hash * FNVMultiple;          
-  }
+static inline uint64_t
+hdrtoken_hash(const unsigned char *string, int length)
+{
+  uint64_t first = hdrtoken_word(string, length, 0) | HDRTOKEN_PH_FOLD;
+  uint64_t last = hdrtoken_word(string, length, hdrtoken_num_words(length) - 1) | HDRTOKEN_PH_FOLD;
+  uint64_t hash = (first * 0x9e3779b97f4a7c15ULL) ^ (last * 0xc2b2ae3d27d4eb4fULL) ^ (uint64_t) length;
 
+  hash ^= hash >> 31;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 29;
   return hash;
 }
 
+static inline uint32_t
+hash_to_bucket(uint64_t hash)
+{
+  return (uint32_t) (hash >> (64 - HDRTOKEN_PH_BUCKET_BITS));
+}
+
+static inline uint32_t
+hash_to_slot(uint64_t hash, uint32_t displacement)
+{
+  uint64_t x = hash + displacement * 0x9e3779b97f4a7c15ULL;
+  x ^= x >> 32;
+  x *= 0xff51afd7ed558ccdULL;
+  return (uint32_t) (x >> (64 - HDRTOKEN_PH_TABLE_BITS));
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -515,34 +579,94 @@ static const char *_hdrtoken_commonly_tokenized_strs[] = {
 void
 hdrtoken_hash_init()
 {
-  uint32_t i;
-  int num_collisions;
+  static const int num_strs = (int) SIZEOF(_hdrtoken_commonly_tokenized_strs);
+  const unsigned char *wks[SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+  uint64_t hashes[SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+  int bucket_size[HDRTOKEN_PH_BUCKETS];
+  int order[HDRTOKEN_PH_BUCKETS];
+  int i, j;
 
   memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
-  num_collisions = 0;
+  memset(hdrtoken_hash_displacements, 0, sizeof(hdrtoken_hash_displacements));
+  memset(bucket_size, 0, sizeof(bucket_size));
 
-  for (i = 0; i < (int) SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
+  for (i = 0; i < num_strs; i++) {
     // convert the common string to the well-known token
-    unsigned const char *wks;
     int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i],
                                         (int) strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **) &wks);
+                                        (const char **) &wks[i]);
     ink_release_assert(wks_idx >= 0);
+    ink_release_assert(hdrtoken_str_lengths[wks_idx] > 0 &&
+                       hdrtoken_str_lengths[wks_idx] <= HDRTOKEN_PH_MAX_LENGTH);
 
-    uint32_t hash = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    uint32_t slot = hash_to_slot(hash);
+    hashes[i] = hdrtoken_hash(wks[i], hdrtoken_str_lengths[wks_idx]);
+    ++bucket_size[hash_to_bucket(hashes[i])];
+  }
 
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n",
-             slot, (const char*)wks, hdrtoken_hash_table[slot].wks);
-      ++num_collisions;
+  // place the largest buckets first, while the table is still empty
+  for (i = 0; i < HDRTOKEN_PH_BUCKETS; i++) {
+    order[i] = i;
+  }
+  for (i = 1; i < HDRTOKEN_PH_BUCKETS; i++) {
+    for (j = i; j > 0 && bucket_size[order[j]] > bucket_size[order[j - 1]]; j--) {
+      int tmp = order[j];
+      order[j] = order[j - 1];
+      order[j - 1] = tmp;
     }
-    hdrtoken_hash_table[slot].wks = (const char *)wks;
-    hdrtoken_hash_table[slot].hash = hash;
   }
 
-  if (num_collisions > 0)
-    abort();
+  for (i = 0; i < HDRTOKEN_PH_BUCKETS && bucket_size[order[i]] > 0; i++) {
+    uint32_t bucket = order[i];
+    uint32_t slots[SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+    int members[SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+    int nmembers = 0;
+    uint32_t d;
+
+    for (j = 0; j < num_strs; j++) {
+      if (hash_to_bucket(hashes[j]) == bucket)
+        members[nmembers++] = j;
+    }
+
+    // find a displacement that puts every member into its own free slot
+    for (d = 0; d <= UINT16_MAX; d++) {
+      int k, l;
+
+      for (k = 0; k < nmembers; k++) {
+        slots[k] = hash_to_slot(hashes[members[k]], d);
+        if (hdrtoken_hash_table[slots[k]].wks)
+          break;
+        for (l = 0; l < k && slots[l] != slots[k]; l++);
+        if (l < k)
+          break;
+      }
+      if (k == nmembers)
+        break;
+    }
+
+    if (d > UINT16_MAX) {
+      printf("ERROR: hdrtoken_hash_table: no displacement for bucket %u ('%s', ...)\n", bucket,
+             (const char *) wks[members[0]]);
+      abort();
+    }
+
+    hdrtoken_hash_displacements[bucket] = (uint16_t) d;
+    for (j = 0; j < nmembers; j++) {
+      HdrTokenHashBucket *entry = &hdrtoken_hash_table[slots[j]];
+      const unsigned char *s = wks[members[j]];
+      int length = hdrtoken_wks_to_length((const char *) s);
+      unsigned char letters[HDRTOKEN_PH_MAX_LENGTH];
+
+      for (int k = 0; k < length; k++) {
+        letters[k] = ParseRules::is_alpha((char) s[k]) ? 0x20 : 0;
+      }
+      for (int k = 0; k < hdrtoken_num_words(length); k++) {
+        entry->fold[k] = hdrtoken_word(letters, length, k);
+        entry->words[k] = hdrtoken_word(s, length, k) | entry->fold[k];
+      }
+      entry->wks = (const char *) s;
+      entry->length = length;
+    }
+  }
 }
 
 
@@ -704,17 +828,22 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
     return wks_idx;
   }
 
-  uint32_t hash = hdrtoken_hash((const unsigned char *) string, (unsigned int) string_len);
-  uint32_t slot = hash_to_slot(hash);
-
-  bucket = &(hdrtoken_hash_table[slot]);
-  if ((bucket->wks != NULL) &&
-      (bucket->hash == hash) &&
-      (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
-    wks_idx = hdrtoken_wks_to_index(bucket->wks);
-    if (wks_string_out)
-      *wks_string_out = bucket->wks;
-    return wks_idx;
+  if (string_len > 0 && string_len <= HDRTOKEN_PH_MAX_LENGTH) {
+    const unsigned char *s = (const unsigned char *) string;
+    uint64_t hash = hdrtoken_hash(s, string_len);
+
+    bucket = &(hdrtoken_hash_table[hash_to_slot(hash, hdrtoken_hash_displacements[hash_to_bucket(hash)])]);
+    if (bucket->length == string_len) {
+      int i, n = hdrtoken_num_words(string_len);
+
+      for (i = 0; i < n && (hdrtoken_word(s, string_len, i) | bucket->fold[i]) == bucket->words[i]; i++);
+      if (i == n) {
+        wks_idx = hdrtoken_wks_to_index(bucket->wks);
+        if (wks_string_out)
+          *wks_string_out = bucket->wks;
+        return wks_idx;
+      }
+    }
   }
 
   Debug("hdr_token", "Did not find a WKS for '%.*s'", string_len, string);
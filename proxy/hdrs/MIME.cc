@@ -26,6 +26,9 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "MIME.h"
 #include "HdrHeap.h"
 #include "HdrToken.h"
@@ -2169,7 +2172,48 @@ _mime_scanner_init(MIMEScanner *scanner)
   scanner->m_line_size = 0;
   scanner->m_line_length = 0;
   scanner->m_state = MIME_PARSE_BEFORE;
-
+  scanner->m_colon = -1;
+  scanner->m_rewind = 0;
+  scanner->m_rewind_state = MIME_PARSE_BEFORE;
+}
+
+/*
+  Find the first LF in [s, e). If colon is not NULL and *colon is still NULL,
+  also look for the first ':' before that LF in the same pass, so that the
+  field parser does not have to go over the line again for it. Once the
+  colon is found the rest is left to memchr().
+*/
+static inline const char *
+mime_scan_lf(const char *s, const char *e, const char **colon)
+{
+  if (!colon || *colon)
+    return static_cast<char const*>(memchr(s, ParseRules::CHAR_LF, e - s));
+#if defined(__SSE2__)
+  const __m128i lf = _mm_set1_epi8(ParseRules::CHAR_LF);
+  const __m128i cl = _mm_set1_epi8(':');
+  for (; e - s >= 16; s += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) s);
+    unsigned lf_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+    unsigned colon_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, cl));
+    if (lf_mask)
+      colon_mask &= lf_mask - 1; // only the ones before the LF
+    if (colon_mask)
+      *colon = s + __builtin_ctz(colon_mask);
+    if (lf_mask)
+      return s + __builtin_ctz(lf_mask);
+    if (colon_mask)
+      return static_cast<char const*>(memchr(s + 16, ParseRules::CHAR_LF, e - s - 16));
+  }
+#endif
+  for (; s < e; ++s) {
+    if (*s == ParseRules::CHAR_LF)
+      return s;
+    if (*s == ':') {
+      *colon = s;
+      return static_cast<char const*>(memchr(s + 1, ParseRules::CHAR_LF, e - s - 1));
+    }
+  }
+  return NULL;
 }
 
 //////////////////////////////////////////////////////
@@ -2231,7 +2275,7 @@ mime_scanner_get(MIMEScanner *S,
                  bool raw_input_eof, ///< All data has been received for this header.
                  int raw_input_scan_type)
 {
-  const char *raw_input_c, *lf_ptr;
+  const char *raw_input_c, *lf_ptr, *colon;
   MIMEParseResult zret = PARSE_CONT;
   // Need this for handling dangling CR.
   static char const RAW_CR = ParseRules::CHAR_CR;
@@ -2241,6 +2285,10 @@ mime_scanner_get(MIMEScanner *S,
 
   raw_input_c = *raw_input_s;
 
+  bool fresh_line = (0 == S->m_line_length);
+  MimeParseState entry_state = S->m_state;
+  S->m_rewind = 0;
+
   while (PARSE_CONT == zret && raw_input_c < raw_input_e) {
     ptrdiff_t runway = raw_input_e - raw_input_c; // remaining input.
     switch (S->m_state) {
@@ -2260,6 +2308,7 @@ mime_scanner_get(MIMEScanner *S,
       } else {
         // consume this character in the next state.
         S->m_state = MIME_PARSE_INSIDE;
+        S->m_colon = -1;
       }
       break;
     case MIME_PARSE_FOUND_CR:
@@ -2275,10 +2324,17 @@ mime_scanner_get(MIMEScanner *S,
         // but the regression tests require it.
         mime_scanner_append(S, &RAW_CR, 1);
         S->m_state = MIME_PARSE_INSIDE;
+        S->m_colon = -1;
       }
       break;
     case MIME_PARSE_INSIDE:
-      lf_ptr = static_cast<char const*>(memchr(raw_input_c, ParseRules::CHAR_LF, runway));
+      colon = NULL;
+      lf_ptr = mime_scan_lf(raw_input_c, raw_input_e,
+                            (MIME_SCANNER_TYPE_FIELD == raw_input_scan_type && S->m_colon < 0) ? &colon : NULL);
+      // The line handed out is what has been buffered followed by the
+      // input from *raw_input_s on.
+      if (colon)
+        S->m_colon = (int) (S->m_line_length + (colon - *raw_input_s));
       if (lf_ptr) {
         raw_input_c = lf_ptr + 1;
         if (MIME_SCANNER_TYPE_LINE == raw_input_scan_type) {
@@ -2334,6 +2390,10 @@ mime_scanner_get(MIMEScanner *S,
     } else if (data_size) {
       // Inside a field but more data is expected. Save what we've got.
       mime_scanner_append(S, *raw_input_s, data_size);
+      if (fresh_line) {
+        S->m_rewind = (int) data_size;
+        S->m_rewind_state = entry_state;
+      }
       data_size = 0; // Don't append again.
     }
   } 
@@ -2361,6 +2421,29 @@ mime_scanner_get(MIMEScanner *S,
   return zret;
 }
 
+/**
+  Undo the last mime_scanner_get() that ran out of input in the middle
+  of a line, if that line started in that input.  The caller can hand
+  the returned number of bytes in again along with the rest of the line
+  once it arrives, so the line is handed out in place instead of from
+  the scanner's copy.
+
+  @return the number of input bytes given back, 0 if none.
+*/
+int
+mime_scanner_rewind(MIMEScanner *S)
+{
+  int n = S->m_rewind;
+
+  if (n > 0) {
+    S->m_state = S->m_rewind_state;
+    S->m_line_length = 0;
+    S->m_colon = -1;
+    S->m_rewind = 0;
+  }
+  return n;
+}
+
 void
 _mime_parser_init(MIMEParser *parser)
 {
@@ -2445,10 +2528,11 @@ mime_parser_parse(MIMEParser *parser, HdrHeap *heap, MIMEHdrImpl *mh, const char
     if ((!ParseRules::is_token(*field_name_first)) && (*field_name_first != '@'))
       continue;                 // toss away garbage line
 
-    // find name last
-    colon = (char *) memchr(line_c, ':', (line_e - line_c));
-    if (!colon)
+    // find name last, the scanner already looked for the colon
+    if (scanner->m_colon < 0)
       continue;                 // toss away garbage line
+    colon = line_s + scanner->m_colon;
+    ink_assert(colon < line_e && *colon == ':');
     field_name_last = colon - 1;
     while ((field_name_last >= field_name_first) && is_ws(*field_name_last))
       --field_name_last;
@@ -3526,7 +3610,12 @@ MIMEFieldBlockImpl::unmarshal(intptr_t offset)
 
     // FIX ME - DO I NEED TO DEAL WITH OTHER READINESSES?
     if (field->m_readiness == MIME_FIELD_SLOT_READINESS_LIVE) {
-      HDR_UNMARSHAL_STR(field->m_ptr_name, offset);
+      if (field->m_ptr_name == NULL && field->m_wks_idx >= 0) {
+        // packed heaps keep well-known names as just the index
+        field->m_ptr_name = hdrtoken_index_to_wks(field->m_wks_idx);
+      } else {
+        HDR_UNMARSHAL_STR(field->m_ptr_name, offset);
+      }
       HDR_UNMARSHAL_STR(field->m_ptr_value, offset);
       if (field->m_next_dup) {
         HDR_UNMARSHAL_PTR(field->m_next_dup, MIMEField, offset);
@@ -3554,6 +3643,90 @@ MIMEFieldBlockImpl::move_strings(HdrStrHeap *new_heap)
   }
 }
 
+// A live field name spelled exactly like its well-known string does
+//   not need to be marshalled, the index is enough to get it back
+static inline bool
+mime_field_name_is_wks(MIMEField *field)
+{
+  if (field->m_wks_idx < 0 || field->m_ptr_name == NULL)
+    return false;
+
+  const char *wks = hdrtoken_index_to_wks(field->m_wks_idx);
+
+  return (field->m_ptr_name == wks) ||
+    (field->m_len_name == hdrtoken_index_to_length(field->m_wks_idx) &&
+     memcmp(field->m_ptr_name, wks, field->m_len_name) == 0);
+}
+
+// A raw printable field laid out as "name: value\r\n" prints the same
+//   without its raw span, anything else has to keep it
+static inline bool
+mime_field_raw_is_standard(MIMEField *field)
+{
+  return (field->m_n_v_raw_printable_pad == 4 &&
+          field->m_ptr_value == field->m_ptr_name + field->m_len_name + 2 &&
+          field->m_ptr_name[field->m_len_name] == ':' && field->m_ptr_name[field->m_len_name + 1] == ' ');
+}
+
+// Packs the strings of the live fields of a marshalled copy of
+//   this block into the marshal string heap
+void
+MIMEFieldBlockImpl::marshal_strings(HdrStrHeap *new_heap)
+{
+  for (uint32_t index = 0; index < m_freetop; index++) {
+    MIMEField *field = &(m_field_slots[index]);
+
+    if (field->m_readiness == MIME_FIELD_SLOT_READINESS_LIVE) {
+      if (field->m_n_v_raw_printable && !mime_field_raw_is_standard(field)) {
+        // Move the raw field in one shot so it still prints as received
+        int total_len = field->m_len_name + field->m_len_value + field->m_n_v_raw_printable_pad;
+        int value_offset = field->m_ptr_value - field->m_ptr_name;
+        char *new_str = new_heap->allocate(total_len);
+
+        if (new_str) {
+          memcpy(new_str, field->m_ptr_name, total_len);
+          field->m_ptr_name = new_str;
+          field->m_ptr_value = new_str + value_offset;
+        } else {
+          field->m_ptr_name = NULL;
+          field->m_ptr_value = NULL;
+          field->m_n_v_raw_printable = 0;
+        }
+        continue;
+      }
+      field->m_n_v_raw_printable = 0;
+
+      if (mime_field_name_is_wks(field)) {
+        field->m_ptr_name = NULL;
+      } else {
+        HDR_MOVE_STR(field->m_ptr_name, field->m_len_name);
+      }
+      HDR_MOVE_STR(field->m_ptr_value, field->m_len_value);
+    }
+  }
+}
+
+int
+MIMEFieldBlockImpl::strings_length()
+{
+  int len = 0;
+
+  for (uint32_t index = 0; index < m_freetop; index++) {
+    MIMEField *field = &(m_field_slots[index]);
+
+    if (field->m_readiness == MIME_FIELD_SLOT_READINESS_LIVE) {
+      if (field->m_n_v_raw_printable && !mime_field_raw_is_standard(field)) {
+        len += field->m_len_name + field->m_len_value + field->m_n_v_raw_printable_pad;
+        continue;
+      }
+      if (!mime_field_name_is_wks(field))
+        len += HDR_STR_LENGTH(field->m_ptr_name, field->m_len_name);
+      len += HDR_STR_LENGTH(field->m_ptr_value, field->m_len_value);
+    }
+  }
+  return len;
+}
+
 void
 MIMEFieldBlockImpl::check_strings(HeapCheck *heaps, int num_heaps)
 {
@@ -3590,6 +3763,18 @@ MIMEHdrImpl::move_strings(HdrStrHeap *new_heap)
   m_first_fblock.move_strings(new_heap);
 }
 
+void
+MIMEHdrImpl::marshal_strings(HdrStrHeap *new_heap)
+{
+  m_first_fblock.marshal_strings(new_heap);
+}
+
+int
+MIMEHdrImpl::strings_length()
+{
+  return m_first_fblock.strings_length();
+}
+
 void
 MIMEHdrImpl::check_strings(HeapCheck *heaps, int num_heaps)
 {
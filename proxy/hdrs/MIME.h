@@ -167,6 +167,8 @@ struct MIMEFieldBlockImpl:public HdrHeapObjImpl
   int marshal(MarshalXlate * ptr_xlate, int num_ptr, MarshalXlate * str_xlate, int num_str);
   void unmarshal(intptr_t offset);
   void move_strings(HdrStrHeap * new_heap);
+  void marshal_strings(HdrStrHeap * new_heap);
+  int strings_length();
 
   // Sanity Check Functions
   void check_strings(HeapCheck * heaps, int num_heaps);
@@ -239,6 +241,8 @@ struct MIMEHdrImpl:public HdrHeapObjImpl
   int marshal(MarshalXlate * ptr_xlate, int num_ptr, MarshalXlate * str_xlate, int num_str);
   void unmarshal(intptr_t offset);
   void move_strings(HdrStrHeap * new_heap);
+  void marshal_strings(HdrStrHeap * new_heap);
+  int strings_length();
 
   // Sanity Check Functions
   void check_strings(HeapCheck * heaps, int num_heaps);
@@ -261,6 +265,9 @@ struct MIMEScanner
   int m_line_size;              // total allocated size of buffer
 //  int m_state;                  // state of scanning state machine
   MimeParseState m_state; ///< Parsing machine state.
+  int m_colon;                  // offset of the first ':' in the field line, -1 if none
+  int m_rewind;                 // bytes of the last input buffered in m_line, 0 if m_line holds older input
+  MimeParseState m_rewind_state; // state before the last input
 };
 
 
@@ -661,6 +668,7 @@ void mime_scanner_append(MIMEScanner * scanner, const char *data, int data_size)
 MIMEParseResult mime_scanner_get(MIMEScanner * S, const char **raw_input_s, const char *raw_input_e,
                                  const char **output_s, const char **output_e,
                                  bool * output_shares_raw_input, bool raw_input_eof, int raw_input_scan_type);
+int mime_scanner_rewind(MIMEScanner * S);
 
 void mime_parser_init(MIMEParser * parser);
 void mime_parser_clear(MIMEParser * parser);
@@ -86,6 +86,7 @@ int URL_LEN_MMSU;
 int URL_LEN_MMST;
 
 int url_hash_method = 0;
+int url_key_hash = URL_KEY_HASH_MD5;
 
 
 /*-------------------------------------------------------------------------
@@ -257,6 +258,7 @@ url_nuke_proxy_stuff(URLImpl * d_url)
 
   d_url->m_scheme_wks_idx = -1;
   d_url->m_port = 0;
+  url_called_set(d_url);
 }
 
 /*-------------------------------------------------------------------------
@@ -328,6 +330,11 @@ URLImpl::unmarshal(intptr_t offset)
   HDR_UNMARSHAL_STR(m_ptr_query, offset);
   HDR_UNMARSHAL_STR(m_ptr_fragment, offset);
 //    HDR_UNMARSHAL_STR(m_ptr_printed_string, offset);
+  // The printed string was never marshalled, so don't trust it
+  m_ptr_printed_string = NULL;
+  m_len_printed_string = 0;
+  m_clean = true;
+  m_md5_valid = false;
 }
 
 void
@@ -343,6 +350,18 @@ URLImpl::move_strings(HdrStrHeap * new_heap)
   HDR_MOVE_STR(m_ptr_query, m_len_query);
   HDR_MOVE_STR(m_ptr_fragment, m_len_fragment);
 //    HDR_MOVE_STR(m_ptr_printed_string, m_len_printed_string);
+  // The printed string is left behind and rebuilt on demand
+  url_clear_string_ref(this);
+}
+
+int
+URLImpl::strings_length()
+{
+  return HDR_STR_LENGTH(m_ptr_scheme, m_len_scheme) + HDR_STR_LENGTH(m_ptr_user, m_len_user) +
+    HDR_STR_LENGTH(m_ptr_password, m_len_password) + HDR_STR_LENGTH(m_ptr_host, m_len_host) +
+    HDR_STR_LENGTH(m_ptr_port, m_len_port) + HDR_STR_LENGTH(m_ptr_path, m_len_path) +
+    HDR_STR_LENGTH(m_ptr_params, m_len_params) + HDR_STR_LENGTH(m_ptr_query, m_len_query) +
+    HDR_STR_LENGTH(m_ptr_fragment, m_len_fragment);
 }
 
 void
@@ -536,6 +555,7 @@ void
 url_called_set(URLImpl * url)
 {
   url->m_clean = !url->m_ptr_printed_string;
+  url->m_md5_valid = false;
 }
 
 void
@@ -545,10 +565,25 @@ url_clear_string_ref(URLImpl * url)
     url->m_len_printed_string = 0;
     url->m_ptr_printed_string = NULL;
     url->m_clean = true;
+    url->m_md5_valid = false;
   }
   return;
 }
 
+// The printed string has room after its NUL for the MD5 of
+//   the url, see url_MD5_get_ref()
+static char *
+url_printed_string_alloc(HdrHeap * heap, URLImpl * url, int len)
+{
+  char *buf = heap->allocate_str(len + 1 + sizeof(INK_MD5));
+
+  url->m_clean = true;
+  url->m_md5_valid = false;
+  url->m_len_printed_string = len;
+  url->m_ptr_printed_string = buf;
+  return buf;
+}
+
 char *
 url_string_get_ref(HdrHeap * heap, URLImpl * url, int *length)
 {
@@ -566,16 +601,13 @@ url_string_get_ref(HdrHeap * heap, URLImpl * url, int *length)
     int offset = 0;
 
     /* stuff alloc'd here gets gc'd on HdrHeap::destroy() */
-    buf = heap->allocate_str(len + 1);
+    buf = url_printed_string_alloc(heap, url, len);
     url_print(url, buf, len, &index, &offset);
     buf[len] = '\0';
 
     if (length) {
       *length = len;
     }
-    url->m_clean = true;          //reset since we have url_print()'ed again
-    url->m_len_printed_string = len;
-    url->m_ptr_printed_string = buf;
     return buf;
   }
 }
@@ -596,12 +628,9 @@ url_string_get(URLImpl * url, Arena * arena, int *length, HdrHeap * heap)
 
   /* see string_get_ref() */
   if (heap) {
-    buf2 = heap->allocate_str(len + 1);
+    buf2 = url_printed_string_alloc(heap, url, len);
     memcpy(buf2, buf, len);
     buf2[len] = '\0';
-    url->m_clean = true;          //reset since we have url_print()'ed again
-    url->m_len_printed_string = len;
-    url->m_ptr_printed_string = buf2;
   }
 
   if (length) {
@@ -1540,18 +1569,51 @@ memcpy_tolower(char *d, const char *s, int n)
 
 #define BUFSIZE 512
 
+// Incremental hash for cache keys, as picked by url_key_hash
+struct URLKeyHashContext
+{
+  int m_hash;
+  union
+  {
+    INK_DIGEST_CTX md5;
+    INK_MURMUR3_CTX murmur3;
+  } m_ctx;
+
+  URLKeyHashContext():m_hash(url_key_hash)
+  {
+    if (m_hash == URL_KEY_HASH_MURMUR3)
+      ink_code_incr_murmur3_init(&m_ctx.murmur3);
+    else
+      ink_code_incr_md5_init(&m_ctx.md5);
+  }
+
+  void update(const char *input, int length)
+  {
+    if (m_hash == URL_KEY_HASH_MURMUR3)
+      ink_code_incr_murmur3_update(&m_ctx.murmur3, input, length);
+    else
+      ink_code_incr_md5_update(&m_ctx.md5, input, length);
+  }
+
+  void final(INK_MD5 * md5)
+  {
+    if (m_hash == URL_KEY_HASH_MURMUR3)
+      ink_code_incr_murmur3_final((char *) md5, &m_ctx.murmur3);
+    else
+      ink_code_incr_md5_final((char *) md5, &m_ctx.md5);
+  }
+};
+
 // fast path for MD5, HTTP, no user/password/params/query,
 // no buffer overflow, no unescaping needed
 
 static inline void
 url_MD5_get_fast(URLImpl * url, INK_MD5 * md5)
 {
-  INK_DIGEST_CTX md5_ctx;
+  URLKeyHashContext ctx;
   char buffer[BUFSIZE];
   char *p;
 
-  ink_code_incr_md5_init(&md5_ctx);
-
   p = buffer;
   memcpy_tolower(p, url->m_ptr_scheme, url->m_len_scheme);
   p += url->m_len_scheme;
@@ -1577,15 +1639,15 @@ url_MD5_get_fast(URLImpl * url, INK_MD5 * md5)
   *p++ = ((char *) &port)[0];
   *p++ = ((char *) &port)[1];
 
-  ink_code_incr_md5_update(&md5_ctx, buffer, p - buffer);
-  ink_code_incr_md5_final((char *) md5, &md5_ctx);
+  ctx.update(buffer, p - buffer);
+  ctx.final(md5);
 }
 
 
 static inline void
 url_MD5_get_general(URLImpl * url, INK_MD5 * md5)
 {
-  INK_DIGEST_CTX md5_ctx;
+  URLKeyHashContext ctx;
 
   char buffer[BUFSIZE];
   char *p, *e;
@@ -1626,8 +1688,6 @@ url_MD5_get_general(URLImpl * url, INK_MD5 * md5)
   p = buffer;
   e = buffer + BUFSIZE;
 
-  ink_code_incr_md5_init(&md5_ctx);
-
   for (i = 0; i < 13; i++) {
     if (strs[i]) {
       t = strs[i];
@@ -1641,7 +1701,7 @@ url_MD5_get_general(URLImpl * url, INK_MD5 * md5)
         }
 
         if (p == e) {
-	  ink_code_incr_md5_update(&md5_ctx, buffer, BUFSIZE);
+	  ctx.update(buffer, BUFSIZE);
           p = buffer;
         }
       }
@@ -1649,13 +1709,13 @@ url_MD5_get_general(URLImpl * url, INK_MD5 * md5)
   }
 
   if (p != buffer) {
-    ink_code_incr_md5_update(&md5_ctx, buffer, p - buffer);
+    ctx.update(buffer, p - buffer);
   }
 
   port = url_canonicalize_port(url->m_url_type, url->m_port);
 
-  ink_code_incr_md5_update(&md5_ctx, (char *) &port, sizeof(port));
-  ink_code_incr_md5_final((char *) md5, &md5_ctx);
+  ctx.update((char *) &port, sizeof(port));
+  ctx.final(md5);
 }
 
 
@@ -1685,6 +1745,33 @@ url_MD5_get(URLImpl * url, INK_MD5 * md5)
   }
 }
 
+/*-------------------------------------------------------------------------
+  Like url_MD5_get() but keeps the MD5 with the printed string in
+  the heap, so it is only computed again after the url is changed.
+  -------------------------------------------------------------------------*/
+
+void
+url_MD5_get_ref(HdrHeap * heap, URLImpl * url, INK_MD5 * md5)
+{
+  if (url->m_md5_valid && url->m_clean && url->m_ptr_printed_string) {
+    md5->loadFromBuffer((char *) url->m_ptr_printed_string + url->m_len_printed_string + 1);
+    return;
+  }
+
+  url_MD5_get(url, md5);
+
+  // Headers read from the cache are shared, leave them alone
+  if (heap && heap->m_writeable) {
+    int len;
+    char *str = url_string_get_ref(heap, url, &len);
+
+    if (len == url->m_len_printed_string) {
+      md5->storeToBuffer(str + len + 1);
+      url->m_md5_valid = true;
+    }
+  }
+}
+
 #undef BUFSIZE
 
 /*-------------------------------------------------------------------------
@@ -74,12 +74,14 @@ struct URLImpl:public HdrHeapObjImpl
   // 6 bytes
 
   uint32_t m_clean:1;
-  // 8 bytes + 1 bit, will result in padding
+  uint32_t m_md5_valid:1;         // MD5 is kept after the printed string
+  // 8 bytes + 2 bits, will result in padding
 
   // Marshaling Functions
   int marshal(MarshalXlate *str_xlate, int num_xlate);
   void unmarshal(intptr_t offset);
   void move_strings(HdrStrHeap *new_heap);
+  int strings_length();
 
   // Sanity Check Functions
   void check_strings(HeapCheck *heaps, int num_heaps);
@@ -143,6 +145,16 @@ extern int URL_LEN_MMS;
 extern int URL_LEN_MMSU;
 extern int URL_LEN_MMST;
 
+// How url_MD5_get() makes cache keys, they are still held in an INK_MD5
+enum URLKeyHash
+{
+  URL_KEY_HASH_MD5 = 0,
+  URL_KEY_HASH_MURMUR3 = 1
+};
+
+extern int url_key_hash;
+extern int url_hash_method;       // non zero hashes simple http urls without unescaping
+
 /* Private */
 void url_adjust(MarshalXlate *str_xlate, int num_xlate);
 
@@ -170,6 +182,7 @@ char *url_string_get_buf(URLImpl *url, char *dstbuf, int dstbuf_size, int *lengt
 
 const char *url_scheme_get(URLImpl *url, int *length);
 void url_MD5_get(URLImpl *url, INK_MD5 *md5);
+void url_MD5_get_ref(HdrHeap *heap, URLImpl *url, INK_MD5 *md5);
 void url_host_MD5_get(URLImpl *url, INK_MD5 *md5);
 const char *url_scheme_set(HdrHeap *heap, URLImpl *url,
                            const char *value, int value_wks_idx, int length, bool copy_string);
@@ -436,7 +449,7 @@ inline void
 URL::MD5_get(INK_MD5 *md5)
 {
   ink_assert(valid());
-  url_MD5_get(m_url_impl, md5);
+  url_MD5_get_ref(m_heap, m_url_impl, md5);
 }
 
 /*-------------------------------------------------------------------------
@@ -115,6 +115,7 @@ HttpCacheSM::state_cache_open_read(int event, void *data)
     ink_assert(cache_read_vc == NULL);
     open_read_cb = true;
     cache_read_vc = (CacheVConnection *) data;
+    readwhilewrite_inprogress = cache_read_vc->is_read_from_writer();
     master_sm->handleEvent(event, data);
     break;
 
@@ -173,6 +174,20 @@ HttpCacheSM::state_cache_open_write(int event, void *data)
     break;
 
   case CACHE_EVENT_OPEN_WRITE_FAILED:
+    if (data == (void *) -ECACHE_DOC_BUSY && master_sm->t_state.http_config_param->cache_collapsed_forwarding &&
+        master_sm->t_state.cache_info.action == HttpTransact::CACHE_PREPARE_TO_WRITE) {
+      // Somebody else is fetching the object, read it from their write
+      // instead of going to the origin server as well
+      Debug("http_cache", "[%" PRId64 "] [state_cache_open_write] write lock busy, collapsing", master_sm->sm_id);
+      SET_HANDLER(&HttpCacheSM::state_cache_collapsed_read);
+      this->readwhilewrite_inprogress = false;
+      Action *action_handle = cacheProcessor.open_read(this, this->lookup_url,
+                                                       master_sm->t_state.cache_control.cluster_cache_local,
+                                                       this->read_request_hdr, this->read_config, this->read_pin_in_cache);
+      if (action_handle != ACTION_RESULT_DONE && !open_write_cb)
+        pending_action = action_handle;
+      break;
+    }
     // The cache is hosed or full or something.
     // Forward the failure to the main sm
     open_write_cb = true;
@@ -186,6 +201,49 @@ HttpCacheSM::state_cache_open_write(int event, void *data)
   return VC_EVENT_CONT;
 }
 
+//////////////////////////////////////////////////////////////////////////
+//
+//  HttpCacheSM::state_cache_collapsed_read()
+//
+//  Open read issued after the open write found another writer. The
+//  cache keeps the read waiting on that writer, so the outcome is
+//  reported to the main sm as the result of its open write:
+// - CACHE_EVENT_OPEN_READ
+//   - read from the writer, the main sm handles it as a read retry
+// - CACHE_EVENT_OPEN_READ_FAILED
+//   - the writer aborted or the object is not cacheable, reported
+//     as the open write failure so that the main sm goes to the
+//     origin server without caching
+//
+//////////////////////////////////////////////////////////////////////////
+int
+HttpCacheSM::state_cache_collapsed_read(int event, void *data)
+{
+  STATE_ENTER(&HttpCacheSM::state_cache_collapsed_read, event);
+  ink_assert(captive_action.cancelled == 0);
+  pending_action = NULL;
+  open_write_cb = true;
+
+  switch (event) {
+  case CACHE_EVENT_OPEN_READ:
+    HTTP_INCREMENT_DYN_STAT(http_current_cache_connections_stat);
+    ink_assert(cache_read_vc == NULL);
+    cache_read_vc = (CacheVConnection *) data;
+    readwhilewrite_inprogress = cache_read_vc->is_read_from_writer();
+    master_sm->handleEvent(event, data);
+    break;
+
+  case CACHE_EVENT_OPEN_READ_FAILED:
+    master_sm->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *) -ECACHE_DOC_BUSY);
+    break;
+
+  default:
+    ink_release_assert(0);
+  }
+
+  return VC_EVENT_CONT;
+}
+
 void
 HttpCacheSM::do_schedule_in()
 {
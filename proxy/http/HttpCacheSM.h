@@ -150,6 +150,7 @@ private:
 
   int state_cache_open_read(int event, void *data);
   int state_cache_open_write(int event, void *data);
+  int state_cache_collapsed_read(int event, void *data);
 
   HttpCacheAction captive_action;
   bool open_read_cb;
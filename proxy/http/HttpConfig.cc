@@ -1103,6 +1103,17 @@ register_stat_callbacks()
                      RECD_COUNTER, RECP_NULL,
                      (int) http_total_x_redirect_stat, RecRawStatSyncCount);
 
+  // counted by libhdrs, which has no stats of its own
+  hdr_heap_rsb = RecAllocateRawStatBlock((int) hdr_heap_stat_count);
+  RecRegisterRawStat(hdr_heap_rsb, RECT_PROCESS,
+                     "proxy.process.http.hdr_heap.coalesce_count",
+                     RECD_INT, RECP_NON_PERSISTENT,
+                     (int) hdr_heap_coalesce_count_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(hdr_heap_rsb, RECT_PROCESS,
+                     "proxy.process.http.hdr_heap.coalesce_bytes",
+                     RECD_INT, RECP_NON_PERSISTENT,
+                     (int) hdr_heap_coalesce_bytes_stat, RecRawStatSyncSum);
+
 }
 
 
@@ -1265,6 +1276,9 @@ HttpConfig::startup()
 
   // open write failure retries
   HttpEstablishStaticConfigLongLong(c.max_cache_open_write_retries, "proxy.config.http.cache.max_open_write_retries");
+  HttpEstablishStaticConfigByte(c.cache_collapsed_forwarding, "proxy.config.http.cache.collapsed_forwarding");
+
+  HttpEstablishStaticConfigLongLong(c.cache_zero_copy_min_size, "proxy.config.http.cache.zero_copy_min_size");
 
   HttpEstablishStaticConfigByte(c.oride.cache_http, "proxy.config.http.cache.http");
   HttpEstablishStaticConfigByte(c.oride.cache_cluster_cache_local, "proxy.config.http.cache.cluster_cache_local");
@@ -1532,6 +1546,8 @@ HttpConfig::reconfigure()
 
   // open write failure retries
   params->max_cache_open_write_retries = m_master.max_cache_open_write_retries;
+  params->cache_collapsed_forwarding = INT_TO_BOOL(m_master.cache_collapsed_forwarding);
+  params->cache_zero_copy_min_size = m_master.cache_zero_copy_min_size;
 
   params->oride.cache_http = INT_TO_BOOL(m_master.oride.cache_http);
   params->oride.cache_cluster_cache_local = INT_TO_BOOL(m_master.oride.cache_cluster_cache_local);
@@ -715,6 +715,14 @@ public:
   // open write failure retries.
   MgmtInt max_cache_open_write_retries;
 
+  // when another transaction holds the write lock, read from its
+  // cache write instead of going to the origin as well.
+  MgmtByte cache_collapsed_forwarding;
+
+  // cache hits at least this large are sent to plain HTTP clients with
+  // zero copy socket writes, 0 disables.
+  MgmtInt cache_zero_copy_min_size;
+
   ///////////////////
   // cache control //
   ///////////////////
@@ -927,6 +935,8 @@ HttpConfigParams::HttpConfigParams()
     cache_vary_default_images(NULL),
     cache_vary_default_other(NULL),
     max_cache_open_write_retries(1),
+    cache_collapsed_forwarding(0),
+    cache_zero_copy_min_size(0),
     cache_enable_default_vary_headers(0),
     cache_when_to_add_no_cache_to_msie_requests(-1),
     connect_ports_string(NULL),
@@ -3132,6 +3132,12 @@ HttpSM::tunnel_handler_ua(int event, HttpTunnelConsumer * c)
     break;
   }
 
+  // Zero copy is only turned on for a large cache hit (see
+  // setup_cache_read_transfer), the next transaction on the connection
+  // writes as usual.
+  if (ua_session->get_netvc())
+    ua_session->get_netvc()->set_zero_copy(false);
+
   ink_assert(ua_entry->vc == c->vc);
   if (close_connection) {
     // If the client could be pipelining or is doing a POST, we need to
@@ -5686,6 +5692,14 @@ HttpSM::setup_cache_read_transfer()
 
   HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::tunnel_handler);
 
+  // Large hits go out without a user to kernel copy where the client
+  // connection supports it (plain TCP, no transform on this path).
+  if (t_state.http_config_param->cache_zero_copy_min_size > 0 && doc_size != INT64_MAX &&
+      doc_size >= t_state.http_config_param->cache_zero_copy_min_size && ua_session) {
+    if (ua_session->get_netvc()->set_zero_copy(true))
+      DebugSM("http_cache", "[%" PRId64 "] zero copy send of %" PRId64 " byte cache hit", sm_id, doc_size);
+  }
+
   if (doc_size != INT64_MAX)
     doc_size += hdr_size;
 
@@ -103,21 +103,20 @@ ChunkedHandler::set_max_chunk_size(int64_t size)
 void
 ChunkedHandler::read_size()
 {
-  int64_t bytes_used;
   bool done = false;
 
   while (chunked_reader->read_avail() > 0 && !done) {
-    const char *tmp = chunked_reader->start();
-    int64_t data_size = chunked_reader->block_read_avail();
+    const char *start = chunked_reader->start();
+    const char *end = start + chunked_reader->block_read_avail();
+    const char *tmp = start;
+    const char *lf;
 
-    ink_assert(data_size > 0);
-    bytes_used = 0;
+    ink_assert(end > start);
 
-    while (data_size > 0) {
-      bytes_used++;
+    while (tmp < end && !done) {
       if (state == CHUNK_READ_SIZE) {
         // The http spec says the chunked size is always in hex
-        if (ParseRules::is_hex(*tmp)) {
+        while (tmp < end && ParseRules::is_hex(*tmp)) {
           num_digits++;
           running_sum *= 16;
 
@@ -126,36 +125,46 @@ ChunkedHandler::read_size()
           } else {
             running_sum += ParseRules::ink_tolower(*tmp) - 'a' + 10;
           }
+          tmp++;
+        }
+        if (tmp == end) {
+          break;
+        }
+        // We are done parsing size
+        if (num_digits == 0 || running_sum < 0) {
+          // Bogus chunk size
+          state = CHUNK_READ_ERROR;
+          done = true;
         } else {
-          // We are done parsing size
-          if (num_digits == 0 || running_sum < 0) {
-            // Bogus chunk size
-            state = CHUNK_READ_ERROR;
-            done = true;
-            break;
-          } else {
-            state = CHUNK_READ_SIZE_CRLF;       // now look for CRLF
-          }
+          // now look for the LF, the character we stopped on
+          //   may be it
+          state = CHUNK_READ_SIZE_CRLF;
+        }
+      } else {
+        // Skip the rest of the line (CR, chunk extensions or the
+        //   CRLF ending the previous chunk); memchr() scans a word
+        //   or more at a time where byte-wise matching would not
+        lf = (const char *) memchr(tmp, '\n', end - tmp);
+        if (!lf) {
+          tmp = end;
+          break;
         }
-      } else if (state == CHUNK_READ_SIZE_CRLF) {       // Scan for a linefeed
-        if (ParseRules::is_lf(*tmp)) {
+        tmp = lf + 1;
+
+        if (state == CHUNK_READ_SIZE_CRLF) {
           Debug("http_chunk", "read chunk size of %d bytes", running_sum);
           bytes_left = (cur_chunk_size = running_sum);
           state = (running_sum == 0) ? CHUNK_READ_TRAILER_BLANK : CHUNK_READ_CHUNK;
           done = true;
-          break;
-        }
-      } else if (state == CHUNK_READ_SIZE_START) {
-        if (ParseRules::is_lf(*tmp)) {
+        } else {
+          ink_assert(state == CHUNK_READ_SIZE_START);
           running_sum = 0;
           num_digits = 0;
           state = CHUNK_READ_SIZE;
         }
       }
-      tmp++;
-      data_size--;
     }
-    chunked_reader->consume(bytes_used);
+    chunked_reader->consume(tmp - start);
   }
 }
 
@@ -315,6 +324,23 @@ bool ChunkedHandler::generate_chunked_content()
     state = CHUNK_WRITE_CHUNK;
     Debug("http_chunk", "creating a chunk of size %" PRId64 " bytes", write_val);
 
+    // Small chunks are framed in a local buffer and written with a
+    //   single copy; a block reference to a few bytes costs more than
+    //   the copy and builds up long block chains
+    if (write_val < min_block_transfer_bytes) {
+      char small_chunk[sizeof(tmp) + min_block_transfer_bytes + 2];
+      int len = snprintf(small_chunk, sizeof(tmp), CHUNK_HEADER_FMT, write_val);
+
+      dechunked_reader->memcpy(small_chunk + len, write_val);
+      dechunked_reader->consume(write_val);
+      len += write_val;
+      small_chunk[len++] = '\r';
+      small_chunk[len++] = '\n';
+      chunked_buffer->write(small_chunk, len);
+      chunked_size += len;
+      continue;
+    }
+
     // Output the chunk size.
     if (write_val != max_chunk_size) {
       int len = snprintf(tmp, sizeof(tmp), CHUNK_HEADER_FMT, write_val);
@@ -325,16 +351,7 @@ bool ChunkedHandler::generate_chunked_content()
       chunked_size += max_chunk_header_len;
     }
 
-    // Output the chunk itself.
-    //
-    // BZ# 54395 Note - we really should only do a
-    //   block transfer if there is sizable amount of
-    //   data (like we do for the case where we are
-    //   removing chunked encoding in ChunkedHandler::transfer_bytes()
-    //   However, I want to do this fix with as small a risk
-    //   as possible so I'm leaving this issue alone for
-    //   now
-    //
+    // Output the chunk itself by block reference.
     chunked_buffer->write(dechunked_reader, write_val);
     chunked_size += write_val;
     dechunked_reader->consume(write_val);
@@ -1598,3 +1615,62 @@ HttpTunnel::deallocate_redirect_postdata_buffers()
     postbuf = NULL;
   }
 }
+
+#if TS_HAS_TESTS
+#include "ts/TestBox.h"
+
+// Feed the pieces to a dechunking handler one IOBufferBlock at a time,
+// processing after each, and check the body it produces.
+static void
+test_dechunk(TestBox & box, const char *name, const char *const *pieces, const char *expected)
+{
+  HttpTunnelProducer p;
+  ChunkedHandler ch;
+  MIOBuffer *in = new_empty_MIOBuffer();
+  IOBufferReader *in_reader = in->alloc_reader();
+  IOBufferReader *out;
+  char body[128];
+  int64_t n;
+  bool done = false;
+
+  p.do_dechunking = true;
+  ch.init(in_reader, &p);
+  ch.state = ChunkedHandler::CHUNK_READ_SIZE;
+  out = ch.dechunked_buffer->alloc_reader();
+
+  for (int i = 0; pieces[i]; ++i) {
+    int len = strlen(pieces[i]);
+    IOBufferBlock *b = new_IOBufferBlock();
+
+    box.check(!done, "%s: done before piece %d", name, i);
+    b->alloc(BUFFER_SIZE_INDEX_128);
+    memcpy(b->end(), pieces[i], len);
+    b->fill(len);
+    in->append_block(b);
+    done = ch.process_chunked_content();
+  }
+
+  n = out->read(body, sizeof(body) - 1);
+  body[n] = '\0';
+  box.check(done && ch.state == ChunkedHandler::CHUNK_READ_DONE, "%s: ended in state %d", name, ch.state);
+  box.check(strcmp(body, expected) == 0, "%s: body '%s', expected '%s'", name, body, expected);
+
+  free_MIOBuffer(ch.dechunked_buffer);
+  free_MIOBuffer(in);
+}
+
+REGRESSION_TEST(ChunkedHandler_Dechunk)(RegressionTest * t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  static const char *const crlf[] = { "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n", NULL };
+  static const char *const bare_lf[] = { "5\nhello\n6\n world\n0\n\n", NULL };
+  static const char *const extensions[] = { "5;name=value\r\nhello\r\n6;flag\r\n world\r\n0;last\r\n\r\n", NULL };
+  static const char *const split_size[] = { "1", "0\r\n01234", "56789abcdef\r\n0\r", "\n\r\n", NULL };
+
+  box = REGRESSION_TEST_PASSED;
+  test_dechunk(box, "CRLF", crlf, "hello world");
+  test_dechunk(box, "bare LF", bare_lf, "hello world");
+  test_dechunk(box, "extensions", extensions, "hello world");
+  test_dechunk(box, "split size", split_size, "0123456789abcdef");
+}
+#endif // TS_HAS_TESTS
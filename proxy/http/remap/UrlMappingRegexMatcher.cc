@@ -5,7 +5,7 @@
 #include "UrlMappingRegexMatcher.h"
 
 UrlMappingRegexMatcher::UrlMappingRegexMatcher(url_mapping *mapping) :
-  re(NULL), re_extra(NULL), to_template(NULL), to_template_len(0),
+  re(NULL), re_extra(NULL), pattern(NULL), to_template(NULL), to_template_len(0),
   n_substitutions(0), url_map(mapping)
 {
 }
@@ -17,9 +17,13 @@ UrlMappingRegexMatcher::~UrlMappingRegexMatcher()
     this->re = NULL;
   }
   if (this->re_extra != NULL) {
-    pcre_free(this->re_extra);
+    ink_pcre_free_study(this->re_extra);
     this->re_extra = NULL;
   }
+  if (this->pattern != NULL) {
+    ats_free(this->pattern);
+    this->pattern = NULL;
+  }
   if (this->to_template != NULL) {
     ats_free(this->to_template);
     this->to_template = NULL;
@@ -65,7 +69,7 @@ UrlMappingRegexMatcher::init(const char *pattern, const char *to_str, const int
     return false;
   }
 
-  this->re_extra = pcre_study(this->re, 0, &str);
+  this->re_extra = ink_pcre_study(this->re, &str);
   if ((this->re_extra == NULL) && (str != NULL)) {
     Warning("pcre_study failed with message [%s]", str);
     return false;
@@ -105,6 +109,7 @@ UrlMappingRegexMatcher::init(const char *pattern, const char *to_str, const int
   }
 
   if (result) {
+    this->pattern = ats_strdup(pattern);
     this->to_template_len = to_len;
     this->to_template = static_cast<char *>(ats_malloc(this->to_template_len));
     memcpy(this->to_template, to_str, this->to_template_len);
@@ -16,6 +16,10 @@ class UrlMappingRegexMatcher
       return this->url_map;
     }
 
+    inline const char *getPattern() const {
+      return this->pattern;
+    }
+
     bool init(const char *pattern, const char *to_str, const int to_len);
 
     int match(const char *input, const int input_len,
@@ -29,6 +33,7 @@ class UrlMappingRegexMatcher
 
     pcre *re;
     pcre_extra *re_extra;
+    char *pattern;
 
     // we store the host-string-to-substitute here; if a match is found,
     // the substitutions are made and the resulting url is stored
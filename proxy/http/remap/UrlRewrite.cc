@@ -1296,6 +1296,12 @@ UrlRewrite::BuildTable()
     }
   }
 
+  _buildHostRegexSet(forward_mappings);
+  _buildHostRegexSet(reverse_mappings);
+  _buildHostRegexSet(permanent_redirects);
+  _buildHostRegexSet(temporary_redirects);
+  _buildHostRegexSet(forward_mappings_with_recv_port);
+
   // Destroy unused tables
   if (num_rules_forward == 0) {
     forward_mappings.hash_lookup = ink_hash_table_destroy(forward_mappings.hash_lookup);
@@ -1561,7 +1567,7 @@ UrlRewrite::_mappingLookup(MappingsStore &mappings, URL *request_url,
 
   if (!mappings.regex_list.empty() && (rank_ceiling < 0 ||
         rank_ceiling > mappings.regex_list_min_rank) &&
-      _regexMappingLookup(mappings.regex_list, request_url, request_port,
+      _regexMappingLookup(mappings.regex_list, mappings.host_regex_set, request_url, request_port,
         request_host_lower, request_host_len, rank_ceiling,
         mapping_container))
   {
@@ -1664,7 +1670,8 @@ UrlRewrite::_suffixMappingLookup(HostnameTrie<SuffixMappings> *suffix_trie,
 }
 
 bool
-UrlRewrite::_regexMappingLookup(UrlMappingRegexList &regex_mappings, URL *request_url, int request_port,
+UrlRewrite::_regexMappingLookup(UrlMappingRegexList &regex_mappings, const DFA *host_regex_set,
+                                URL *request_url, int request_port,
                                 const char *request_host, int request_host_len, int rank_ceiling,
                                 UrlMappingContainer &mapping_container)
 {
@@ -1699,6 +1706,9 @@ UrlRewrite::_regexMappingLookup(UrlMappingRegexList &regex_mappings, URL *reques
   int new_url_len;
   int match_result;
   int query_len = -1;
+  int host_index = -1;          //position among the host regexes
+  int host_set_match = -1;      //first host regex the set matched
+  bool host_set_tried = false;
 
   // Loop over the entire linked list, or until we're satisfied
   forl_LL(UrlMappingRegexMatcher, list_iter, regex_mappings) {
@@ -1709,6 +1719,10 @@ UrlRewrite::_regexMappingLookup(UrlMappingRegexList &regex_mappings, URL *reques
       break;
     }
 
+    if (mapping->regex_type == REGEX_TYPE_HOST) {
+      ++host_index;
+    }
+
     reg_map_scheme = mapping->fromURL.scheme_get(&reg_map_scheme_len);
     if ((request_scheme_len != reg_map_scheme_len) ||
         strncmp(request_scheme, reg_map_scheme, request_scheme_len)) {
@@ -1739,6 +1753,26 @@ UrlRewrite::_regexMappingLookup(UrlMappingRegexList &regex_mappings, URL *reques
         continue;
       }
 
+      // One pass over all the host regexes tells which is the first that
+      // can match; only that one (for the substitutions) and those after
+      // it, if it is not taken, need to be run on their own. If the pass
+      // fails, e.g. on the PCRE match limit, every one is run in turn.
+      if (host_regex_set != NULL) {
+        if (!host_set_tried) {
+          host_set_tried = true;
+          host_set_match = host_regex_set->match(request_host, request_host_len);
+          Debug("url_rewrite_regex", "Request URL host [%.*s] first matches host regex %d",
+              request_host_len, request_host, host_set_match);
+          if (host_set_match == DFA_MATCH_ERROR) {
+            Debug("url_rewrite_regex", "Host regex set failed on [%.*s], trying each host regex in turn",
+                request_host_len, request_host);
+          }
+        }
+        if (host_set_match != DFA_MATCH_ERROR && (host_set_match < 0 || host_index < host_set_match)) {
+          continue;
+        }
+      }
+
       if ((match_result=list_iter->match(request_host, request_host_len, new_host,
               sizeof(new_host), &new_host_len)) > 0)
       {
@@ -1827,6 +1861,40 @@ UrlRewrite::_regexMappingLookup(UrlMappingRegexList &regex_mappings, URL *reques
   return retval;
 }
 
+/** Compiles the host regexes of a store's regex list, in list order, into
+    one DFA so a lookup can find the first host regex that matches with a
+    single pass instead of trying them one by one.
+*/
+void
+UrlRewrite::_buildHostRegexSet(MappingsStore &store)
+{
+  int count = 0;
+
+  forl_LL(UrlMappingRegexMatcher, list_iter, store.regex_list) {
+    if (list_iter->getMapping()->regex_type == REGEX_TYPE_HOST) {
+      ++count;
+    }
+  }
+
+  if (count < 2) {
+    return;
+  }
+
+  const char **patterns = static_cast<const char **>(ats_malloc(count * sizeof(const char *)));
+  int i = 0;
+
+  forl_LL(UrlMappingRegexMatcher, list_iter, store.regex_list) {
+    if (list_iter->getMapping()->regex_type == REGEX_TYPE_HOST) {
+      patterns[i++] = list_iter->getPattern();
+    }
+  }
+
+  store.host_regex_set = NEW(new DFA);
+  store.host_regex_set->compile(patterns, count, RE_UNANCHORED);
+  ats_free(patterns);
+  Debug("url_rewrite_regex", "Compiled %d host regexes into one set", count);
+}
+
 void
 UrlRewrite::_destroyList(UrlMappingRegexList &mappings)
 {
@@ -93,10 +93,11 @@ public:
     InkHashTable *hash_lookup; //key format is hostname:port:scheme
     HostnameTrie<SuffixMappings> *suffix_trie;  //key format is hostname:port:scheme
     UrlMappingRegexList regex_list;
+    DFA *host_regex_set;  //all host regexes of regex_list, in order
     int suffix_trie_min_rank;
     int regex_list_min_rank;
 
-    MappingsStore() : hash_lookup(NULL), suffix_trie(NULL),
+    MappingsStore() : hash_lookup(NULL), suffix_trie(NULL), host_regex_set(NULL),
       suffix_trie_min_rank(-1), regex_list_min_rank(-1)
     {
     }
@@ -116,6 +117,8 @@ public:
   {
     _destroyTable(store.hash_lookup);
     _destroyList(store.regex_list);
+    delete store.host_regex_set;
+    store.host_regex_set = NULL;
 
     if (store.suffix_trie != NULL) {
       int count;
@@ -209,11 +212,13 @@ private:
     UrlMappingContainer &mapping_container);
 
 
-  bool _regexMappingLookup(UrlMappingRegexList &regex_mappings,
+  bool _regexMappingLookup(UrlMappingRegexList &regex_mappings, const DFA *host_regex_set,
       URL * request_url, int request_port, const char *request_host,
       int request_host_len, int rank_ceiling,
       UrlMappingContainer &mapping_container);
 
+  void _buildHostRegexSet(MappingsStore &store);
+
   bool _processUrlMappingHostRegex(const char *from_host_lower,
       UrlMappingRegexMatcher *reg_map);
 